@@ -5,12 +5,12 @@
 
 // DDS
 #include "CommanderChannel.h"
+#include "Compression.h"
 #include "ConditionEvent.h"
 #include "EnvProp.h"
 #include "UserDefaults.h"
 #include "Version.h"
 // BOOST
-#include <boost/bind/bind.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/process.hpp>
 
@@ -53,8 +53,16 @@ CCommanderChannel::CCommanderChannel(boost::asio::io_context& _service,
         [this](const SSenderInfo& _sender, SCommandAttachmentImpl<cmdUPDATE_KEY>::ptr_t _attachment)
         { send_cmdUPDATE_KEY(_sender, _attachment); });
 
+    m_intercomChannel->registerHandler<cmdSUBSCRIBE_ON_TASK_DONE>(
+        [this](const SSenderInfo& _sender, SCommandAttachmentImpl<cmdSUBSCRIBE_ON_TASK_DONE>::ptr_t /*_attachment*/)
+        { setTaskDoneSubscription(_sender.m_ID, true); });
+
     m_intercomChannel->start();
 
+    // After a reconnect the commander has to learn the subscription again
+    registerHandler<EChannelEvents::OnHandshakeOK>(
+        [this](const SSenderInfo& /*_sender*/) { syncTaskDoneSubscription(true); });
+
     registerHandler<EChannelEvents::OnRemoteEndDissconnected>(
         [this](const SSenderInfo& /*_sender*/)
         {
@@ -204,6 +212,22 @@ bool CCommanderChannel::on_cmdSIMPLE_MSG(SCommandAttachmentImpl<cmdSIMPLE_MSG>::
             m_intercomChannel->pushMsg<cmdSIMPLE_MSG>(*_attachment, _sender.m_ID, _sender.m_ID);
             return true;
         }
+        case cmdGET_LOG:
+        case cmdASSIGN_USER_TASK:
+        case cmdCHECK_CACHED_FILES:
+        {
+            // A binary attachment failed to be sent or received. The commander waits for the reply.
+            if (_attachment->m_msgSeverity == error)
+            {
+                LOG(error) << _attachment->m_sMsg;
+                pushMsg<cmdREPLY>(SReplyCmd(_attachment->m_sMsg,
+                                            (uint16_t)SReplyCmd::EStatusCode::ERROR,
+                                            0,
+                                            _attachment->m_srcCommand),
+                                  _sender.m_ID);
+            }
+            return true;
+        }
 
         default:
             LOG(debug) << "Received command cmdSIMPLE_MSG does not have a listener";
@@ -314,6 +338,42 @@ bool CCommanderChannel::on_cmdBINARY_ATTACHMENT_RECEIVED(
                               _sender.m_ID);
             return true;
         }
+        case cmdCHECK_CACHED_FILES:
+        {
+            // The file is named by its content hash. Check the content before other slots are linked to it.
+            const string& hash{ _attachment->m_requestedFileName };
+            try
+            {
+                if (!SSharedBinaryAttachment::isContentHash(hash))
+                    throw runtime_error("Invalid content hash of the received file: " + hash);
+                if (SSharedBinaryAttachment::fileContentHash(_attachment->m_receivedFilePath) != hash)
+                    throw runtime_error("Content hash mismatch of the received file " + hash);
+
+                fs::path destFilePath(CUserDefaults::instance().getFileCacheDir());
+                fs::create_directories(destFilePath);
+                destFilePath /= hash;
+                fs::rename(_attachment->m_receivedFilePath, destFilePath);
+                // Links to the file share its permissions. Tasks can execute it but can't modify the cache through
+                // the link.
+                fs::permissions(destFilePath,
+                                fs::owner_read | fs::owner_exe | fs::group_read | fs::group_exe | fs::others_read |
+                                    fs::others_exe);
+                LOG(info) << "Received file to cache: " << destFilePath.generic_string();
+            }
+            catch (exception& _e)
+            {
+                LOG(error) << "Failed to cache file: " << _e.what();
+                boost::system::error_code ec;
+                fs::remove(_attachment->m_receivedFilePath, ec);
+                pushMsg<cmdREPLY>(
+                    SReplyCmd(_e.what(), (uint16_t)SReplyCmd::EStatusCode::ERROR, 0, cmdCHECK_CACHED_FILES));
+                return true;
+            }
+
+            pushMsg<cmdREPLY>(
+                SReplyCmd("File cached: " + hash, (uint16_t)SReplyCmd::EStatusCode::OK, 0, cmdCHECK_CACHED_FILES));
+            return true;
+        }
         case cmdUPDATE_TOPOLOGY:
         {
             // Copy topology file
@@ -325,13 +385,11 @@ bool CCommanderChannel::on_cmdBINARY_ATTACHMENT_RECEIVED(
             // Decompressing the topology file
             if (destFilePath.extension() == ".gz")
             {
-                const fs::path gzipPath{ bp::search_path("gzip") };
-                stringstream ssCmd;
-                ssCmd << gzipPath.string() << " -df " << destFilePath;
-                string output;
-                execute(ssCmd.str(), chrono::seconds(60), &output);
                 // remove ".gz" extension
-                destFilePath = destFilePath.stem();
+                const fs::path compressedFilePath(destFilePath);
+                destFilePath.replace_extension();
+                uncompressFile(compressedFilePath.string(), destFilePath.string());
+                fs::remove(compressedFilePath);
             }
 
             // Activating new topology
@@ -463,7 +521,87 @@ bool CCommanderChannel::on_cmdASSIGN_USER_TASK(SCommandAttachmentImpl<cmdASSIGN_
                                                SSenderInfo& _sender)
 {
     LOG(info) << "Received a user task assignment. " << *_attachment;
+    pushMsg<cmdREPLY>(assignUserTask(*_attachment, _sender.m_ID), _sender.m_ID);
+    return true;
+}
 
+bool CCommanderChannel::on_cmdASSIGN_USER_TASKS(SCommandAttachmentImpl<cmdASSIGN_USER_TASKS>::ptr_t _attachment,
+                                                SSenderInfo& _sender)
+{
+    LOG(info) << "Received user task assignments for " << _attachment->m_slots.size() << " slots.";
+
+    // Assign and activate the task of each slot, the commander gets the status of all slots in one reply
+    SSlotRepliesCmd replies;
+    replies.m_slots.reserve(_attachment->m_slots.size());
+    for (const auto& slot : _attachment->m_slots)
+    {
+        LOG(info) << "User task assignment of slot " << slot.m_slotID << ". " << slot.m_assignment;
+        SReplyCmd reply{ assignUserTask(slot.m_assignment, slot.m_slotID) };
+        if (SReplyCmd::EStatusCode(reply.m_statusCode) == SReplyCmd::EStatusCode::OK)
+            reply = activateUserTask(slot.m_slotID);
+        replies.m_slots.push_back({ slot.m_slotID, reply });
+    }
+
+    pushMsg<cmdREPLY_ASSIGN_USER_TASKS>(replies, _sender.m_ID);
+    return true;
+}
+
+bool CCommanderChannel::on_cmdCHECK_CACHED_FILES(SCommandAttachmentImpl<cmdCHECK_CACHED_FILES>::ptr_t _attachment,
+                                                 SSenderInfo& _sender)
+{
+    // Reply with the hashes which must be uploaded
+    const fs::path cacheDir(CUserDefaults::instance().getFileCacheDir());
+    SCachedFilesCmd missing;
+    for (const auto& hash : _attachment->m_hashes)
+    {
+        // Slots of an invalid hash fail when it's linked
+        if (!SSharedBinaryAttachment::isContentHash(hash))
+        {
+            LOG(error) << "Invalid content hash of a cached file: " << hash;
+            continue;
+        }
+        if (!fs::exists(cacheDir / hash))
+            missing.m_hashes.push_back(hash);
+    }
+    LOG(info) << "Cached files requested: " << _attachment->m_hashes.size() << ", missing: " << missing.m_hashes.size();
+
+    pushMsg<cmdREPLY_CHECK_CACHED_FILES>(missing, _sender.m_ID);
+    return true;
+}
+
+void CCommanderChannel::linkCachedFiles(const SAssignUserTaskCmd& _assignment, uint64_t _slotID) const
+{
+    if (_assignment.m_cachedFileHashes.size() != _assignment.m_cachedFileNames.size())
+        throw runtime_error("Inconsistent list of cached files");
+
+    const fs::path cacheDir(CUserDefaults::instance().getFileCacheDir());
+    fs::path slotDir(CUserDefaults::instance().getSlotsRootDir());
+    slotDir /= to_string(_slotID);
+    for (size_t i = 0; i < _assignment.m_cachedFileHashes.size(); ++i)
+    {
+        if (!SSharedBinaryAttachment::isContentHash(_assignment.m_cachedFileHashes[i]))
+            throw runtime_error("Invalid content hash of a cached file: " + _assignment.m_cachedFileHashes[i]);
+        const fs::path srcFilePath(cacheDir / _assignment.m_cachedFileHashes[i]);
+        const fs::path destFilePath(slotDir / _assignment.m_cachedFileNames[i]);
+        if (!fs::exists(srcFilePath))
+            throw runtime_error("File is missing in the cache: " + srcFilePath.generic_string());
+
+        // The slot might keep the file of a previous topology
+        fs::remove(destFilePath);
+        boost::system::error_code ec;
+        fs::create_hard_link(srcFilePath, destFilePath, ec);
+        if (ec)
+        {
+            LOG(debug) << "Copying cached file, it can't be linked: " << ec.message();
+            fs::copy_file(srcFilePath, destFilePath);
+            fs::permissions(destFilePath, fs::add_perms | fs::owner_exe);
+        }
+        LOG(info) << "Linked cached user executable to execute: " << destFilePath.generic_string();
+    }
+}
+
+SReplyCmd CCommanderChannel::assignUserTask(const SAssignUserTaskCmd& _assignment, uint64_t _slotID)
+{
     // Check that topology is the same before task assignment
     try
     {
@@ -472,53 +610,57 @@ bool CCommanderChannel::on_cmdASSIGN_USER_TASK(SCommandAttachmentImpl<cmdASSIGN_
             lock_guard<mutex> lock(m_topoMutex);
             topoHash = m_topo->getHash();
         }
-        if (topoHash != _attachment->m_topoHash)
+        if (topoHash != _assignment.m_topoHash)
         {
             stringstream ss;
-            ss << "Topology hash check failed: " << topoHash << " (must be " << _attachment->m_topoHash << ")";
+            ss << "Topology hash check failed: " << topoHash << " (must be " << _assignment.m_topoHash << ")";
             throw runtime_error(ss.str());
         }
     }
     catch (exception& _e)
     {
-        pushMsg<cmdREPLY>(SReplyCmd(_e.what(), (uint16_t)SReplyCmd::EStatusCode::ERROR, 0, cmdASSIGN_USER_TASK),
-                          _sender.m_ID);
         LOG(error) << "Assign task error: " << _e.what();
-        return true;
+        return SReplyCmd(_e.what(), (uint16_t)SReplyCmd::EStatusCode::ERROR, 0, cmdASSIGN_USER_TASK);
     }
 
     SSlotInfo::SSlotInfoPtr_t slot;
     try
     {
-        slot = getSlotInfoById(_sender.m_ID);
+        slot = getSlotInfoById(_slotID);
     }
     catch (exception& _e)
     {
-        pushMsg<cmdREPLY>(SReplyCmd(_e.what(), (uint16_t)SReplyCmd::EStatusCode::ERROR, 0, cmdASSIGN_USER_TASK),
-                          _sender.m_ID);
         LOG(error) << "Assign task error: " << _e.what();
-        return true;
+        return SReplyCmd(_e.what(), (uint16_t)SReplyCmd::EStatusCode::ERROR, 0, cmdASSIGN_USER_TASK);
     }
 
     if (slot->m_taskID > 0)
     {
         stringstream ssError;
-        ssError << "Assign task error: The slot " << _sender.m_ID << " already running task with id " << slot->m_taskID;
-        pushMsg<cmdREPLY>(SReplyCmd(ssError.str(), (uint16_t)SReplyCmd::EStatusCode::ERROR, 0, cmdASSIGN_USER_TASK),
-                          _sender.m_ID);
+        ssError << "Assign task error: The slot " << _slotID << " already running task with id " << slot->m_taskID;
         LOG(error) << ssError.str();
-        return true;
+        return SReplyCmd(ssError.str(), (uint16_t)SReplyCmd::EStatusCode::ERROR, 0, cmdASSIGN_USER_TASK);
     }
 
-    slot->m_sUsrExe = _attachment->m_sExeFile;
-    slot->m_sUsrEnv = _attachment->m_sEnvFile;
-    slot->m_taskID = _attachment->m_taskID;
-    slot->m_taskIndex = _attachment->m_taskIndex;
-    slot->m_collectionIndex = _attachment->m_collectionIndex;
-    slot->m_taskPath = _attachment->m_taskPath;
-    slot->m_groupName = _attachment->m_groupName;
-    slot->m_collectionName = _attachment->m_collectionName;
-    slot->m_taskName = _attachment->m_taskName;
+    try
+    {
+        linkCachedFiles(_assignment, _slotID);
+    }
+    catch (exception& _e)
+    {
+        LOG(error) << "Assign task error: " << _e.what();
+        return SReplyCmd(_e.what(), (uint16_t)SReplyCmd::EStatusCode::ERROR, 0, cmdASSIGN_USER_TASK);
+    }
+
+    slot->m_sUsrExe = _assignment.m_sExeFile;
+    slot->m_sUsrEnv = _assignment.m_sEnvFile;
+    slot->m_taskID = _assignment.m_taskID;
+    slot->m_taskIndex = _assignment.m_taskIndex;
+    slot->m_collectionIndex = _assignment.m_collectionIndex;
+    slot->m_taskPath = _assignment.m_taskPath;
+    slot->m_groupName = _assignment.m_groupName;
+    slot->m_collectionName = _assignment.m_collectionName;
+    slot->m_taskName = _assignment.m_taskName;
 
     {
         lock_guard<mutex> lock(m_taskIDToSlotIDMapMutex);
@@ -532,7 +674,7 @@ bool CCommanderChannel::on_cmdASSIGN_USER_TASK(SCommandAttachmentImpl<cmdASSIGN_
 
     // If the user task was transferred, than replace "%DDS_DEFAULT_TASK_PATH%" with the real path
     fs::path dir(CUserDefaults::instance().getSlotsRootDir());
-    dir /= to_string(_sender.m_ID);
+    dir /= to_string(_slotID);
     dir += fs::path::preferred_separator;
     ba::replace_all(slot->m_sUsrExe, "%DDS_DEFAULT_TASK_PATH%", dir.generic_string());
     // If the user custom environment was transferred, than replace "%DDS_DEFAULT_TASK_PATH%" with the real path
@@ -541,9 +683,6 @@ bool CCommanderChannel::on_cmdASSIGN_USER_TASK(SCommandAttachmentImpl<cmdASSIGN_
     // Revoke drain of the write queue to start accept messages
     m_intercomChannel->drainWriteQueue(false, slot->m_id);
 
-    pushMsg<cmdREPLY>(SReplyCmd("User task assigned", (uint16_t)SReplyCmd::EStatusCode::OK, 0, cmdASSIGN_USER_TASK),
-                      _sender.m_ID);
-
     // Creating task assets, if needed
     CTopoTask::Ptr_t task;
     {
@@ -591,28 +730,31 @@ bool CCommanderChannel::on_cmdASSIGN_USER_TASK(SCommandAttachmentImpl<cmdASSIGN_
         f.flush();
     }
 
-    return true;
+    return SReplyCmd("User task assigned", (uint16_t)SReplyCmd::EStatusCode::OK, 0, cmdASSIGN_USER_TASK);
 }
 
 bool CCommanderChannel::on_cmdACTIVATE_USER_TASK(SCommandAttachmentImpl<cmdACTIVATE_USER_TASK>::ptr_t _attachment,
                                                  SSenderInfo& _sender)
 {
+    pushMsg<cmdREPLY>(activateUserTask(_attachment->m_id), _sender.m_ID);
+    return true;
+}
 
+SReplyCmd CCommanderChannel::activateUserTask(uint64_t _slotID)
+{
     SSlotInfo::SSlotInfoPtr_t slot;
     try
     {
-        slot = getSlotInfoById(_attachment->m_id);
+        slot = getSlotInfoById(_slotID);
     }
     catch (exception& _e)
     {
         LOG(error) << "Received activation command. Wrong slot ID.";
         // Send response back to server
-        pushMsg<cmdREPLY>(SReplyCmd("Received activation command. Wrong slot ID.",
-                                    (uint16_t)SReplyCmd::EStatusCode::ERROR,
-                                    0,
-                                    cmdACTIVATE_USER_TASK),
-                          _sender.m_ID);
-        return true;
+        return SReplyCmd("Received activation command. Wrong slot ID.",
+                         (uint16_t)SReplyCmd::EStatusCode::ERROR,
+                         0,
+                         cmdACTIVATE_USER_TASK);
     }
 
     const string sUsrExe(slot->m_sUsrExe);
@@ -621,12 +763,10 @@ bool CCommanderChannel::on_cmdACTIVATE_USER_TASK(SCommandAttachmentImpl<cmdACTIV
     {
         LOG(info) << "Received activation command. Ignoring the command, since no task is assigned.";
         // Send response back to server
-        pushMsg<cmdREPLY>(SReplyCmd("No task is assigned. Activation is ignored.",
-                                    (uint16_t)SReplyCmd::EStatusCode::OK,
-                                    0,
-                                    cmdACTIVATE_USER_TASK),
-                          _sender.m_ID);
-        return true;
+        return SReplyCmd("No task is assigned. Activation is ignored.",
+                         (uint16_t)SReplyCmd::EStatusCode::OK,
+                         0,
+                         cmdACTIVATE_USER_TASK);
     }
 
     StringVector_t params;
@@ -671,7 +811,7 @@ bool CCommanderChannel::on_cmdACTIVATE_USER_TASK(SCommandAttachmentImpl<cmdACTIV
         const string sTaskStdErr(ssTaskOutput.str() + "_err.log");
 
         fs::path pathSlotDir(CUserDefaults::instance().getSlotsRootDir());
-        pathSlotDir /= to_string(_sender.m_ID);
+        pathSlotDir /= to_string(_slotID);
         const fs::path pathTaskWrapperIn("dds_user_task_wrapper.sh.in");
         const fs::path pathTaskWrapper(pathSlotDir / "dds_user_task_wrapper.sh");
 
@@ -714,9 +854,7 @@ bool CCommanderChannel::on_cmdACTIVATE_USER_TASK(SCommandAttachmentImpl<cmdACTIV
     {
         LOG(error) << _e.what();
         // Send response back to server
-        pushMsg<cmdREPLY>(SReplyCmd(_e.what(), (uint16_t)SReplyCmd::EStatusCode::ERROR, 0, cmdACTIVATE_USER_TASK),
-                          _sender.m_ID);
-        return true;
+        return SReplyCmd(_e.what(), (uint16_t)SReplyCmd::EStatusCode::ERROR, 0, cmdACTIVATE_USER_TASK);
     }
 
     stringstream ss;
@@ -726,10 +864,7 @@ bool CCommanderChannel::on_cmdACTIVATE_USER_TASK(SCommandAttachmentImpl<cmdACTIV
     onNewUserTask(slot->m_id, pidUsrTask);
 
     // Send response back to server
-    pushMsg<cmdREPLY>(SReplyCmd(ss.str(), (uint16_t)SReplyCmd::EStatusCode::OK, 0, cmdACTIVATE_USER_TASK),
-                      _sender.m_ID);
-
-    return true;
+    return SReplyCmd(ss.str(), (uint16_t)SReplyCmd::EStatusCode::OK, 0, cmdACTIVATE_USER_TASK);
 }
 
 bool CCommanderChannel::on_cmdSTOP_USER_TASK(SCommandAttachmentImpl<cmdSTOP_USER_TASK>::ptr_t /*_attachment*/,
@@ -1153,6 +1288,7 @@ void CCommanderChannel::taskExited(uint64_t _slotID, int _exitCode)
         // reset slot info
         slot->m_pid = 0;
         slot->m_taskID = 0;
+        setTaskDoneSubscription(_slotID, false);
 
         // Draining the Intercom write queue
         m_intercomChannel->drainWriteQueue(true, _slotID);
@@ -1167,6 +1303,57 @@ void CCommanderChannel::taskExited(uint64_t _slotID, int _exitCode)
     }
 }
 
+void CCommanderChannel::setTaskDoneSubscription(uint64_t _slotID, bool _subscribe)
+{
+    bool notifyCommander{ false };
+    {
+        lock_guard<mutex> lock(m_mutexSlots);
+        auto it = m_slots.find(_slotID);
+        if (it == m_slots.end() || it->second->m_isTaskDoneSubscribed == _subscribe)
+            return;
+
+        it->second->m_isTaskDoneSubscribed = _subscribe;
+        if (_subscribe)
+        {
+            LOG(info) << "Task of slot " << _slotID << " subscribed on task done events";
+            notifyCommander = (++m_nofTaskDoneSubscribers == 1);
+        }
+        else
+        {
+            notifyCommander = (--m_nofTaskDoneSubscribers == 0);
+        }
+    }
+
+    // Don't lock the container on msg push
+    if (notifyCommander)
+        syncTaskDoneSubscription();
+}
+
+void CCommanderChannel::syncTaskDoneSubscription(bool _isReconnected)
+{
+    // Older commanders send task done events to all agents anyway
+    if (!isTaskDoneSubscriptionSupported())
+        return;
+
+    // Concurrent calls might have decided in a different order, thus the current subscription is sent
+    lock_guard<mutex> lock(m_mutexTaskDoneSubscription);
+    if (_isReconnected)
+        m_isCommanderSubscribed = false;
+    bool isSubscribed{ false };
+    {
+        lock_guard<mutex> lockSlots(m_mutexSlots);
+        isSubscribed = (m_nofTaskDoneSubscribers > 0);
+    }
+    if (isSubscribed == m_isCommanderSubscribed)
+        return;
+
+    m_isCommanderSubscribed = isSubscribed;
+    if (isSubscribed)
+        pushMsg<cmdSUBSCRIBE_ON_TASK_DONE>();
+    else
+        pushMsg<cmdUNSUBSCRIBE_ON_TASK_DONE>();
+}
+
 dds::agent_cmd::SSlotInfo::SSlotInfoPtr_t CCommanderChannel::getSlotInfoById(const slotId_t& _slotID)
 {
     lock_guard<mutex> lock(m_mutexSlots);
@@ -1324,15 +1511,16 @@ bool CCommanderChannel::on_cmdUSER_TASK_DONE(SCommandAttachmentImpl<cmdUSER_TASK
 {
     LOG(debug) << "Received user task done: " << *_attachment;
 
-    // Forward message to user task
+    // Forward message to user tasks, which subscribed on it
     // WORKAROUND: to prevent locking the container on msg push, we create a tmp container with slot IDs
     vector<slotId_t> slotsTmp;
     {
         lock_guard<mutex> lock(m_mutexSlots);
-        transform(m_slots.begin(),
-                  m_slots.end(),
-                  back_inserter(slotsTmp),
-                  boost::bind(&SSlotInfo::container_t::value_type::first, boost::placeholders::_1));
+        for (const auto& slot : m_slots)
+        {
+            if (slot.second->m_isTaskDoneSubscribed)
+                slotsTmp.push_back(slot.first);
+        }
     }
 
     for (const auto& i : slotsTmp)
@@ -36,6 +36,7 @@ namespace dds
             std::string m_taskName;
             pid_t m_pid{ 0 };
             assets_t m_taskAssets;
+            bool m_isTaskDoneSubscribed{ false }; ///< The task of the slot subscribed on cmdUSER_TASK_DONE
         };
 
         class CCommanderChannel : public protocol_api::CClientChannelImpl<CCommanderChannel>
@@ -65,6 +66,8 @@ namespace dds
                 MESSAGE_HANDLER(cmdGET_LOG, on_cmdGET_LOG)
                 MESSAGE_HANDLER(cmdASSIGN_USER_TASK, on_cmdASSIGN_USER_TASK)
                 MESSAGE_HANDLER(cmdACTIVATE_USER_TASK, on_cmdACTIVATE_USER_TASK)
+                MESSAGE_HANDLER(cmdASSIGN_USER_TASKS, on_cmdASSIGN_USER_TASKS)
+                MESSAGE_HANDLER(cmdCHECK_CACHED_FILES, on_cmdCHECK_CACHED_FILES)
                 MESSAGE_HANDLER(cmdSTOP_USER_TASK, on_cmdSTOP_USER_TASK)
                 MESSAGE_HANDLER(cmdUPDATE_KEY, on_cmdUPDATE_KEY)
                 MESSAGE_HANDLER(cmdCUSTOM_CMD, on_cmdCUSTOM_CMD)
@@ -103,6 +106,12 @@ namespace dds
             bool on_cmdACTIVATE_USER_TASK(
                 protocol_api::SCommandAttachmentImpl<protocol_api::cmdACTIVATE_USER_TASK>::ptr_t _attachment,
                 protocol_api::SSenderInfo& _sender);
+            bool on_cmdASSIGN_USER_TASKS(
+                protocol_api::SCommandAttachmentImpl<protocol_api::cmdASSIGN_USER_TASKS>::ptr_t _attachment,
+                protocol_api::SSenderInfo& _sender);
+            bool on_cmdCHECK_CACHED_FILES(
+                protocol_api::SCommandAttachmentImpl<protocol_api::cmdCHECK_CACHED_FILES>::ptr_t _attachment,
+                protocol_api::SSenderInfo& _sender);
             bool on_cmdSTOP_USER_TASK(
                 protocol_api::SCommandAttachmentImpl<protocol_api::cmdSTOP_USER_TASK>::ptr_t _attachment,
                 protocol_api::SSenderInfo& _sender);
@@ -124,6 +133,21 @@ namespace dds
             void createAgentIDFile() const;
             void deleteAgentIDFile() const;
             void onNewUserTask(uint64_t _slotID, pid_t _pid);
+            /// Subscribes or unsubscribes the task of the slot on cmdUSER_TASK_DONE. The commander is notified once the
+            /// first slot subscribes and once no slot is subscribed anymore.
+            void setTaskDoneSubscription(uint64_t _slotID, bool _subscribe);
+            /// Sends cmdSUBSCRIBE_ON_TASK_DONE or cmdUNSUBSCRIBE_ON_TASK_DONE if the commander doesn't know the current
+            /// subscription. Must be called without m_mutexSlots.
+            /// \param _isReconnected The commander has forgotten the subscription after a reconnect.
+            void syncTaskDoneSubscription(bool _isReconnected = false);
+            /// Assigns the user task to the slot. Returns the reply to the commander.
+            protocol_api::SReplyCmd assignUserTask(const protocol_api::SAssignUserTaskCmd& _assignment,
+                                                   uint64_t _slotID);
+            /// Starts the user task assigned to the slot. Returns the reply to the commander.
+            protocol_api::SReplyCmd activateUserTask(uint64_t _slotID);
+            /// Links the files of the assignment from the file cache into the slot directory.
+            /// Falls back to a copy if a hard link can't be created.
+            void linkCachedFiles(const protocol_api::SAssignUserTaskCmd& _assignment, uint64_t _slotID) const;
             /// Terminate child and grandchild process of the given parent pid.
             /// The function first sends a graceful SIGTERM to all children. After a defined timeout (5 sec) an
             /// unconditional SIGKILL is sent.
@@ -154,6 +178,9 @@ namespace dds
 
             std::mutex m_mutexSlots;
             SSlotInfo::container_t m_slots;
+            size_t m_nofTaskDoneSubscribers{ 0 }; ///< Number of slots subscribed on cmdUSER_TASK_DONE
+            std::mutex m_mutexTaskDoneSubscription; ///< Keeps the order of subscription messages
+            bool m_isCommanderSubscribed{ false };  ///< The commander sends us cmdUSER_TASK_DONE events
             uint32_t m_nSlots{ 0 };
             std::mutex m_mutexGlobalAssets;
             assets_t m_globalAssets;
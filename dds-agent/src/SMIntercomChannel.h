@@ -29,6 +29,7 @@ namespace dds
             SM_MESSAGE_HANDLER_DISPATCH(cmdUPDATE_KEY)
             SM_MESSAGE_HANDLER_DISPATCH(cmdSIMPLE_MSG)
             SM_MESSAGE_HANDLER_DISPATCH(cmdUSER_TASK_DONE)
+            SM_MESSAGE_HANDLER_DISPATCH(cmdSUBSCRIBE_ON_TASK_DONE)
         END_SM_MSG_MAP()
     };
 } // namespace dds
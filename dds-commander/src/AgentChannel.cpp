@@ -36,8 +36,7 @@ CAgentChannel::CAgentChannel(boost::asio::io_context& _context, uint64_t /*_prot
                 break;
                 case EChannelType::UI:
                 {
-                    LOG(info) << "The UI agent [" << socket().remote_endpoint().address().to_string()
-                              << "] has successfully connected.";
+                    LOG(info) << "The UI agent [" << remoteAddress() << "] has successfully connected.";
 
                     // All UI channels get unique IDs, so that user tasks and agents can send
                     // back the
@@ -57,6 +56,34 @@ SAgentInfo& CAgentChannel::getAgentInfo()
     return m_info;
 }
 
+SChannelKeys CAgentChannel::getChannelKeys(uint64_t _protocolHeaderID, bool _isSlot)
+{
+    SChannelKeys keys;
+    if (getChannelType() != EChannelType::AGENT)
+        return keys;
+
+    keys.m_agentID = m_info.m_id;
+    keys.m_host = m_info.m_remoteHostInfo.m_host;
+    if (!_isSlot)
+    {
+        // Agents, which don't support subscriptions, get all events
+        keys.m_isTaskDoneSubscriber = (!isTaskDoneSubscriptionSupported() || m_info.m_isTaskDoneSubscribed);
+        return keys;
+    }
+
+    try
+    {
+        const SSlotInfo& slot = m_info.getSlotByID(_protocolHeaderID);
+        keys.m_taskID = slot.m_taskID;
+        keys.m_state = slot.m_state;
+    }
+    catch (exception& _e)
+    {
+        LOG(debug) << "getChannelKeys: " << _e.what();
+    }
+    return keys;
+}
+
 uint64_t CAgentChannel::getId() const
 {
     return m_info.m_id;
@@ -113,8 +140,9 @@ bool CAgentChannel::on_cmdREPLY_HOST_INFO(SCommandAttachmentImpl<cmdREPLY_HOST_I
     m_info.m_startUpTime = chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch());
     m_info.m_startUpTime -= chrono::milliseconds(_attachment->m_submitTime);
     // everything is OK, we can work with this agent
-    LOG(info) << "The Agent [" << socket().remote_endpoint().address().to_string()
+    LOG(info) << "The Agent [" << remoteAddress()
               << "] has successfully connected. Startup time: " << m_info.m_startUpTime.count() << " ms.";
+    dispatchHandlers(EChannelEvents::OnChannelKeysChanged, SSenderInfo());
 
     // Request agent to add Task Slots
     // We get the number of slots from the agent. On submit each agent is assigned to a fixed number of slots. Then
@@ -219,3 +247,21 @@ bool CAgentChannel::on_cmdWATCHDOG_HEARTBEAT(SCommandAttachmentImpl<cmdWATCHDOG_
     // In the future we might want to send more information about tasks being executed (pid, CPU info, memory)
     return true;
 }
+
+bool CAgentChannel::on_cmdSUBSCRIBE_ON_TASK_DONE(
+    SCommandAttachmentImpl<cmdSUBSCRIBE_ON_TASK_DONE>::ptr_t /*_attachment*/, const SSenderInfo& /*_sender*/)
+{
+    LOG(debug) << "Agent " << m_info.m_id << " subscribed on task done events";
+    m_info.m_isTaskDoneSubscribed = true;
+    dispatchHandlers(EChannelEvents::OnChannelKeysChanged, SSenderInfo());
+    return true;
+}
+
+bool CAgentChannel::on_cmdUNSUBSCRIBE_ON_TASK_DONE(
+    SCommandAttachmentImpl<cmdUNSUBSCRIBE_ON_TASK_DONE>::ptr_t /*_attachment*/, const SSenderInfo& /*_sender*/)
+{
+    LOG(debug) << "Agent " << m_info.m_id << " unsubscribed from task done events";
+    m_info.m_isTaskDoneSubscribed = false;
+    dispatchHandlers(EChannelEvents::OnChannelKeysChanged, SSenderInfo());
+    return true;
+}
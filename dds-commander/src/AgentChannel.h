@@ -5,8 +5,10 @@
 #ifndef __DDS__CAgentChannel__
 #define __DDS__CAgentChannel__
 // DDS
+#include "ChannelRegistry.h"
 #include "ServerChannelImpl.h"
 // STD
+#include <atomic>
 #include <chrono>
 
 namespace dds
@@ -68,6 +70,8 @@ namespace dds
             uint64_t m_id;
             protocol_api::SHostInfoCmd m_remoteHostInfo;
             std::chrono::milliseconds m_startUpTime;
+            /// \brief Tasks of the agent are interested in cmdUSER_TASK_DONE events
+            std::atomic<bool> m_isTaskDoneSubscribed{ false };
 
           private:
             std::mutex m_mtxSlot;
@@ -93,6 +97,8 @@ namespace dds
                 MESSAGE_HANDLER(cmdBINARY_ATTACHMENT_RECEIVED, on_cmdBINARY_ATTACHMENT_RECEIVED)
                 MESSAGE_HANDLER_DISPATCH(cmdTRANSPORT_TEST)
                 MESSAGE_HANDLER(cmdREPLY, on_cmdREPLY)
+                MESSAGE_HANDLER_DISPATCH(cmdREPLY_ASSIGN_USER_TASKS)
+                MESSAGE_HANDLER_DISPATCH(cmdREPLY_CHECK_CACHED_FILES)
                 // - Topology commands
                 MESSAGE_HANDLER_DISPATCH(cmdUPDATE_TOPOLOGY)
                 // - Agents commands
@@ -106,6 +112,9 @@ namespace dds
                 MESSAGE_HANDLER_DISPATCH(cmdCUSTOM_CMD)
                 // TASK SLOTS
                 MESSAGE_HANDLER(cmdREPLY_ADD_SLOT, on_cmdREPLY_ADD_SLOT)
+                // Task done events
+                MESSAGE_HANDLER(cmdSUBSCRIBE_ON_TASK_DONE, on_cmdSUBSCRIBE_ON_TASK_DONE)
+                MESSAGE_HANDLER(cmdUNSUBSCRIBE_ON_TASK_DONE, on_cmdUNSUBSCRIBE_ON_TASK_DONE)
             END_MSG_MAP()
 
           public:
@@ -117,6 +126,9 @@ namespace dds
 
             SAgentInfo& getAgentInfo();
 
+            /// \brief Keys of the agent or of one of its slots, which are indexed by the connection manager.
+            protocol_api::SChannelKeys getChannelKeys(uint64_t _protocolHeaderID, bool _isSlot);
+
           private:
             // Message Handlers
             bool on_cmdSUBMIT(protocol_api::SCommandAttachmentImpl<protocol_api::cmdSUBMIT>::ptr_t _attachment,
@@ -135,6 +147,12 @@ namespace dds
             bool on_cmdREPLY_ADD_SLOT(
                 protocol_api::SCommandAttachmentImpl<protocol_api::cmdREPLY_ADD_SLOT>::ptr_t _attachment,
                 const protocol_api::SSenderInfo& _sender);
+            bool on_cmdSUBSCRIBE_ON_TASK_DONE(
+                protocol_api::SCommandAttachmentImpl<protocol_api::cmdSUBSCRIBE_ON_TASK_DONE>::ptr_t _attachment,
+                const protocol_api::SSenderInfo& _sender);
+            bool on_cmdUNSUBSCRIBE_ON_TASK_DONE(
+                protocol_api::SCommandAttachmentImpl<protocol_api::cmdUNSUBSCRIBE_ON_TASK_DONE>::ptr_t _attachment,
+                const protocol_api::SSenderInfo& _sender);
 
             std::string _remoteEndIDString();
 
@@ -7,6 +7,7 @@
 #include "ConnectionManager.h"
 #include "ChannelId.h"
 #include "CommandAttachmentImpl.h"
+#include "Compression.h"
 #include "Intercom.h"
 #include "MiscCli.h"
 #include "SSHConfigFile.h"
@@ -17,6 +18,7 @@
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/regex.hpp>
 // STD
+#include <map>
 #include <mutex>
 
 using namespace dds;
@@ -34,6 +36,15 @@ CConnectionManager::CConnectionManager(const SOptions_t& /*_options*/)
     : CConnectionManagerImpl<CAgentChannel, CConnectionManager>(20000, 22000, true)
 {
     LOG(info) << "CConnectionManager constructor";
+
+    const auto& serverOptions = CUserDefaults::instance().getOptions().m_server;
+    const chrono::milliseconds reportInterval(serverOptions.m_uiReportInterval);
+    m_getLog.m_reportInterval = reportInterval;
+    m_getLog.m_isAgentMessagesEnabled = serverOptions.m_uiAgentMessages;
+    m_transportTest.m_reportInterval = reportInterval;
+    m_transportTest.m_isAgentMessagesEnabled = serverOptions.m_uiAgentMessages;
+    m_updateTopology.m_reportInterval = reportInterval;
+    m_updateTopology.m_isAgentMessagesEnabled = serverOptions.m_uiAgentMessages;
 }
 
 CConnectionManager::~CConnectionManager()
@@ -96,6 +107,16 @@ void CConnectionManager::newClientCreated(CAgentChannel::connectionPtr_t _newCli
         [this, weakClient](const SSenderInfo& _sender, SCommandAttachmentImpl<cmdREPLY>::ptr_t _attachment)
         { this->on_cmdREPLY(_sender, _attachment, weakClient); });
 
+    _newClient->registerHandler<cmdREPLY_ASSIGN_USER_TASKS>(
+        [this, weakClient](const SSenderInfo& _sender,
+                           SCommandAttachmentImpl<cmdREPLY_ASSIGN_USER_TASKS>::ptr_t _attachment)
+        { this->on_cmdREPLY_ASSIGN_USER_TASKS(_sender, _attachment, weakClient); });
+
+    _newClient->registerHandler<cmdREPLY_CHECK_CACHED_FILES>(
+        [this, weakClient](const SSenderInfo& _sender,
+                           SCommandAttachmentImpl<cmdREPLY_CHECK_CACHED_FILES>::ptr_t _attachment)
+        { this->on_cmdREPLY_CHECK_CACHED_FILES(_sender, _attachment, weakClient); });
+
     _newClient->registerHandler<cmdUPDATE_KEY>(
         [this, weakClient](const SSenderInfo& _sender, SCommandAttachmentImpl<cmdUPDATE_KEY>::ptr_t _attachment)
         { this->on_cmdUPDATE_KEY(_sender, _attachment, weakClient); });
@@ -185,7 +206,7 @@ void CConnectionManager::_createWnPkg(bool _needInlineBashScript,
     LOG(info) << "WN Package Tool: STDOUT: " << out << "; STDERR: " << err;
 }
 
-void CConnectionManager::_createInfoFile(const vector<size_t>& _ports) const
+void CConnectionManager::_createInfoFile(const vector<size_t>& _ports, const string& _uiSocketPath) const
 {
     const string sSrvCfg(CUserDefaults::instance().getServerInfoFileLocationSrv());
     LOG(info) << "Creating the server info file: " << sSrvCfg;
@@ -216,8 +237,10 @@ void CConnectionManager::_createInfoFile(const vector<size_t>& _ports) const
         f << "[ui]\n"
           << "host=" << srvHost << "\n"
           << "user=" << srvUser << "\n"
-          << "port=" << _ports[1] << "\n"
-          << endl;
+          << "port=" << _ports[1] << "\n";
+        if (!_uiSocketPath.empty())
+            f << "socket=" << _uiSocketPath << "\n";
+        f << endl;
     }
 }
 
@@ -277,43 +300,17 @@ void CConnectionManager::broadcastUpdateTopologyAndWait_impl(size_t /*_index*/,
     p->pushMsg<_cmd>(*_attachment, _agent.m_protocolHeaderID);
 }
 
-template <protocol_api::ECmdType _cmd>
-void CConnectionManager::broadcastUpdateTopologyAndWait_impl(
-    size_t index, weakChannelInfo_t _agent, const vector<typename SCommandAttachmentImpl<_cmd>::ptr_t>& _attachments)
-{
-    if (_agent.m_channel.expired())
-        return;
-    auto p = _agent.m_channel.lock();
-
-    p->pushMsg<_cmd>(*_attachments[index], _agent.m_protocolHeaderID);
-}
-
 template <protocol_api::ECmdType _cmd>
 void CConnectionManager::broadcastUpdateTopologyAndWait_impl(size_t /*_index*/,
                                                              weakChannelInfo_t _agent,
-                                                             const std::string& _filePath,
+                                                             SSharedBinaryAttachment::ptr_t _file,
                                                              const std::string& _filename)
 {
     if (_agent.m_channel.expired())
         return;
     auto p = _agent.m_channel.lock();
 
-    p->pushBinaryAttachmentCmd(_filePath, _filename, _cmd, _agent.m_protocolHeaderID);
-}
-
-template <protocol_api::ECmdType _cmd>
-void CConnectionManager::broadcastUpdateTopologyAndWait_impl(size_t _index,
-                                                             weakChannelInfo_t _agent,
-                                                             const std::vector<std::string>& _filePaths,
-                                                             const std::vector<std::string>& _filenames)
-{
-    if (_agent.m_channel.expired())
-        return;
-    auto p = _agent.m_channel.lock();
-
-    string filePath = _filePaths[_index];
-    string filename = _filenames[_index];
-    p->pushBinaryAttachmentCmd(filePath, filename, _cmd, _agent.m_protocolHeaderID);
+    p->pushBinaryAttachmentCmd(_file, _filename, _cmd, _agent.m_protocolHeaderID);
 }
 
 template <protocol_api::ECmdType _cmd, class... Args>
@@ -354,126 +351,397 @@ void CConnectionManager::activateTasks(const dds::tools_api::STopologyRequestDat
                                        CAgentChannel::weakConnectionPtr_t _channel)
 {
     const CScheduler::ScheduleVector_t& schedule = _scheduler.getSchedule();
+    if (schedule.empty())
+        return;
 
-    // Data of user task upload to agents
-    weakChannelInfo_t::container_t uploadAgents;
-    vector<string> uploadFilePaths;
-    vector<string> uploadFilenames;
+    // Slots don't wait for each other. Each slot gets the next command as soon as it replies to the previous one, the
+    // progress is reported for the whole activation.
+    m_updateTopology.m_srcCommand = cmdACTIVATE_USER_TASK;
+    m_updateTopology.zeroCounters();
+    m_updateTopology.m_nofRequests = schedule.size();
 
-    // Data of user task assignment
-    weakChannelInfo_t::container_t assignmentAgents;
-    vector<typename SCommandAttachmentImpl<cmdASSIGN_USER_TASK>::ptr_t> assignmentAttachments;
-    vector<typename SCommandAttachmentImpl<cmdACTIVATE_USER_TASK>::ptr_t> activateAttachments;
+    sendToolsAPIMsg(_channel, _topologyInfo.m_requestID, "Activating user tasks...", EMsgSeverity::info);
+    dds::tools_api::SProgressResponseData progress(cmdACTIVATE_USER_TASK, 0, m_updateTopology.m_nofRequests, 0);
+    sendCustomCommandResponse(_channel, progress.toJSON());
 
-    // Collecting data for broadcasting
-    for (const auto& sch : schedule)
+    // Uploads of the slots
+    vector<pair<SSharedBinaryAttachment::ptr_t, string>> uploads;
+    vector<size_t> uploadIndexes;
+    vector<typename SCommandAttachmentImpl<cmdASSIGN_USER_TASK>::ptr_t> assignments;
+    // Each file is read and hashed only once, even if it is uploaded to many agents
+    map<string, pair<SSharedBinaryAttachment::ptr_t, string>> uploadFileCache;
+    auto addUpload = [&uploads, &uploadFileCache](const string& _path,
+                                                  string& _cmdStr,
+                                                  SAssignUserTaskCmd& _cmd,
+                                                  SAgentActivation* _cachingAgent)
     {
-        typename SCommandAttachmentImpl<cmdASSIGN_USER_TASK>::ptr_t cmd = make_shared<SAssignUserTaskCmd>();
-        cmd->m_taskID = sch.m_taskID;
-        cmd->m_taskIndex = sch.m_taskInfo.m_taskIndex;
-        cmd->m_collectionIndex = sch.m_taskInfo.m_collectionIndex;
-        cmd->m_taskPath = sch.m_taskInfo.m_taskPath;
-        cmd->m_groupName = sch.m_taskInfo.m_task->getParentGroupId();
-        cmd->m_collectionName = sch.m_taskInfo.m_task->getParentCollectionId();
-        cmd->m_taskName = sch.m_taskInfo.m_task->getName();
-        cmd->m_topoHash = m_topo.getHash();
-
-        if (sch.m_taskInfo.m_task->isExeReachable())
+        string filePath;
+        string filename;
+        parseExe(_path, "%DDS_DEFAULT_TASK_PATH%", filePath, filename, _cmdStr);
+
+        auto& file = uploadFileCache[filePath];
+        if (file.first == nullptr)
+            file.first = SSharedBinaryAttachment::makeFromFile(filePath);
+        if (_cachingAgent == nullptr)
         {
-            cmd->m_sExeFile = sch.m_taskInfo.m_task->getExe();
+            uploads.emplace_back(file.first, filename);
+            return;
         }
-        else
-        {
-            string filePath;
-            string filename;
-            string cmdStr;
-            parseExe(sch.m_taskInfo.m_task->getExe(), "%DDS_DEFAULT_TASK_PATH%", filePath, filename, cmdStr);
 
-            cmd->m_sExeFile = cmdStr;
+        // The file is uploaded to the file cache of the agent at most once, the agent links it into the slot
+        if (file.second.empty())
+            file.second = file.first->contentHash();
+        _cmd.m_cachedFileHashes.push_back(file.second);
+        _cmd.m_cachedFileNames.push_back(filename);
+        _cachingAgent->m_cachedFiles.emplace(file.second, file.first);
+    };
 
-            // Upload file only if it's not reachable
-            uploadFilePaths.push_back(filePath);
-            uploadFilenames.push_back(filename);
-            uploadAgents.push_back(sch.m_weakChannelInfo);
-        }
+    vector<pair<CAgentChannel::weakConnectionPtr_t, SCachedFilesCmd>> cachedFilesChecks;
 
-        // attache the environment script if needed
-        if (!sch.m_taskInfo.m_task->getEnv().empty())
+    m_updateTopoCondition.reset();
+    {
+        lock_guard<mutex> lock(m_mtxSlotActivations);
+        m_slotActivations.clear();
+        m_slotActivations.reserve(schedule.size());
+        m_agentActivations.clear();
+        m_activationStartTime = chrono::steady_clock::now();
+        m_firstTaskActivationTime = chrono::steady_clock::time_point();
+
+        for (const auto& sch : schedule)
         {
-            if (sch.m_taskInfo.m_task->isEnvReachable())
+            typename SCommandAttachmentImpl<cmdASSIGN_USER_TASK>::ptr_t cmd = make_shared<SAssignUserTaskCmd>();
+            cmd->m_taskID = sch.m_taskID;
+            cmd->m_taskIndex = sch.m_taskInfo.m_taskIndex;
+            cmd->m_collectionIndex = sch.m_taskInfo.m_collectionIndex;
+            cmd->m_taskPath = sch.m_taskInfo.m_taskPath;
+            cmd->m_groupName = sch.m_taskInfo.m_task->getParentGroupId();
+            cmd->m_collectionName = sch.m_taskInfo.m_task->getParentCollectionId();
+            cmd->m_taskName = sch.m_taskInfo.m_task->getName();
+            cmd->m_topoHash = m_topo.getHash();
+
+            uploadIndexes.push_back(uploads.size());
+            assignments.push_back(cmd);
+
+            // Agents supporting it get the assignments of all their slots in one message
+            SAgentActivation* agentActivation{ nullptr };
+            auto p = sch.m_weakChannelInfo.m_channel.lock();
+            if (p != nullptr && p->isAssignUserTasksSupported())
             {
-                cmd->m_sEnvFile = sch.m_taskInfo.m_task->getEnv();
+                agentActivation = &m_agentActivations[p->getAgentInfo().m_id];
+                agentActivation->m_channel = p;
             }
+            SAgentActivation* cachingAgent{ (p != nullptr && p->isFileCacheSupported()) ? agentActivation : nullptr };
+
+            // Upload file only if it's not reachable
+            if (sch.m_taskInfo.m_task->isExeReachable())
+                cmd->m_sExeFile = sch.m_taskInfo.m_task->getExe();
             else
-            {
-                string filePath;
-                string filename;
-                string cmdStr;
-                parseExe(sch.m_taskInfo.m_task->getEnv(), "%DDS_DEFAULT_TASK_PATH%", filePath, filename, cmdStr);
+                addUpload(sch.m_taskInfo.m_task->getExe(), cmd->m_sExeFile, *cmd, cachingAgent);
 
-                cmd->m_sEnvFile = cmdStr;
+            // attache the environment script if needed
+            if (!sch.m_taskInfo.m_task->getEnv().empty())
+            {
+                if (sch.m_taskInfo.m_task->isEnvReachable())
+                    cmd->m_sEnvFile = sch.m_taskInfo.m_task->getEnv();
+                else
+                    addUpload(sch.m_taskInfo.m_task->getEnv(), cmd->m_sEnvFile, *cmd, cachingAgent);
+            }
 
-                // Upload file only if it's not reachable
-                uploadFilePaths.push_back(filePath);
-                uploadFilenames.push_back(filename);
-                uploadAgents.push_back(sch.m_weakChannelInfo);
+            const uint64_t slotID{ sch.m_weakChannelInfo.m_protocolHeaderID };
+            SSlotActivation& activation = m_slotActivations[slotID];
+            activation.m_agent = sch.m_weakChannelInfo;
+            activation.m_taskID = sch.m_taskID;
+            activation.m_assignment = cmd;
+            activation.m_requestID = _topologyInfo.m_requestID;
+            activation.m_uiChannel = _channel;
+            activation.m_nofUploads = uploads.size() - uploadIndexes.back();
+            activation.m_stage = (activation.m_nofUploads > 0) ? SSlotActivation::EStage::upload
+                                                               : SSlotActivation::EStage::assign;
+            if (agentActivation != nullptr)
+            {
+                activation.m_isBatched = true;
+                activation.m_agentID = p->getAgentInfo().m_id;
+                agentActivation->m_nofUploads += activation.m_nofUploads;
+                agentActivation->m_slotIDs.push_back(slotID);
             }
         }
 
-        typename SCommandAttachmentImpl<cmdACTIVATE_USER_TASK>::ptr_t activate_cmd = make_shared<SIDCmd>();
-        activate_cmd->m_id = sch.m_weakChannelInfo.m_protocolHeaderID;
+        // Agents with a file cache are asked first which files they miss
+        for (auto& agentActivation : m_agentActivations)
+        {
+            if (agentActivation.second.m_cachedFiles.empty())
+                continue;
 
-        assignmentAgents.push_back(sch.m_weakChannelInfo);
-        assignmentAttachments.push_back(cmd);
-        activateAttachments.push_back(activate_cmd);
+            ++agentActivation.second.m_nofUploads;
+            SCachedFilesCmd cmd;
+            for (const auto& file : agentActivation.second.m_cachedFiles)
+                cmd.m_hashes.push_back(file.first);
+            cachedFilesChecks.emplace_back(agentActivation.second.m_channel, cmd);
+        }
     }
 
-    if (uploadAgents.size() > 0)
+    for (const auto& check : cachedFilesChecks)
     {
-        broadcastUpdateTopologyAndWait<cmdASSIGN_USER_TASK>(
-            uploadAgents, _channel, "Uploading user tasks...", uploadFilePaths, uploadFilenames);
+        if (auto p = check.first.lock())
+            p->pushMsg<cmdCHECK_CACHED_FILES>(check.second);
     }
 
-    broadcastUpdateTopologyAndWait<cmdASSIGN_USER_TASK>(
-        assignmentAgents, _channel, "Assigning user tasks...", assignmentAttachments);
-
-    // Set executing state and task ID for agent channels
-    for (const auto& sch : schedule)
+    // Start the pipeline of each slot. Replies might already advance the slots started first.
+    set<uint64_t> batchedAgents;
+    for (size_t i = 0; i < schedule.size(); ++i)
     {
-        if (sch.m_weakChannelInfo.m_channel.expired())
+        const auto& agent = schedule[i].m_weakChannelInfo;
+        auto p = agent.m_channel.lock();
+        if (p == nullptr)
             continue;
-        auto ptr = sch.m_weakChannelInfo.m_channel.lock();
 
-        SAgentInfo& inf = ptr->getAgentInfo();
-        SSlotInfo& slot = inf.getSlotByID(sch.m_weakChannelInfo.m_protocolHeaderID);
+        const size_t uploadsEnd = (i + 1 < schedule.size()) ? uploadIndexes[i + 1] : uploads.size();
+        if (p->isAssignUserTasksSupported())
+            batchedAgents.insert(p->getAgentInfo().m_id);
+        else if (uploadIndexes[i] == uploadsEnd)
+            p->pushMsg<cmdASSIGN_USER_TASK>(*assignments[i], agent.m_protocolHeaderID);
 
-        slot.m_taskID = sch.m_taskID;
-        slot.m_state = EAgentState::executing;
+        for (size_t j = uploadIndexes[i]; j < uploadsEnd; ++j)
+        {
+            p->pushBinaryAttachmentCmd(
+                uploads[j].first, uploads[j].second, cmdASSIGN_USER_TASK, agent.m_protocolHeaderID);
+        }
+    }
 
-        try
+    // Agents without uploads get their assignments right away, the others once their uploads are confirmed
+    for (auto agentID : batchedAgents)
+    {
+        bool isReady{ false };
         {
-            // Notify Tools API befor activating the tasks
-            STopologyResponseData info;
-            info.m_requestID = _topologyInfo.m_requestID;
-            info.m_activated = true;
-            info.m_agentID = inf.m_id;
-            info.m_slotID = slot.m_id;
-            info.m_taskID = sch.m_taskID;
-            auto task{ m_topo.getRuntimeTaskById(sch.m_taskID) };
-            info.m_collectionID = task.m_taskCollectionId;
-            info.m_path = task.m_taskPath;
-            info.m_host = inf.m_remoteHostInfo.m_host;
-            info.m_wrkDir = inf.m_remoteHostInfo.m_DDSPath;
-            sendCustomCommandResponse(_channel, info.toJSON());
+            lock_guard<mutex> lock(m_mtxSlotActivations);
+            auto it = m_agentActivations.find(agentID);
+            isReady = (it != m_agentActivations.end() && it->second.m_nofUploads == 0);
+        }
+        if (isReady)
+            sendAgentAssignment(agentID);
+    }
+
+    // Wait until all slots are activated or failed
+    m_updateTopoCondition.wait();
+
+    chrono::steady_clock::time_point firstTaskTime;
+    {
+        lock_guard<mutex> lock(m_mtxSlotActivations);
+        m_slotActivations.clear();
+        m_agentActivations.clear();
+        firstTaskTime = m_firstTaskActivationTime;
+    }
+    const auto toMs = [this](chrono::steady_clock::time_point _time)
+    { return chrono::duration_cast<chrono::milliseconds>(_time - m_activationStartTime).count(); };
+    stringstream ss;
+    ss << "Time to activate the first task: ";
+    if (firstTaskTime == chrono::steady_clock::time_point())
+        ss << "n/a";
+    else
+        ss << toMs(firstTaskTime) << " ms";
+    ss << ", all tasks: " << toMs(chrono::steady_clock::now()) << " ms";
+    LOG(info) << ss.str();
+    sendToolsAPIMsg(_channel, _topologyInfo.m_requestID, ss.str(), EMsgSeverity::info);
+}
+
+void CConnectionManager::processCachedFileReply(const SReplyCmd& _reply, CAgentChannel::weakConnectionPtr_t _channel)
+{
+    auto p = _channel.lock();
+    if (p == nullptr)
+        return;
+
+    const uint64_t agentID{ p->getAgentInfo().m_id };
+    bool isReady{ false };
+    {
+        lock_guard<mutex> lock(m_mtxSlotActivations);
+        auto it = m_agentActivations.find(agentID);
+        if (it == m_agentActivations.end())
+            return;
+        isReady = (--it->second.m_nofUploads == 0);
+    }
+
+    // Slots of a file, which failed to be cached, fail when the agent links it
+    if (SReplyCmd::EStatusCode(_reply.m_statusCode) == SReplyCmd::EStatusCode::ERROR)
+        LOG(error) << "Agent " << agentID << " failed to cache a file: " << _reply.m_sMsg;
+
+    if (isReady)
+        sendAgentAssignment(agentID);
+}
+
+void CConnectionManager::sendAgentAssignment(uint64_t _agentID)
+{
+    CAgentChannel::connectionPtr_t p;
+    vector<pair<uint64_t, SSlotActivation>> slots;
+    {
+        lock_guard<mutex> lock(m_mtxSlotActivations);
+        auto it = m_agentActivations.find(_agentID);
+        if (it == m_agentActivations.end())
+            return;
+
+        p = it->second.m_channel.lock();
+        for (auto slotID : it->second.m_slotIDs)
+        {
+            // Slots with failed uploads are not assigned
+            auto slotIt = m_slotActivations.find(slotID);
+            if (slotIt == m_slotActivations.end())
+                continue;
+            slotIt->second.m_stage = SSlotActivation::EStage::activate;
+            slots.emplace_back(slotID, slotIt->second);
+        }
+        m_agentActivations.erase(it);
+    }
+
+    if (p == nullptr || slots.empty())
+        return;
+
+    SAssignUserTasksCmd cmd;
+    cmd.m_slots.reserve(slots.size());
+    for (const auto& slot : slots)
+    {
+        setSlotExecuting(p, slot.first, slot.second.m_taskID, slot.second.m_requestID, slot.second.m_uiChannel);
+        cmd.m_slots.push_back({ slot.first, *slot.second.m_assignment });
+    }
+    p->pushMsg<cmdASSIGN_USER_TASKS>(cmd);
+}
+
+void CConnectionManager::setSlotExecuting(CAgentChannel::connectionPtr_t _agent,
+                                          uint64_t _slotID,
+                                          uint64_t _taskID,
+                                          requestID_t _requestID,
+                                          CAgentChannel::weakConnectionPtr_t _channel)
+{
+    // Set executing state and task ID for the slot
+    SAgentInfo& inf = _agent->getAgentInfo();
+    SSlotInfo& slot = inf.getSlotByID(_slotID);
+    slot.m_taskID = _taskID;
+    slot.m_state = EAgentState::executing;
+    updateChannelKeys(_agent.get(), _slotID);
+
+    try
+    {
+        // Notify Tools API befor activating the task
+        STopologyResponseData info;
+        info.m_requestID = _requestID;
+        info.m_activated = true;
+        info.m_agentID = inf.m_id;
+        info.m_slotID = slot.m_id;
+        info.m_taskID = _taskID;
+        auto task{ m_topo.getRuntimeTaskById(_taskID) };
+        info.m_collectionID = task.m_taskCollectionId;
+        info.m_path = task.m_taskPath;
+        info.m_host = inf.m_remoteHostInfo.m_host;
+        info.m_wrkDir = inf.m_remoteHostInfo.m_DDSPath;
+        sendCustomCommandResponse(_channel, info.toJSON());
+    }
+    catch (exception& _e)
+    {
+        LOG(error) << "Failed to notify Tools API about activated task (" << _taskID << "): " << _e.what();
+    }
+}
+
+void CConnectionManager::setSlotIdle(CAgentChannel::connectionPtr_t _agent, uint64_t _slotID)
+{
+    SSlotInfo& slot = _agent->getAgentInfo().getSlotByID(_slotID);
+    slot.m_taskID = 0;
+    slot.m_state = EAgentState::idle;
+    updateChannelKeys(_agent.get(), _slotID);
+}
+
+void CConnectionManager::processActivationReply(const SSenderInfo& _sender,
+                                                const SReplyCmd& _reply,
+                                                CAgentChannel::weakConnectionPtr_t _channel)
+{
+    const bool isOK{ SReplyCmd::EStatusCode(_reply.m_statusCode) == SReplyCmd::EStatusCode::OK };
+    if (!isOK && SReplyCmd::EStatusCode(_reply.m_statusCode) != SReplyCmd::EStatusCode::ERROR)
+        return;
+
+    SSlotActivation activation;
+    bool sendAssignment{ false };
+    bool sendAgentAssignments{ false };
+    {
+        lock_guard<mutex> lock(m_mtxSlotActivations);
+        auto it = m_slotActivations.find(_sender.m_ID);
+        if (it == m_slotActivations.end())
+        {
+            // E.g. the remaining upload of a slot which has already failed
+            LOG(debug) << "Ignoring activation reply of slot " << _sender.m_ID << ": " << _reply;
+            return;
+        }
+
+        activation = it->second;
+        if (activation.m_isBatched && activation.m_stage == SSlotActivation::EStage::upload)
+        {
+            // Uploads not confirmed yet won't be confirmed for a failed slot
+            const size_t nofConfirmed{ isOK ? 1 : activation.m_nofUploads };
+            auto agentIt = m_agentActivations.find(activation.m_agentID);
+            if (agentIt != m_agentActivations.end())
+            {
+                agentIt->second.m_nofUploads -= nofConfirmed;
+                sendAgentAssignments = (agentIt->second.m_nofUploads == 0);
+            }
+            if (isOK)
+                --it->second.m_nofUploads;
+        }
+
+        if (!isOK || activation.m_stage == SSlotActivation::EStage::activate)
+        {
+            // The slot is done
+            m_slotActivations.erase(it);
+            if (isOK && m_firstTaskActivationTime == chrono::steady_clock::time_point())
+                m_firstTaskActivationTime = chrono::steady_clock::now();
+        }
+        else if (activation.m_stage == SSlotActivation::EStage::upload)
+        {
+            if (!activation.m_isBatched && --it->second.m_nofUploads == 0)
+            {
+                it->second.m_stage = SSlotActivation::EStage::assign;
+                sendAssignment = true;
+            }
         }
-        catch (exception& _e)
+        else
         {
-            LOG(error) << "Failed to notify Tools API about activated task (" << sch.m_taskID << "): " << _e.what();
+            it->second.m_stage = SSlotActivation::EStage::activate;
         }
     }
 
-    broadcastUpdateTopologyAndWait<cmdACTIVATE_USER_TASK>(
-        assignmentAgents, _channel, "Activating user tasks...", activateAttachments);
+    if (sendAgentAssignments)
+        sendAgentAssignment(activation.m_agentID);
+
+    auto p = _channel.lock();
+    if (p == nullptr)
+        return;
+
+    if (!isOK)
+    {
+        // In case of error set the idle state
+        if (activation.m_stage == SSlotActivation::EStage::activate)
+            setSlotIdle(p, _sender.m_ID);
+        m_updateTopology.processErrorMessage<SReplyCmd>(_sender, _reply, _channel);
+    }
+    else if (activation.m_stage == SSlotActivation::EStage::upload)
+    {
+        if (sendAssignment)
+            p->pushMsg<cmdASSIGN_USER_TASK>(*activation.m_assignment, _sender.m_ID);
+        return;
+    }
+    else if (activation.m_stage == SSlotActivation::EStage::assign)
+    {
+        setSlotExecuting(p, _sender.m_ID, activation.m_taskID, activation.m_requestID, activation.m_uiChannel);
+
+        SIDCmd cmd;
+        cmd.m_id = _sender.m_ID;
+        p->pushMsg<cmdACTIVATE_USER_TASK>(cmd, _sender.m_ID);
+        return;
+    }
+    else
+    {
+        m_updateTopology.processMessage<SReplyCmd>(_sender, _reply, _channel);
+    }
+
+    if (m_updateTopology.allReceived())
+    {
+        m_updateTopoCondition.notifyAll();
+    }
 }
 
 void CConnectionManager::on_cmdTRANSPORT_TEST(const SSenderInfo& _sender,
@@ -533,45 +801,15 @@ void CConnectionManager::on_cmdREPLY(const SSenderInfo& _sender,
     switch (_attachment->m_srcCommand)
     {
         case cmdASSIGN_USER_TASK:
+        case cmdACTIVATE_USER_TASK:
         {
-            if (SReplyCmd::EStatusCode(_attachment->m_statusCode) == SReplyCmd::EStatusCode::OK)
-            {
-                m_updateTopology.processMessage<SReplyCmd>(_sender, *_attachment, _channel);
-            }
-            else if (SReplyCmd::EStatusCode(_attachment->m_statusCode) == SReplyCmd::EStatusCode::ERROR)
-            {
-                m_updateTopology.processErrorMessage<SReplyCmd>(_sender, *_attachment, _channel);
-            }
-            if (m_updateTopology.allReceived())
-            {
-                m_updateTopoCondition.notifyAll();
-            }
+            processActivationReply(_sender, *_attachment, _channel);
             return;
         }
 
-        case cmdACTIVATE_USER_TASK:
+        case cmdCHECK_CACHED_FILES:
         {
-            if (SReplyCmd::EStatusCode(_attachment->m_statusCode) == SReplyCmd::EStatusCode::OK)
-            {
-                m_updateTopology.processMessage<SReplyCmd>(_sender, *_attachment, _channel);
-            }
-            else if (SReplyCmd::EStatusCode(_attachment->m_statusCode) == SReplyCmd::EStatusCode::ERROR)
-            {
-                // In case of error set the idle state
-                if (auto p = _channel.lock())
-                {
-                    SAgentInfo& inf = p->getAgentInfo();
-                    SSlotInfo& slot = inf.getSlotByID(_sender.m_ID);
-
-                    slot.m_taskID = 0;
-                    slot.m_state = EAgentState::idle;
-                }
-                m_updateTopology.processErrorMessage<SReplyCmd>(_sender, *_attachment, _channel);
-            }
-            if (m_updateTopology.allReceived())
-            {
-                m_updateTopoCondition.notifyAll();
-            }
+            processCachedFileReply(*_attachment, _channel);
             return;
         }
 
@@ -583,13 +821,7 @@ void CConnectionManager::on_cmdREPLY(const SSenderInfo& _sender,
                 {
                     // Task was successfully stopped, set the idle state
                     if (auto p = _channel.lock())
-                    {
-                        SAgentInfo& inf = p->getAgentInfo();
-                        SSlotInfo& slot = inf.getSlotByID(_sender.m_ID);
-
-                        slot.m_taskID = 0;
-                        slot.m_state = EAgentState::idle;
-                    }
+                        setSlotIdle(p, _sender.m_ID);
                 }
             }
             else if (SReplyCmd::EStatusCode(_attachment->m_statusCode) == SReplyCmd::EStatusCode::ERROR)
@@ -640,65 +872,99 @@ void CConnectionManager::on_cmdREPLY(const SSenderInfo& _sender,
     }
 }
 
-void CConnectionManager::on_cmdUPDATE_KEY(const SSenderInfo& /*_sender*/,
-                                          SCommandAttachmentImpl<cmdUPDATE_KEY>::ptr_t _attachment,
-                                          CAgentChannel::weakConnectionPtr_t /*_channel*/)
+void CConnectionManager::on_cmdREPLY_ASSIGN_USER_TASKS(
+    const SSenderInfo& _sender,
+    SCommandAttachmentImpl<cmdREPLY_ASSIGN_USER_TASKS>::ptr_t _attachment,
+    CAgentChannel::weakConnectionPtr_t _channel)
 {
-    // Commander forwards cmdUPDATE_KEY to the proper channel
+    // The aggregated reply is processed like the replies of the individual slots
+    for (const auto& slot : _attachment->m_slots)
+    {
+        SSenderInfo sender(_sender);
+        sender.m_ID = slot.m_slotID;
+        processActivationReply(sender, slot.m_reply, _channel);
+    }
+}
 
-    CAgentChannel::weakConnectionPtr_t weakPtr;
-    uint64_t protocolHeaderID{ 0 };
+void CConnectionManager::on_cmdREPLY_CHECK_CACHED_FILES(
+    const SSenderInfo& /*_sender*/,
+    SCommandAttachmentImpl<cmdREPLY_CHECK_CACHED_FILES>::ptr_t _attachment,
+    CAgentChannel::weakConnectionPtr_t _channel)
+{
+    auto p = _channel.lock();
+    if (p == nullptr)
+        return;
 
-    { // a smaller scope for the lock
-        lock_guard<mutex> lock(m_mapMutex);
-        auto channel = m_taskIDToAgentChannelMap.find(_attachment->m_receiverTaskID);
-        if (channel == m_taskIDToAgentChannelMap.end())
-        {
-            LOG(debug) << "on_cmdUPDATE_KEY task <" << _attachment->m_receiverTaskID
-                       << "> not found in map. Property will not be updated.";
+    // Upload the missing files to the file cache of the agent, its slots are assigned once all of them are confirmed
+    const uint64_t agentID{ p->getAgentInfo().m_id };
+    vector<pair<string, SSharedBinaryAttachment::ptr_t>> uploads;
+    bool isReady{ false };
+    {
+        lock_guard<mutex> lock(m_mtxSlotActivations);
+        auto it = m_agentActivations.find(agentID);
+        if (it == m_agentActivations.end())
             return;
-        }
 
-        weakPtr = channel->second.m_channel;
-        protocolHeaderID = channel->second.m_protocolHeaderID;
+        for (const auto& hash : _attachment->m_hashes)
+        {
+            auto file = it->second.m_cachedFiles.find(hash);
+            if (file != it->second.m_cachedFiles.end())
+                uploads.emplace_back(*file);
+        }
+        // The check itself is replaced by the uploads
+        it->second.m_nofUploads += uploads.size();
+        isReady = (--it->second.m_nofUploads == 0);
+        LOG(info) << "Agent " << agentID << " misses " << uploads.size() << " of "
+                  << it->second.m_cachedFiles.size() << " cached files";
     }
 
-    if (!weakPtr.expired())
+    for (const auto& upload : uploads)
+        p->pushBinaryAttachmentCmd(upload.second, upload.first, cmdCHECK_CACHED_FILES, 0);
+
+    if (isReady)
+        sendAgentAssignment(agentID);
+}
+
+void CConnectionManager::on_cmdUPDATE_KEY(const SSenderInfo& /*_sender*/,
+                                          SCommandAttachmentImpl<cmdUPDATE_KEY>::ptr_t _attachment,
+                                          CAgentChannel::weakConnectionPtr_t /*_channel*/)
+{
+    // Commander forwards cmdUPDATE_KEY to the proper channel
+
+    weakChannelInfo_t channel;
+    if (!m_taskIDToAgentChannelMap.find(_attachment->m_receiverTaskID, channel))
     {
-        auto ptr = weakPtr.lock();
-        ptr->accumulativePushMsg<cmdUPDATE_KEY>(*_attachment, protocolHeaderID);
+        LOG(debug) << "on_cmdUPDATE_KEY task <" << _attachment->m_receiverTaskID
+                   << "> not found in map. Property will not be updated.";
+        return;
     }
+
+    if (auto ptr = channel.m_channel.lock())
+        ptr->accumulativePushMsg<cmdUPDATE_KEY>(*_attachment, channel.m_protocolHeaderID);
 }
 
 void CConnectionManager::on_cmdUSER_TASK_DONE(const SSenderInfo& _sender,
                                               SCommandAttachmentImpl<cmdUSER_TASK_DONE>::ptr_t _attachment,
                                               CAgentChannel::weakConnectionPtr_t _channel)
 {
-    // Send a broad cast message to all agents
+    // Send the event only to agents, whose tasks subscribed on it. Agents, which don't support subscriptions, get all
+    // events. The subscribers are indexed. Events of tasks exiting within a short window are batched.
     auto condition = [](const CConnectionManager::channelInfo_t& _v, bool& /*_stop*/)
-    { return (_v.m_channel->getChannelType() == EChannelType::AGENT && !_v.m_isSlot && _v.m_channel->started()); };
-    broadcastMsg<cmdUSER_TASK_DONE>(*_attachment, condition);
+    { return _v.m_channel->started(); };
+    accumulativeBroadcastMsg<cmdUSER_TASK_DONE>(*_attachment, getTaskDoneSubscribers(condition));
 
     SHostInfoCmd hostInfo;
     if (!_channel.expired())
     {
         auto channelPtr = _channel.lock();
-        SAgentInfo& thisInf = channelPtr->getAgentInfo();
-        SSlotInfo& thisSlotInf = thisInf.getSlotByID(_sender.m_ID);
-        thisSlotInf.m_state = EAgentState::idle;
-        thisSlotInf.m_taskID = 0;
+        setSlotIdle(channelPtr, _sender.m_ID);
 
         // Collect additional response info
-        hostInfo = thisInf.m_remoteHostInfo;
+        hostInfo = channelPtr->getAgentInfo().m_remoteHostInfo;
     }
 
     // remove task ID from the map
-    {
-        lock_guard<mutex> lock(m_mapMutex);
-        auto it = m_taskIDToAgentChannelMap.find(_attachment->m_taskID);
-        if (it != m_taskIDToAgentChannelMap.end())
-            m_taskIDToAgentChannelMap.erase(it);
-    }
+    m_taskIDToAgentChannelMap.erase(_attachment->m_taskID);
 
     string path;
     try
@@ -790,6 +1056,8 @@ void CConnectionManager::on_cmdREPLY_ID(const SSenderInfo& _sender,
 
         CConnectionManagerImpl::weakChannelInfo_t inf(_channel, p->getId(), false);
         updateChannelProtocolHeaderID(inf);
+        // The agent and its slots are indexed by the agent ID
+        updateChannelKeys(p.get());
     }
     catch (exception& _e)
     {
@@ -858,10 +1126,10 @@ void CConnectionManager::on_cmdCUSTOM_CMD(const SSenderInfo& _sender,
 
             // Check if we can find task for it's full id path.
             bool taskFound = true;
+            uint64_t targetTaskID(0);
             try
             {
-                /*const STopoRuntimeTask& runtimeTask = */
-                m_topo.getRuntimeTaskByIdPath(_attachment->m_sCondition);
+                targetTaskID = m_topo.getRuntimeTaskByIdPath(_attachment->m_sCondition).m_taskId;
             }
             catch (runtime_error& _e)
             {
@@ -881,37 +1149,44 @@ void CConnectionManager::on_cmdCUSTOM_CMD(const SSenderInfo& _sender,
             {
             }
 
-            channels = getChannels(
-                [this, taskFound, &_attachment, &thisTaskID, pathRegex](const CConnectionManager::channelInfo_t& _v,
-                                                                        bool& _stop)
+            if (taskFound)
+            {
+                // The slot executing the task is indexed by the task ID. Do not send command to self.
+                CConnectionManager::weakChannelInfo_t target(getChannelByTaskID(targetTaskID));
+                auto ptr = target.m_channel.lock();
+                if (ptr && ptr->started() && targetTaskID != thisTaskID &&
+                    ptr->getAgentInfo().getSlotByID(target.m_protocolHeaderID).m_state == EAgentState::executing)
                 {
-                    if (!_v.m_isSlot)
-                        return false;
-
-                    SAgentInfo& inf = _v.m_channel->getAgentInfo();
-                    SSlotInfo& slotInf = inf.getSlotByID(_v.m_protocolHeaderID);
-
-                    // Only for Agents which are started already and executing task
-                    if (_v.m_channel->getChannelType() != EChannelType::AGENT || !_v.m_channel->started() ||
-                        slotInf.m_state != EAgentState::executing)
-                        return false;
-
-                    // Do not send command to self
-                    if (thisTaskID > 0 && slotInf.m_taskID == thisTaskID)
-                        return false;
+                    channels.push_back(target);
+                }
+            }
+            else
+            {
+                // Only for Agents which are started already and executing task
+                channels = getChannels(
+                    EChannelType::AGENT,
+                    true,
+                    EAgentState::executing,
+                    [this, &_attachment, &thisTaskID, pathRegex](const CConnectionManager::channelInfo_t& _v,
+                                                                 bool& /*_stop*/)
+                    {
+                        if (!_v.m_channel->started())
+                            return false;
 
-                    // If condition is empty we broadcast command to all agents
-                    if (_attachment->m_sCondition.empty())
-                        return true;
+                        SSlotInfo& slotInf = _v.m_channel->getAgentInfo().getSlotByID(_v.m_protocolHeaderID);
 
-                    const STopoRuntimeTask& taskInfo = m_topo.getRuntimeTaskById(slotInf.m_taskID);
-                    bool result = (taskFound) ? taskInfo.m_taskPath == _attachment->m_sCondition
-                                              : boost::regex_match(taskInfo.m_task->getPath(), *pathRegex);
+                        // Do not send command to self
+                        if (thisTaskID > 0 && slotInf.m_taskID == thisTaskID)
+                            return false;
 
-                    _stop = (taskFound && result);
+                        // If condition is empty we broadcast command to all agents
+                        if (_attachment->m_sCondition.empty())
+                            return true;
 
-                    return result;
-                });
+                        const STopoRuntimeTask& taskInfo = m_topo.getRuntimeTaskById(slotInf.m_taskID);
+                        return boost::regex_match(taskInfo.m_task->getPath(), *pathRegex);
+                    });
+            }
         }
 
         for (const auto& v : channels)
@@ -1200,15 +1475,14 @@ void CConnectionManager::updateTopology(const dds::tools_api::STopologyRequestDa
         // Check if topology is currently active, i.e. there are executing tasks
         //
         CConnectionManager::weakChannelInfo_t::container_t channels(getChannels(
+            EChannelType::AGENT,
+            true,
+            EAgentState::executing,
             [](const CConnectionManager::channelInfo_t& _v, bool& _stop)
             {
-                if (!_v.m_isSlot)
-                    return false;
-
                 SAgentInfo& info = _v.m_channel->getAgentInfo();
                 SSlotInfo& slot = info.getSlotByID(_v.m_protocolHeaderID);
-                _stop = (_v.m_channel->getChannelType() == EChannelType::AGENT && _v.m_channel->started() &&
-                         slot.m_taskID > 0 && slot.m_state == EAgentState::executing);
+                _stop = (_v.m_channel->started() && slot.m_taskID > 0);
                 return _stop;
             }));
         bool topologyActive = !channels.empty();
@@ -1281,13 +1555,12 @@ void CConnectionManager::updateTopology(const dds::tools_api::STopologyRequestDa
 
             // Notify Tools API before stopping tasks
             {
-                lock_guard<mutex> lock(m_mapMutex);
                 for (auto taskID : removedTasks)
                 {
                     try
                     {
-                        auto agent{ m_taskIDToAgentChannelMap[taskID] };
-                        if (agent.m_channel.expired())
+                        weakChannelInfo_t agent;
+                        if (!m_taskIDToAgentChannelMap.find(taskID, agent) || agent.m_channel.expired())
                             continue;
                         auto ptr{ agent.m_channel.lock() };
 
@@ -1329,11 +1602,10 @@ void CConnectionManager::updateTopology(const dds::tools_api::STopologyRequestDa
         //
         if (!topologyFile.empty())
         {
-            auto allCondition = [](const CConnectionManager::channelInfo_t& _v, bool& /*_stop*/) {
-                return (!_v.m_isSlot && _v.m_channel->getChannelType() == EChannelType::AGENT &&
-                        _v.m_channel->started());
-            };
-            CConnectionManager::weakChannelInfo_t::container_t allAgents(getChannels(allCondition));
+            auto allCondition = [](const CConnectionManager::channelInfo_t& _v, bool& /*_stop*/)
+            { return _v.m_channel->started(); };
+            CConnectionManager::weakChannelInfo_t::container_t allAgents(
+                getChannels(EChannelType::AGENT, false, allCondition));
 
             if (allAgents.size() == 0)
                 throw runtime_error("There are no active agents.");
@@ -1348,19 +1620,12 @@ void CConnectionManager::updateTopology(const dds::tools_api::STopologyRequestDa
                 // file.
                 LOG(info) << "Topology file uncompressed size: "
                           << dds::misc::HumanReadable{ fs::file_size(topologyFile) } << " Compressing topology file...";
-                // make a copy of the orig. file
-                // The copy is located in the commander's working directory
+                // The compressed copy is located in the commander's working directory.
+                // Agents uncompress it in-process, older agents use gzip.
                 const fs::path wrkDir(user_defaults_api::CUserDefaults::instance().getWrkDir());
                 copyTopoFile = wrkDir;
-                copyTopoFile /= "topology_agent_copy.xml";
-                fs::copy_file(topologyFile, copyTopoFile);
-                // compressing
-                const fs::path gzipPath{ bp::search_path("gzip") };
-                stringstream ssCmd;
-                ssCmd << gzipPath.string() << " -9 " << copyTopoFile;
-                string output;
-                execute(ssCmd.str(), chrono::seconds(60), &output);
-                copyTopoFile += ".gz";
+                copyTopoFile /= "topology_agent_copy.xml.gz";
+                compressFile(topologyFile, copyTopoFile.string(), 9);
                 topologyFile = copyTopoFile.string();
                 LOG(info) << "Topology file compressed size: "
                           << dds::misc::HumanReadable{ fs::file_size(topologyFile) };
@@ -1373,8 +1638,10 @@ void CConnectionManager::updateTopology(const dds::tools_api::STopologyRequestDa
             }
 
             LOG(info) << "Broadcasting topology update with a file: " << topologyFile;
+            // The file is read once and its pieces are shared by all agents
+            SSharedBinaryAttachment::ptr_t topologyAttachment = SSharedBinaryAttachment::makeFromFile(topologyFile);
             broadcastUpdateTopologyAndWait<cmdUPDATE_TOPOLOGY>(
-                allAgents, _channel, "Updating topology for agents...", topologyFile, topFileDestName);
+                allAgents, _channel, "Updating topology for agents...", topologyAttachment, topFileDestName);
 
             if (!copyTopoFile.empty())
                 fs::remove(copyTopoFile);
@@ -1386,14 +1653,11 @@ void CConnectionManager::updateTopology(const dds::tools_api::STopologyRequestDa
         if (addedTasks.size() > 0)
         {
             LOG(info) << "Activating added tasks.";
-            auto idleCondition = [](const CConnectionManager::channelInfo_t& _v, bool& /*_stop*/)
-            {
-                return (_v.m_isSlot && _v.m_channel->getChannelType() == EChannelType::AGENT &&
-                        _v.m_channel->started() &&
-                        _v.m_channel->getAgentInfo().getSlotByID(_v.m_protocolHeaderID).m_state == EAgentState::idle);
-            };
+            auto startedCondition = [](const CConnectionManager::channelInfo_t& _v, bool& /*_stop*/)
+            { return _v.m_channel->started(); };
 
-            CConnectionManager::weakChannelInfo_t::container_t idleAgents(getChannels(idleCondition));
+            CConnectionManager::weakChannelInfo_t::container_t idleAgents(
+                getChannels(EChannelType::AGENT, true, EAgentState::idle, startedCondition));
 
             size_t nofAgents = idleAgents.size();
             if (nofAgents == 0)
@@ -1413,7 +1677,6 @@ void CConnectionManager::updateTopology(const dds::tools_api::STopologyRequestDa
 
             // Erase removed tasks
             {
-                lock_guard<mutex> lock(m_mapMutex);
                 for (auto taskID : removedTasks)
                 {
                     m_taskIDToAgentChannelMap.erase(taskID);
@@ -1422,7 +1685,7 @@ void CConnectionManager::updateTopology(const dds::tools_api::STopologyRequestDa
                 // Add new elements
                 for (const auto& sch : schedule)
                 {
-                    m_taskIDToAgentChannelMap[sch.m_taskID] = sch.m_weakChannelInfo;
+                    m_taskIDToAgentChannelMap.insert_or_assign(sch.m_taskID, sch.m_weakChannelInfo);
                 }
             }
 
@@ -1490,7 +1753,7 @@ void CConnectionManager::getLog(const dds::tools_api::SGetLogRequestData& _getLo
     auto condition = [](const CConnectionManager::channelInfo_t& _v, bool& /*_stop*/)
     { return (_v.m_channel->getChannelType() == EChannelType::AGENT && !_v.m_isSlot && _v.m_channel->started()); };
 
-    m_getLog.m_nofRequests = countNofChannels(condition);
+    m_getLog.m_nofRequests = countNofChannels(EChannelType::AGENT, false, condition);
 
     if (m_getLog.m_nofRequests == 0)
     {
@@ -1531,10 +1794,11 @@ void CConnectionManager::sendUICommanderInfo(const dds::tools_api::SCommanderInf
 void CConnectionManager::sendUIAgentInfo(const dds::tools_api::SAgentInfoRequestData& _info,
                                          CAgentChannel::weakConnectionPtr_t _channel)
 {
-    CConnectionManager::weakChannelInfo_t::container_t channels(getChannels(
-        [](const CConnectionManager::channelInfo_t& _v, bool& /*_stop*/) {
-            return (_v.m_channel->getChannelType() == EChannelType::AGENT && !_v.m_isSlot && _v.m_channel->started());
-        }));
+    CConnectionManager::weakChannelInfo_t::container_t channels(
+        getChannels(EChannelType::AGENT,
+                    false,
+                    [](const CConnectionManager::channelInfo_t& _v, bool& /*_stop*/)
+                    { return _v.m_channel->started(); }));
 
     // Enumerate all agents
     size_t count{ 0 };
@@ -1574,9 +1838,11 @@ void CConnectionManager::sendUIAgentInfo(const dds::tools_api::SAgentInfoRequest
 void CConnectionManager::sendUISlotInfo(const dds::tools_api::SSlotInfoRequestData& _info,
                                         CAgentChannel::weakConnectionPtr_t _channel)
 {
-    CConnectionManager::weakChannelInfo_t::container_t channels(getChannels(
-        [](const CConnectionManager::channelInfo_t& _v, bool& /*_stop*/)
-        { return _v.m_channel->getChannelType() == EChannelType::AGENT && !_v.m_isSlot && _v.m_channel->started(); }));
+    CConnectionManager::weakChannelInfo_t::container_t channels(
+        getChannels(EChannelType::AGENT,
+                    false,
+                    [](const CConnectionManager::channelInfo_t& _v, bool& /*_stop*/)
+                    { return _v.m_channel->started(); }));
 
     size_t count{ 0 };
     for (const auto& v : channels)
@@ -1608,36 +1874,15 @@ void CConnectionManager::sendUISlotInfo(const dds::tools_api::SSlotInfoRequestDa
 void CConnectionManager::sendUIAgentCount(const dds::tools_api::SAgentCountRequestData& _info,
                                           CAgentChannel::weakConnectionPtr_t _channel)
 {
-    auto isStartedSlot = [](const CConnectionManager::channelInfo_t& _v, bool& /*_stop*/)
-    { return _v.m_isSlot && _v.m_channel->getChannelType() == EChannelType::AGENT && _v.m_channel->started(); };
-    auto channels(getChannels(isStartedSlot));
-
     SAgentCountResponseData info;
     info.m_requestID = _info.m_requestID;
 
-    if (!channels.empty())
-    {
-        size_t activeCounter = channels.size();
-        size_t idleCounter = countNofChannels(
-            [&isStartedSlot](const CConnectionManager::channelInfo_t& _v, bool& _stop)
-            {
-                if (!isStartedSlot(_v, _stop))
-                    return false;
-                auto slot{ _v.m_channel->getAgentInfo().getSlotByID(_v.m_protocolHeaderID) };
-                return slot.m_taskID == 0 && slot.m_state == EAgentState::idle;
-            });
-        size_t executingCounter = countNofChannels(
-            [&isStartedSlot](const CConnectionManager::channelInfo_t& _v, bool& _stop)
-            {
-                if (!isStartedSlot(_v, _stop))
-                    return false;
-                auto slot{ _v.m_channel->getAgentInfo().getSlotByID(_v.m_protocolHeaderID) };
-                return slot.m_taskID > 0 && slot.m_state == EAgentState::executing;
-            });
-        info.m_activeSlotsCount = activeCounter;
-        info.m_idleSlotsCount = idleCounter;
-        info.m_executingSlotsCount = executingCounter;
-    }
+    // Slots are indexed by their state
+    auto condition = [](const CConnectionManager::channelInfo_t& _v, bool& /*_stop*/)
+    { return _v.m_channel->started(); };
+    info.m_activeSlotsCount = countNofChannels(EChannelType::AGENT, true, condition);
+    info.m_idleSlotsCount = countNofChannels(EChannelType::AGENT, true, EAgentState::idle, condition);
+    info.m_executingSlotsCount = countNofChannels(EChannelType::AGENT, true, EAgentState::executing, condition);
 
     sendCustomCommandResponse(_channel, info.toJSON());
     sendDoneResponse(_channel, _info.m_requestID);
@@ -1667,47 +1912,43 @@ void CConnectionManager::sendDoneResponse(CAgentChannel::weakConnectionPtr_t _ch
 void CConnectionManager::executeAgentCommand(const dds::tools_api::SAgentCommandRequestData& _info,
                                              CAgentChannel::weakConnectionPtr_t _channel)
 {
-    // get the list of active agents
-    CConnectionManager::weakChannelInfo_t::container_t channels(getChannels(
-        [](const CConnectionManager::channelInfo_t& _v, bool& /*_stop*/) {
-            return (_v.m_channel->getChannelType() == EChannelType::AGENT && !_v.m_isSlot && _v.m_channel->started());
-        }));
+    auto condition = [](const CConnectionManager::channelInfo_t& _v, bool& /*_stop*/)
+    { return _v.m_channel->started(); };
 
-    bool stop_loop{ false };
-    for (const auto& v : channels)
+    // Channels are indexed by the agent ID and the slot ID
+    CConnectionManager::weakChannelInfo_t::container_t channels;
+    switch (_info.m_commandType)
     {
-        if (stop_loop)
+        case SAgentCommandRequestData::EAgentCommandType::shutDownByID:
+            channels = getChannelsOfAgent(_info.m_arg1, condition);
             break;
+        case SAgentCommandRequestData::EAgentCommandType::shutDownBySlotID:
+        {
+            CConnectionManager::weakChannelInfo_t slot(getChannelByID(_info.m_arg1));
+            auto ptr = slot.m_channel.lock();
+            if (ptr && slot.m_isSlot && ptr->started())
+                channels.push_back(slot);
+            break;
+        }
+    }
 
-        if (v.m_channel.expired())
+    for (const auto& v : channels)
+    {
+        // The agent channel itself or the channel of the slot
+        if (v.m_isSlot != (_info.m_commandType == SAgentCommandRequestData::EAgentCommandType::shutDownBySlotID))
             continue;
         auto ptr{ v.m_channel.lock() };
-        SAgentInfo& inf{ ptr->getAgentInfo() };
+        if (!ptr)
+            continue;
 
-        switch (_info.m_commandType)
-        {
-            case SAgentCommandRequestData::EAgentCommandType::shutDownByID:
-                if (inf.m_id == _info.m_arg1)
-                {
-                    LOG(info) << "Executing a TOOLS API request to shutdown the agent by ID: " << _info.m_arg1;
-                    // send shutdown to the agent
-                    ptr->template pushMsg<cmdSHUTDOWN>();
-                    stop_loop = true;
-                }
-                break;
-            case SAgentCommandRequestData::EAgentCommandType::shutDownBySlotID:
-                auto slots{ inf.getSlots() };
-                auto it = slots.find(_info.m_arg1);
-                if (it != slots.end())
-                {
-                    LOG(info) << "Executing a TOOLS API request to shutdown the agent by SlotID: " << _info.m_arg1
-                              << " AgentID: " << inf.m_id;
-                    // send shutdown to the agent
-                    ptr->template pushMsg<cmdSHUTDOWN>();
-                    stop_loop = true;
-                }
-                break;
-        }
+        if (v.m_isSlot)
+            LOG(info) << "Executing a TOOLS API request to shutdown the agent by SlotID: " << _info.m_arg1
+                      << " AgentID: " << ptr->getAgentInfo().m_id;
+        else
+            LOG(info) << "Executing a TOOLS API request to shutdown the agent by ID: " << _info.m_arg1;
+        // send shutdown to the agent
+        ptr->template pushMsg<cmdSHUTDOWN>();
+        break;
     }
     sendDoneResponse(_channel, _info.m_requestID);
 }
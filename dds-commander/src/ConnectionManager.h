@@ -10,11 +10,14 @@
 #include "ConnectionManagerImpl.h"
 #include "Options.h"
 #include "Scheduler.h"
+#include "ShardedMap.h"
 #include "ToolsProtocol.h"
 #include "TopoCore.h"
 #include "UIChannelInfo.h"
 // STD
+#include <chrono>
 #include <mutex>
+#include <unordered_map>
 
 namespace dds
 {
@@ -31,7 +34,7 @@ namespace dds
             void newClientCreated(CAgentChannel::connectionPtr_t _newClient);
             void _start();
             void _stop();
-            void _createInfoFile(const std::vector<size_t>& _ports) const;
+            void _createInfoFile(const std::vector<size_t>& _ports, const std::string& _uiSocketPath) const;
             void _deleteInfoFile() const;
 
           private:
@@ -46,6 +49,14 @@ namespace dds
             void on_cmdREPLY(const protocol_api::SSenderInfo& _sender,
                              protocol_api::SCommandAttachmentImpl<protocol_api::cmdREPLY>::ptr_t _attachment,
                              CAgentChannel::weakConnectionPtr_t _channel);
+            void on_cmdREPLY_ASSIGN_USER_TASKS(
+                const protocol_api::SSenderInfo& _sender,
+                protocol_api::SCommandAttachmentImpl<protocol_api::cmdREPLY_ASSIGN_USER_TASKS>::ptr_t _attachment,
+                CAgentChannel::weakConnectionPtr_t _channel);
+            void on_cmdREPLY_CHECK_CACHED_FILES(
+                const protocol_api::SSenderInfo& _sender,
+                protocol_api::SCommandAttachmentImpl<protocol_api::cmdREPLY_CHECK_CACHED_FILES>::ptr_t _attachment,
+                CAgentChannel::weakConnectionPtr_t _channel);
             void on_cmdUPDATE_KEY(const protocol_api::SSenderInfo& _sender,
                                   protocol_api::SCommandAttachmentImpl<protocol_api::cmdUPDATE_KEY>::ptr_t _attachment,
                                   CAgentChannel::weakConnectionPtr_t _channel);
@@ -84,22 +95,27 @@ namespace dds
             template <protocol_api::ECmdType _cmd>
             void broadcastUpdateTopologyAndWait_impl(size_t index,
                                                      weakChannelInfo_t _agent,
-                                                     const std::string& _filePath,
+                                                     protocol_api::SSharedBinaryAttachment::ptr_t _file,
                                                      const std::string& _filename);
-            template <protocol_api::ECmdType _cmd>
-            void broadcastUpdateTopologyAndWait_impl(size_t index,
-                                                     weakChannelInfo_t _agent,
-                                                     const std::vector<std::string>& _filePaths,
-                                                     const std::vector<std::string>& _filenames);
-            template <protocol_api::ECmdType _cmd>
-            void broadcastUpdateTopologyAndWait_impl(
-                size_t index,
-                weakChannelInfo_t _agent,
-                const std::vector<typename protocol_api::SCommandAttachmentImpl<_cmd>::ptr_t>& _attachments);
 
             void activateTasks(const dds::tools_api::STopologyRequestData& _topologyInfo,
                                const CScheduler& _scheduler,
                                CAgentChannel::weakConnectionPtr_t _channel);
+            void processActivationReply(const protocol_api::SSenderInfo& _sender,
+                                        const protocol_api::SReplyCmd& _reply,
+                                        CAgentChannel::weakConnectionPtr_t _channel);
+            /// \brief Processes the reply of an agent to a file uploaded to its file cache.
+            void processCachedFileReply(const protocol_api::SReplyCmd& _reply,
+                                        CAgentChannel::weakConnectionPtr_t _channel);
+            /// \brief Sends one cmdASSIGN_USER_TASKS with all slots of the agent, which are still being activated.
+            void sendAgentAssignment(uint64_t _agentID);
+            /// \brief Sets the executing state of the slot and notifies the Tools API, before the task is activated.
+            void setSlotExecuting(CAgentChannel::connectionPtr_t _agent,
+                                  uint64_t _slotID,
+                                  uint64_t _taskID,
+                                  dds::tools_api::requestID_t _requestID,
+                                  CAgentChannel::weakConnectionPtr_t _channel);
+            void setSlotIdle(CAgentChannel::connectionPtr_t _agent, uint64_t _slotID);
             void _createWnPkg(bool _needInlineBashScript,
                               bool _lightweightPkg,
                               uint32_t _nSlots,
@@ -138,12 +154,54 @@ namespace dds
             topology_api::CTopoCore m_topo;
 
             // TODO: This is temporary storage only. Store this information as a part of scheduler.
-            typedef std::map<uint64_t, weakChannelInfo_t> TaskIDToAgentChannelMap_t;
+            /// Routing of cmdUPDATE_KEY is read-mostly, lookups of different tasks don't block each other
+            typedef dds::misc::CShardedMap<uint64_t, weakChannelInfo_t> TaskIDToAgentChannelMap_t;
             TaskIDToAgentChannelMap_t m_taskIDToAgentChannelMap;
-            std::mutex m_mapMutex;
 
             dds::misc::CConditionEvent m_updateTopoCondition;
 
+            /// Activation state of a slot. Each slot advances upload -> assign -> activate on its own replies.
+            struct SSlotActivation
+            {
+                enum class EStage
+                {
+                    upload,
+                    assign,
+                    activate
+                };
+
+                weakChannelInfo_t m_agent;
+                uint64_t m_taskID{ 0 };
+                EStage m_stage{ EStage::upload };
+                size_t m_nofUploads{ 0 }; ///< Number of uploads not yet confirmed by the agent
+                protocol_api::SCommandAttachmentImpl<protocol_api::cmdASSIGN_USER_TASK>::ptr_t m_assignment;
+                /// The agent assigns and activates its slots in one cmdASSIGN_USER_TASKS
+                bool m_isBatched{ false };
+                uint64_t m_agentID{ 0 };
+                dds::tools_api::requestID_t m_requestID{ 0 };  ///< Request of the UI, which activates the topology
+                CAgentChannel::weakConnectionPtr_t m_uiChannel; ///< Gets a notification about the activated task
+            };
+            /// Slots being activated by slot ID
+            typedef std::unordered_map<uint64_t, SSlotActivation> slotActivationMap_t;
+            slotActivationMap_t m_slotActivations;
+            /// Agents, which get a single cmdASSIGN_USER_TASKS once all uploads to their slots are confirmed
+            struct SAgentActivation
+            {
+                CAgentChannel::weakConnectionPtr_t m_channel;
+                /// Number of uploads to all slots or to the file cache not yet confirmed by the agent. The pending
+                /// cmdCHECK_CACHED_FILES counts as one upload.
+                size_t m_nofUploads{ 0 };
+                std::vector<uint64_t> m_slotIDs;
+                /// Files of all slots by content hash, uploaded once to the file cache if the agent supports it
+                std::map<std::string, protocol_api::SSharedBinaryAttachment::ptr_t> m_cachedFiles;
+            };
+            /// Agents being activated by agent ID
+            typedef std::unordered_map<uint64_t, SAgentActivation> agentActivationMap_t;
+            agentActivationMap_t m_agentActivations;
+            std::mutex m_mtxSlotActivations; ///< Guards activations of slots and agents
+            std::chrono::steady_clock::time_point m_activationStartTime;
+            std::chrono::steady_clock::time_point m_firstTaskActivationTime;
+
             // ToolsAPI's onTaskDone subscribers
             typedef std::pair<CAgentChannel::weakConnectionPtr_t, dds::tools_api::SOnTaskDoneRequestData>
                 onTaskDoneSubscriberInfo_t;
@@ -52,11 +52,16 @@ void CScheduler::makeScheduleImpl(CTopoCore& _topology,
                                   const CTopoCore::IdSet_t* _addedCollections)
 {
     m_schedule.clear();
+    m_hostToChannelMap.clear();
+    m_hosts.clear();
+    m_requirementMasks.clear();
+    m_elementMasks.clear();
+    m_elementCursors.clear();
 
     size_t nofChannels{ _channels.size() };
     // Map pair<host name, worker id> to vector of channel indexes.
     // This is needed in order to reduce number of regex matches and speed up scheduling.
-    hostToChannelMap_t hostToChannelMap;
+    hostToChannelMap_t& hostToChannelMap{ m_hostToChannelMap };
     for (size_t iChannel = 0; iChannel < nofChannels; ++iChannel)
     {
         const auto& v = _channels[iChannel];
@@ -74,11 +79,27 @@ void CScheduler::makeScheduleImpl(CTopoCore& _topology,
         hostToChannelMap[make_tuple(info.m_id, hostInfo.m_host, hostInfo.m_workerId, hostInfo.m_groupName)].push_back(
             iChannel);
     }
+    // Requirements are evaluated into masks indexed like the map
+    m_hosts.reserve(hostToChannelMap.size());
+    for (auto it = hostToChannelMap.begin(); it != hostToChannelMap.end(); ++it)
+        m_hosts.push_back(it);
+
+    // Collections and tasks are grouped by the number of requirements once
+    auto collections{ _topology.getRuntimeCollectionIterator() };
+    auto tasks{ _topology.getRuntimeTaskIterator() };
+    size_t maxRequirements{ 0 };
+    for (auto it = tasks.first; it != tasks.second; it++)
+    {
+        maxRequirements = max(maxRequirements, it->second.m_task->getNofRequirements());
+    }
+    for (auto it = collections.first; it != collections.second; it++)
+    {
+        maxRequirements = max(maxRequirements, it->second.m_collection->getNofRequirements());
+    }
 
     // Collect all tasks that belong to collections
     set<uint64_t> tasksInCollections;
-    CollectionMap_t collectionMap;
-    auto collections{ _topology.getRuntimeCollectionIterator() };
+    vector<CollectionMap_t> collectionsByRequirements(maxRequirements + 1);
     for (auto it = collections.first; it != collections.second; it++)
     {
         // Only collections that were added has to be scheduled
@@ -87,40 +108,32 @@ void CScheduler::makeScheduleImpl(CTopoCore& _topology,
 
         const auto& taskMap = it->second.m_idToRuntimeTaskMap;
         boost::copy(taskMap | boost::adaptors::map_keys, std::inserter(tasksInCollections, tasksInCollections.end()));
-        collectionMap[it->second.m_idToRuntimeTaskMap.size()].push_back(it->first);
+        collectionsByRequirements[it->second.m_collection->getNofRequirements()][taskMap.size()].push_back(it->first);
     }
 
-    // Maximum number of requirements per task or collection
-    size_t maxRequirements{ 0 };
-    auto tasks{ _topology.getRuntimeTaskIterator() };
+    vector<TaskVector_t> tasksByRequirements(maxRequirements + 1);
     for (auto it = tasks.first; it != tasks.second; it++)
     {
-        maxRequirements = max(maxRequirements, it->second.m_task->getNofRequirements());
-    }
-    for (auto it = collections.first; it != collections.second; it++)
-    {
-        maxRequirements = max(maxRequirements, it->second.m_collection->getNofRequirements());
+        // Check if tasks is in the added tasks
+        if (_addedTasks != nullptr && _addedTasks->find(it->first) == _addedTasks->end())
+            continue;
+
+        // Check if task has to be scheduled in the collection
+        if (tasksInCollections.find(it->first) != tasksInCollections.end())
+            continue;
+
+        tasksByRequirements[it->second.m_task->getNofRequirements()].emplace_back(it->first, &it->second);
     }
 
     // Counters of number of instances of tasks/collections on a host.
     hostCounterMap_t taskHostCounter;
     hostCounterMap_t collectionHostCounter;
 
-    set<uint64_t> scheduledTasks;
-
     // First schedule collections and tasks with more requirements
     for (int i = maxRequirements; i >= 0; i--)
     {
-        scheduleCollections(
-            _topology, _channels, hostToChannelMap, scheduledTasks, collectionMap, i, collectionHostCounter);
-        scheduleTasks(_topology,
-                      _channels,
-                      hostToChannelMap,
-                      scheduledTasks,
-                      tasksInCollections,
-                      i,
-                      _addedTasks,
-                      taskHostCounter);
+        scheduleCollections(_topology, _channels, collectionsByRequirements[i], collectionHostCounter);
+        scheduleTasks(_channels, tasksByRequirements[i], taskHostCounter);
     }
 
     size_t totalNofTasks =
@@ -137,76 +150,22 @@ void CScheduler::makeScheduleImpl(CTopoCore& _topology,
     LOG(debug) << toString();
 }
 
-void CScheduler::scheduleTasks(const CTopoCore& _topology,
-                               const weakChannelInfoVector_t& _channels,
-                               hostToChannelMap_t& _hostToChannelMap,
-                               set<uint64_t>& _scheduledTasks,
-                               const set<uint64_t>& _tasksInCollections,
-                               size_t _numRequirements,
-                               const CTopoCore::IdSet_t* _addedTasks,
+void CScheduler::scheduleTasks(const weakChannelInfoVector_t& _channels,
+                               const TaskVector_t& _tasks,
                                hostCounterMap_t& _hostCounterMap)
 {
-    STopoRuntimeTask::FilterIteratorPair_t tasks{ _topology.getRuntimeTaskIterator() };
-    for (auto it = tasks.first; it != tasks.second; it++)
+    for (const auto& it : _tasks)
     {
-        uint64_t id{ it->first };
+        uint64_t id{ it.first };
+        CTopoTask::Ptr_t task{ it.second->m_task };
 
-        // Check if tasks is in the added tasks
-        if (_addedTasks != nullptr && _addedTasks->find(it->first) == _addedTasks->end())
-            continue;
-
-        // Check if task has to be scheduled in the collection
-        if (_tasksInCollections.find(id) != _tasksInCollections.end())
-            continue;
-
-        // Check if task was already scheduled in the collection
-        if (_scheduledTasks.find(id) != _scheduledTasks.end())
-            continue;
-
-        CTopoTask::Ptr_t task{ it->second.m_task };
-
-        if (task->getNofRequirements() != _numRequirements)
-            continue;
-
-        bool taskAssigned{ false };
-
-        for (auto& v : _hostToChannelMap)
-        {
-            const string hostName{ std::get<1>(v.first) };
-            const string wnName{ std::get<2>(v.first) };
-            const string groupName{ std::get<3>(v.first) };
-            const bool requirementOk{ checkRequirements(
-                task->getRequirements(), hostName, wnName, groupName, task->getName(), _hostCounterMap) };
-            if (requirementOk)
-            {
-                if (!v.second.empty())
-                {
-                    size_t channelIndex = v.second.back();
-                    const auto& channel = _channels[channelIndex];
-
-                    SSchedule schedule;
-                    schedule.m_weakChannelInfo = channel;
-                    schedule.m_taskInfo = it->second;
-                    schedule.m_taskID = id;
-                    m_schedule.push_back(schedule);
-
-                    v.second.pop_back();
-
-                    // Increase counter of task on the host
-                    _hostCounterMap[make_pair(hostName, task->getName())]++;
-
-                    taskAssigned = true;
-
-                    break;
-                }
-            }
-        }
-        if (!taskAssigned)
+        const size_t hostIndex{ findHost(task.get(), task->getRequirements(), 1, _hostCounterMap) };
+        if (hostIndex == hostMask_t::npos)
         {
             LOG(debug) << toString();
             stringstream ss;
             string requirementStr{ "Not enough worker nodes." };
-            if (_numRequirements > 0)
+            if (task->getNofRequirements() > 0)
             {
                 vector<string> strs;
                 transform(task->getRequirements().begin(),
@@ -219,15 +178,27 @@ void CScheduler::scheduleTasks(const CTopoCore& _topology,
             ss << "Unable to schedule task <" << id << "> with path " << task->getPath() << ": " << requirementStr;
             throw runtime_error(ss.str());
         }
+
+        auto& v{ *m_hosts[hostIndex] };
+        size_t channelIndex = v.second.back();
+        const auto& channel = _channels[channelIndex];
+
+        SSchedule schedule;
+        schedule.m_weakChannelInfo = channel;
+        schedule.m_taskInfo = *it.second;
+        schedule.m_taskID = id;
+        m_schedule.push_back(schedule);
+
+        v.second.pop_back();
+
+        // Increase counter of task on the host
+        _hostCounterMap[make_pair(std::get<1>(v.first), task->getName())]++;
     }
 }
 
 void CScheduler::scheduleCollections(CTopoCore& _topology,
                                      const weakChannelInfoVector_t& _channels,
-                                     hostToChannelMap_t& _hostToChannelMap,
-                                     set<uint64_t>& _scheduledTasks,
                                      const CollectionMap_t& _collectionMap,
-                                     size_t _numRequirements,
                                      hostCounterMap_t& _hostCounterMap)
 {
     for (const auto& it_col : _collectionMap)
@@ -237,131 +208,152 @@ void CScheduler::scheduleCollections(CTopoCore& _topology,
             const STopoRuntimeCollection& collectionInfo = _topology.getRuntimeCollectionById(id);
             auto collection{ collectionInfo.m_collection };
 
-            if (collection->getNofRequirements() != _numRequirements)
-                continue;
-
-            bool collectionAssigned{ false };
-
-            for (auto& v : _hostToChannelMap)
-            {
-                const string hostName{ std::get<1>(v.first) };
-                const string wnName{ std::get<2>(v.first) };
-                const string groupName{ std::get<3>(v.first) };
-                const bool requirementOk{ checkRequirements(collection->getRequirements(),
-                                                            hostName,
-                                                            wnName,
-                                                            groupName,
-                                                            collection->getName(),
-                                                            _hostCounterMap) };
-                if ((v.second.size() >= collectionInfo.m_collection->getNofTasks()) && requirementOk)
-                {
-                    const STopoRuntimeCollection& collectionInfo{ _topology.getRuntimeCollectionById(id) };
-
-                    for (auto taskIt : collectionInfo.m_idToRuntimeTaskMap)
-                    {
-                        const STopoRuntimeTask& info = taskIt.second;
-
-                        size_t channelIndex = v.second.back();
-                        const auto& channel = _channels[channelIndex];
-
-                        SSchedule schedule;
-                        schedule.m_weakChannelInfo = channel;
-                        schedule.m_taskInfo = info;
-                        schedule.m_taskID = taskIt.first;
-                        m_schedule.push_back(schedule);
-
-                        v.second.pop_back();
-
-                        _scheduledTasks.insert(taskIt.first);
-                    }
-
-                    // Increase counter of collection on the host
-                    _hostCounterMap[make_pair(hostName, collection->getName())]++;
-
-                    collectionAssigned = true;
-                    break;
-                }
-            }
-
-            if (!collectionAssigned)
+            const size_t hostIndex{ findHost(
+                collection.get(), collection->getRequirements(), collection->getNofTasks(), _hostCounterMap) };
+            if (hostIndex == hostMask_t::npos)
             {
                 LOG(debug) << toString();
                 stringstream ss;
                 ss << "Unable to schedule collection <" << id << "> with path " << collection->getPath();
                 throw runtime_error(ss.str());
             }
+
+            auto& v{ *m_hosts[hostIndex] };
+            for (const auto& taskIt : collectionInfo.m_idToRuntimeTaskMap)
+            {
+                const STopoRuntimeTask& info = taskIt.second;
+
+                size_t channelIndex = v.second.back();
+                const auto& channel = _channels[channelIndex];
+
+                SSchedule schedule;
+                schedule.m_weakChannelInfo = channel;
+                schedule.m_taskInfo = info;
+                schedule.m_taskID = taskIt.first;
+                m_schedule.push_back(schedule);
+
+                v.second.pop_back();
+            }
+
+            // Increase counter of collection on the host
+            _hostCounterMap[make_pair(std::get<1>(v.first), collection->getName())]++;
         }
     }
 }
 
-bool CScheduler::checkRequirements(const topology_api::CTopoRequirement::PtrVector_t& _requirements,
-                                   const string& _hostName,
-                                   const string& _wnName,
-                                   const string& _groupName,
-                                   const string& _elementName,
-                                   hostCounterMap_t& _hostCounterMap) const
+size_t CScheduler::findHost(const CTopoElement* _element,
+                            const CTopoRequirement::PtrVector_t& _requirements,
+                            size_t _nofSlots,
+                            hostCounterMap_t& _hostCounterMap)
 {
-    if (_requirements.empty())
-        return true;
+    const hostMask_t& mask{ getRequirementsMask(_element, _requirements) };
+    size_t& cursor{ m_elementCursors.emplace(_element, 0).first->second };
 
-    using EType = CTopoRequirement::EType;
+    size_t i{ (cursor < mask.size() && mask.test(cursor)) ? cursor : mask.find_next(cursor) };
+    for (; i != hostMask_t::npos; i = mask.find_next(i))
+    {
+        const auto& v{ *m_hosts[i] };
+        if (v.second.size() < _nofSlots)
+            continue;
+        if (checkInstanceRequirements(_requirements, std::get<1>(v.first), _element->getName(), _hostCounterMap))
+            break;
+    }
+    cursor = (i == hostMask_t::npos) ? mask.size() : i;
+    return i;
+}
 
-    bool result{ false };
+const CScheduler::hostMask_t& CScheduler::getRequirementsMask(const CTopoElement* _element,
+                                                              const CTopoRequirement::PtrVector_t& _requirements)
+{
+    auto it = m_elementMasks.find(_element);
+    if (it != m_elementMasks.end())
+        return it->second;
+
+    // All requirements must be satisfied at the same time
+    hostMask_t mask(m_hosts.size());
+    mask.set();
     for (const auto& requirement : _requirements)
     {
-        const auto type{ requirement->getRequirementType() };
+        mask &= getRequirementMask(*requirement);
+        if (mask.none())
+            break;
+    }
+    return m_elementMasks.emplace(_element, std::move(mask)).first->second;
+}
 
-        if (type == EType::WnName && _wnName.empty())
-        {
-            LOG(warning) << "Requirement of type WnName is not supported for this RMS plug-in. Requirement: "
-                         << requirement->toString();
-            result = true;
-        }
-        else if (type == EType::WnName || type == EType::HostName)
-        {
-            result = CScheduler::hostPatternMatches(requirement->getValue(),
-                                                    (type == EType::HostName) ? _hostName : _wnName);
-        }
-        else if (type == EType::GroupName)
-        {
-            result = CScheduler::hostPatternMatches(requirement->getValue(), _groupName);
-        }
-        else if (type == EType::MaxInstancesPerHost)
+const CScheduler::hostMask_t& CScheduler::getRequirementMask(const CTopoRequirement& _requirement)
+{
+    using EType = CTopoRequirement::EType;
+
+    const auto type{ _requirement.getRequirementType() };
+    const auto key{ make_pair(type, _requirement.getValue()) };
+    auto it = m_requirementMasks.find(key);
+    if (it != m_requirementMasks.end())
+        return it->second;
+
+    hostMask_t mask(m_hosts.size());
+    if (type == EType::WnName || type == EType::HostName || type == EType::GroupName)
+    {
+        // Compile the pattern once and match each distinct name once
+        const string& pattern{ _requirement.getValue() };
+        const boost::regex e(pattern.empty() ? string(".*") : pattern);
+        map<string, bool> matches;
+        for (size_t i = 0; i < m_hosts.size(); ++i)
         {
-            try
-            {
-                size_t value = boost::lexical_cast<size_t>(requirement->getValue());
-                const auto key{ make_pair(_hostName, _elementName) };
-                auto it = _hostCounterMap.find(key);
-                if (it != _hostCounterMap.end())
-                {
-                    result = it->second < value;
-                }
-                else
-                {
-                    result = true;
-                }
-            }
-            catch (boost::bad_lexical_cast&)
+            const auto& host{ m_hosts[i]->first };
+            const string& name{ (type == EType::HostName) ? std::get<1>(host)
+                                : (type == EType::WnName) ? std::get<2>(host)
+                                                          : std::get<3>(host) };
+            if (type == EType::WnName && name.empty())
             {
-                stringstream ss;
-                ss << "Unable to satisfy the requirement " << requirement->getName() << ". Value "
-                   << requirement->getValue() << " must be a positive number.";
-                throw runtime_error(ss.str());
+                LOG(warning) << "Requirement of type WnName is not supported for this RMS plug-in. Requirement: "
+                             << _requirement.toString();
+                mask.set(i);
+                continue;
             }
+
+            auto match = matches.find(name);
+            if (match == matches.end())
+                match = matches.emplace(name, boost::regex_match(name, e)).first;
+            mask.set(i, match->second);
+        }
+    }
+    else if (type == EType::MaxInstancesPerHost || type == EType::Custom)
+    {
+        // MaxInstancesPerHost depends on already scheduled tasks and is checked per host, custom requirements are
+        // ignored
+        mask.set();
+    }
+    return m_requirementMasks.emplace(key, std::move(mask)).first->second;
+}
+
+bool CScheduler::checkInstanceRequirements(const topology_api::CTopoRequirement::PtrVector_t& _requirements,
+                                           const string& _hostName,
+                                           const string& _elementName,
+                                           hostCounterMap_t& _hostCounterMap) const
+{
+    for (const auto& requirement : _requirements)
+    {
+        if (requirement->getRequirementType() != CTopoRequirement::EType::MaxInstancesPerHost)
+            continue;
+
+        try
+        {
+            size_t value = boost::lexical_cast<size_t>(requirement->getValue());
+            const auto key{ make_pair(_hostName, _elementName) };
+            auto it = _hostCounterMap.find(key);
+            if (it != _hostCounterMap.end() && it->second >= value)
+                return false;
         }
-        else if (type == EType::Custom)
+        catch (boost::bad_lexical_cast&)
         {
-            // ignore custom requirements
-            result = true;
+            stringstream ss;
+            ss << "Unable to satisfy the requirement " << requirement->getName() << ". Value "
+               << requirement->getValue() << " must be a positive number.";
+            throw runtime_error(ss.str());
         }
-
-        // All requirements must be satisfied at the same time
-        if (!result)
-            break;
     }
-
-    return result;
+    return true;
 }
 
 const CScheduler::ScheduleVector_t& CScheduler::getSchedule() const
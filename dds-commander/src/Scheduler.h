@@ -12,6 +12,8 @@
 #include "TopoTask.h"
 // STD
 #include <vector>
+// BOOST
+#include <boost/dynamic_bitset.hpp>
 
 namespace dds
 {
@@ -35,6 +37,7 @@ namespace dds
             using ScheduleVector_t = std::vector<SSchedule>;
             using CollectionMap_t = std::map<size_t, std::vector<uint64_t>, std::greater<size_t>>;
             using weakChannelInfoVector_t = std::vector<dds::protocol_api::SWeakChannelInfo<CAgentChannel>>;
+            using TaskVector_t = std::vector<std::pair<uint64_t, const topology_api::STopoRuntimeTask*>>;
 
           private:
             // Map tuple<agent ID, host name, worker id, group name> to vector of channel indexes.
@@ -42,6 +45,16 @@ namespace dds
                 std::map<std::tuple<uint64_t, std::string, std::string, std::string>, std::vector<size_t>>;
             // Map pair<host name, task/collection name> to counter.
             using hostCounterMap_t = std::map<std::pair<std::string, std::string>, size_t>;
+            // Bit i is set if the requirements are satisfied by the i-th entry of the host to channel map.
+            using hostMask_t = boost::dynamic_bitset<>;
+            using hostIterators_t = std::vector<hostToChannelMap_t::iterator>;
+            // Map pair<requirement type, requirement value> to the mask of matching hosts.
+            using requirementMaskMap_t =
+                std::map<std::pair<topology_api::CTopoRequirement::EType, std::string>, hostMask_t>;
+            // Map task/collection to the combined mask of its requirements.
+            using elementMaskMap_t = std::map<const topology_api::CTopoElement*, hostMask_t>;
+            // Map task/collection to the index of the first host, which might still accept it.
+            using elementCursorMap_t = std::map<const topology_api::CTopoElement*, size_t>;
 
           public:
             CScheduler();
@@ -68,31 +81,46 @@ namespace dds
 
             void scheduleCollections(topology_api::CTopoCore& _topology,
                                      const weakChannelInfoVector_t& _channels,
-                                     hostToChannelMap_t& _hostToChannelMap,
-                                     std::set<uint64_t>& _scheduledTasks,
                                      const CollectionMap_t& _collectionMap,
-                                     size_t _numRequirements,
                                      hostCounterMap_t& _hostCounterMap);
 
-            void scheduleTasks(const topology_api::CTopoCore& _topology,
-                               const weakChannelInfoVector_t& _channels,
-                               hostToChannelMap_t& _hostToChannelMap,
-                               std::set<uint64_t>& _scheduledTasks,
-                               const std::set<uint64_t>& _tasksInCollections,
-                               size_t _numRequirements,
-                               const topology_api::CTopoCore::IdSet_t* _addedTasks,
+            void scheduleTasks(const weakChannelInfoVector_t& _channels,
+                               const TaskVector_t& _tasks,
                                hostCounterMap_t& _hostCounterMap);
 
-            // TODO: host, wn and group names should be provided via a struct.
-            bool checkRequirements(const topology_api::CTopoRequirement::PtrVector_t& _requirements,
-                                   const std::string& _hostName,
-                                   const std::string& _wnName,
-                                   const std::string& _groupName,
-                                   const std::string& _elementName,
-                                   hostCounterMap_t& _hostCounterMap) const;
+            /// \brief Returns the index of the first host with at least _nofSlots free slots, which satisfies the
+            /// requirements of the task or collection, or hostMask_t::npos.
+            /// \details Hosts never get free slots back and instance counters never decrease during scheduling. Thus
+            /// a host rejected once for an element is rejected for good and the search continues from a cursor
+            /// stored per element. All searches of an element take O(number of hosts) in total.
+            size_t findHost(const topology_api::CTopoElement* _element,
+                            const topology_api::CTopoRequirement::PtrVector_t& _requirements,
+                            size_t _nofSlots,
+                            hostCounterMap_t& _hostCounterMap);
+
+            /// \brief Returns the mask of hosts, which satisfy all host, worker node and group name requirements of
+            /// the task or collection. The mask is calculated once per element.
+            const hostMask_t& getRequirementsMask(const topology_api::CTopoElement* _element,
+                                                  const topology_api::CTopoRequirement::PtrVector_t& _requirements);
+
+            /// \brief Returns the mask of hosts, which satisfy the requirement. The pattern of the requirement is
+            /// compiled once and matched once per distinct name.
+            const hostMask_t& getRequirementMask(const topology_api::CTopoRequirement& _requirement);
+
+            /// \brief Checks requirements, which depend on the tasks already scheduled on the host.
+            bool checkInstanceRequirements(const topology_api::CTopoRequirement::PtrVector_t& _requirements,
+                                           const std::string& _hostName,
+                                           const std::string& _elementName,
+                                           hostCounterMap_t& _hostCounterMap) const;
 
           private:
             ScheduleVector_t m_schedule;
+            // Requirement cache of the current makeSchedule call
+            hostToChannelMap_t m_hostToChannelMap;
+            hostIterators_t m_hosts; ///< Entries of m_hostToChannelMap by mask index
+            requirementMaskMap_t m_requirementMasks;
+            elementMaskMap_t m_elementMasks;
+            elementCursorMap_t m_elementCursors;
         };
     } // namespace commander_cmd
 } // namespace dds
@@ -12,10 +12,13 @@
 #include "ToolsProtocol.h"
 // STD
 #include <chrono>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <vector>
 // BOOST
+#include <boost/asio/steady_timer.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
 namespace dds
@@ -33,6 +36,8 @@ namespace dds
                 , m_nofReceivedErrors(0)
                 , m_shutdownOnComplete(false)
                 , m_srcCommand(0)
+                , m_reportInterval(100)
+                , m_isAgentMessagesEnabled(true)
                 , m_startTime(std::chrono::steady_clock::now())
             {
             }
@@ -51,10 +56,15 @@ namespace dds
           public:
             void zeroCounters()
             {
+                // The report timer runs in the thread of the UI channel
+                std::lock_guard<std::mutex> lock(m_mutexReceive);
                 m_nofRequests = 0;
                 m_nofReceived = 0;
                 m_nofReceivedErrors = 0;
                 m_startTime = std::chrono::steady_clock::now();
+                m_lastReportTime = std::chrono::steady_clock::time_point();
+                m_pendingMessages.clear();
+                cancelReportTimer();
             }
 
           public:
@@ -69,21 +79,13 @@ namespace dds
 
                     ++m_nofReceived;
 
-                    T* pThis = static_cast<T*>(this);
-                    std::string userMessage = pThis->getMessage(_sender, _cmd, _channel);
-
-                    sendUIMessage(userMessage);
-
-                    // measure time to activate
-                    std::chrono::steady_clock::time_point curTime = std::chrono::steady_clock::now();
-
-                    sendUIProgress(dds::tools_api::SProgressResponseData(
-                        m_srcCommand,
-                        m_nofReceived,
-                        m_nofRequests,
-                        m_nofReceivedErrors,
-                        std::chrono::duration_cast<std::chrono::milliseconds>(curTime - m_startTime).count()));
+                    if (m_isAgentMessagesEnabled)
+                    {
+                        T* pThis = static_cast<T*>(this);
+                        queueUIMessage(pThis->getMessage(_sender, _cmd, _channel));
+                    }
 
+                    reportUI();
                     checkAllReceived();
                 }
                 catch (std::bad_weak_ptr& e)
@@ -105,20 +107,13 @@ namespace dds
 
                     ++m_nofReceivedErrors;
 
+                    // Errors are reported even if messages of agents are disabled
                     T* pThis = static_cast<T*>(this);
-                    std::string userMessage = pThis->getErrorMessage(_sender, _cmd, _channel);
-
-                    sendUIMessage(userMessage, dds::intercom_api::EMsgSeverity::error);
-
-                    // measure time to activate
-                    std::chrono::steady_clock::time_point curTime = std::chrono::steady_clock::now();
-                    sendUIProgress(dds::tools_api::SProgressResponseData(
-                        m_srcCommand,
-                        m_nofReceived,
-                        m_nofRequests,
-                        m_nofReceivedErrors,
-                        std::chrono::duration_cast<std::chrono::milliseconds>(curTime - m_startTime).count()));
+                    queueUIMessage(pThis->getErrorMessage(_sender, _cmd, _channel),
+                                   dds::intercom_api::EMsgSeverity::error);
 
+                    // Errors are not held back
+                    reportUI(true);
                     checkAllReceived();
                 }
                 catch (std::bad_weak_ptr& e)
@@ -156,7 +151,7 @@ namespace dds
                 }
             }
 
-            void sendUIProgress(const dds::tools_api::SProgressResponseData& _progress)
+            void doneWithUI()
             {
                 try
                 {
@@ -166,10 +161,10 @@ namespace dds
                     auto pUI = m_channel.lock();
                     if (pUI)
                     {
+                        dds::tools_api::SDoneResponseData done;
+                        done.m_requestID = m_requestID;
                         protocol_api::SCustomCmdCmd cmd;
-                        dds::tools_api::SProgressResponseData progress(_progress);
-                        progress.m_requestID = m_requestID;
-                        cmd.m_sCmd = progress.toJSON();
+                        cmd.m_sCmd = done.toJSON();
                         cmd.m_sCondition = "";
                         pUI->template pushMsg<protocol_api::cmdCUSTOM_CMD>(cmd);
                     }
@@ -179,30 +174,120 @@ namespace dds
                 }
             }
 
-            void doneWithUI()
+          private:
+            void queueUIMessage(const std::string& _msg,
+                                dds::intercom_api::EMsgSeverity _severity = dds::intercom_api::EMsgSeverity::info)
+            {
+                dds::tools_api::SMessageResponseData msg;
+                msg.m_requestID = m_requestID;
+                msg.m_msg = _msg;
+                msg.m_severity = _severity;
+                m_pendingMessages.push_back(msg);
+            }
+
+            /// \brief Sends the queued messages and the progress in one custom command, at most once per
+            /// m_reportInterval.
+            /// \details The first reply after a quiet period is reported right away, the replies of a burst are
+            /// aggregated and reported at the end of the interval. The report of the last reply is always sent. The
+            /// Tools API client processes all children of the JSON in order, thus messages keep their tag and the
+            /// progress follows them.
+            /// \param _force Report right away, e.g. errors.
+            void reportUI(bool _force = false)
             {
+                const std::chrono::steady_clock::time_point curTime = std::chrono::steady_clock::now();
+                if (!_force && !allReceived() && curTime - m_lastReportTime < m_reportInterval)
+                {
+                    scheduleReportUI();
+                    return;
+                }
+                cancelReportTimer();
+                m_lastReportTime = curTime;
+
+                std::vector<dds::tools_api::SMessageResponseData> messages;
+                messages.swap(m_pendingMessages);
+
                 try
                 {
                     if (m_channel.expired())
                         return;
 
                     auto pUI = m_channel.lock();
-                    if (pUI)
+                    if (!pUI)
+                        return;
+
+                    boost::property_tree::ptree pt;
+                    for (const auto& msg : messages)
                     {
-                        dds::tools_api::SDoneResponseData done;
-                        done.m_requestID = m_requestID;
-                        protocol_api::SCustomCmdCmd cmd;
-                        cmd.m_sCmd = done.toJSON();
-                        cmd.m_sCondition = "";
-                        pUI->template pushMsg<protocol_api::cmdCUSTOM_CMD>(cmd);
+                        boost::property_tree::ptree ptMsg;
+                        msg.toPT(ptMsg);
+                        pt.add_child("dds.tools-api.message", ptMsg);
                     }
+
+                    dds::tools_api::SProgressResponseData progress(
+                        m_srcCommand,
+                        m_nofReceived,
+                        m_nofRequests,
+                        m_nofReceivedErrors,
+                        std::chrono::duration_cast<std::chrono::milliseconds>(curTime - m_startTime).count());
+                    progress.m_requestID = m_requestID;
+                    boost::property_tree::ptree ptProgress;
+                    progress.toPT(ptProgress);
+                    pt.add_child("dds.tools-api.progress", ptProgress);
+
+                    std::stringstream json;
+                    boost::property_tree::write_json(json, pt);
+
+                    protocol_api::SCustomCmdCmd cmd;
+                    cmd.m_sCmd = json.str();
+                    cmd.m_sCondition = "";
+                    // A report without messages supersedes the previous one, like a progress report
+                    if (allReceived() || !messages.empty())
+                        pUI->template pushMsg<protocol_api::cmdCUSTOM_CMD>(cmd);
+                    else
+                        pUI->template pushCoalescibleMsg<protocol_api::cmdCUSTOM_CMD>(cmd);
                 }
                 catch (...)
                 {
                 }
             }
 
-          private:
+            /// \brief Reports the held back replies at the end of the current interval, unless another reply reports
+            /// them before.
+            void scheduleReportUI()
+            {
+                if (m_reportTimer != nullptr)
+                    return;
+
+                auto pUI = m_channel.lock();
+                if (!pUI)
+                    return;
+
+                // The timer runs in the thread of the UI channel
+                auto timer = std::make_shared<boost::asio::steady_timer>(pUI->socket().get_executor());
+                timer->expires_at(m_lastReportTime + m_reportInterval);
+                timer->async_wait(
+                    [this, timer](const boost::system::error_code& _ec)
+                    {
+                        if (_ec)
+                            return;
+                        std::lock_guard<std::mutex> lock(m_mutexReceive);
+                        // The timer was cancelled after it has expired
+                        if (m_reportTimer != timer)
+                            return;
+                        m_reportTimer.reset();
+                        reportUI(true);
+                    });
+                m_reportTimer = timer;
+            }
+
+            void cancelReportTimer()
+            {
+                if (m_reportTimer == nullptr)
+                    return;
+                m_reportTimer->cancel();
+                m_reportTimer.reset();
+            }
+
             void checkAllReceived()
             {
                 try
@@ -239,9 +324,14 @@ namespace dds
             bool m_shutdownOnComplete;
             uint16_t m_srcCommand;
             dds::tools_api::requestID_t m_requestID = 0;
+            std::chrono::milliseconds m_reportInterval; ///< Minimal interval between reports of replies to the UI
+            bool m_isAgentMessagesEnabled;              ///< Report a message for each successful reply of an agent
 
           private:
             std::chrono::steady_clock::time_point m_startTime;
+            std::chrono::steady_clock::time_point m_lastReportTime;
+            std::vector<dds::tools_api::SMessageResponseData> m_pendingMessages; ///< Messages of the current interval
+            std::shared_ptr<boost::asio::steady_timer> m_reportTimer;            ///< Reports held back replies
         };
 
         class CGetLogChannelInfo : public CUIChannelInfo<CGetLogChannelInfo>
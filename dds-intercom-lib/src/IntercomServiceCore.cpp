@@ -117,6 +117,10 @@ void CIntercomServiceCore::setupSMChannel()
     {
         throw runtime_error("Failed to initialize SM channel");
     }
+
+    // The agent delivers task done events only to tasks which subscribed on them
+    if (!m_keyValueTaskDoneSignal.empty())
+        m_SMChannel->pushMsg<cmdSUBSCRIBE_ON_TASK_DONE>(SEmptyCmd(), slotID);
 }
 
 void CIntercomServiceCore::setupChannel(const std::string& _sessionID)
@@ -138,6 +142,7 @@ void CIntercomServiceCore::setupChannel(const std::string& _sessionID)
     const string sCommanderCfg(CUserDefaults::instance().getServerInfoFileLocation());
     string sHost;
     string sPort;
+    string sSocket;
     EChannelType channelType(EChannelType::UNKNOWN);
     if (fs::exists(sCommanderCfg))
     {
@@ -146,6 +151,7 @@ void CIntercomServiceCore::setupChannel(const std::string& _sessionID)
         boost::property_tree::ini_parser::read_ini(sCommanderCfg, pt);
         sHost = pt.get<string>("ui.host");
         sPort = pt.get<string>("ui.port");
+        sSocket = pt.get<string>("ui.socket", "");
         channelType = EChannelType::UI;
     }
     else
@@ -153,12 +159,23 @@ void CIntercomServiceCore::setupChannel(const std::string& _sessionID)
         throw runtime_error("Cannot find DDS commander info file.");
     }
 
-    LOG(info) << "Contacting DDS commander on " << sHost << ":" << sPort;
+    CAgentChannel::endpoints_t endpoints;
+    // Clients on the same host as the commander prefer its Unix domain socket. TCP is the fallback.
+    if (!sSocket.empty() && fs::exists(sSocket))
+    {
+        LOG(info) << "Contacting DDS commander on " << sSocket << ", falling back to " << sHost << ":" << sPort;
+        endpoints.push_back(boost::asio::local::stream_protocol::endpoint(sSocket));
+    }
+    else
+    {
+        LOG(info) << "Contacting DDS commander on " << sHost << ":" << sPort;
+    }
 
-    // Resolve endpoint iterator from host and port
+    // Resolve endpoints from host and port
     boost::asio::ip::tcp::resolver resolver(m_io_context);
     boost::asio::ip::tcp::resolver::query query(sHost, sPort);
-    boost::asio::ip::tcp::resolver::iterator endpoint_iterator = resolver.resolve(query);
+    for (auto it = resolver.resolve(query); it != boost::asio::ip::tcp::resolver::iterator(); ++it)
+        endpoints.push_back(it->endpoint());
 
     // Create new communication channel and push handshake message
     m_channel = CAgentChannel::makeNew(m_io_context, 0);
@@ -199,7 +216,7 @@ void CIntercomServiceCore::setupChannel(const std::string& _sessionID)
                 });
         });
 
-    m_channel->connect(endpoint_iterator);
+    m_channel->connect(endpoints);
 }
 
 void CIntercomServiceCore::stop()
@@ -247,7 +264,11 @@ connection_t CIntercomServiceCore::connectKeyValue(keyValueSignal_t::slot_functi
 
 connection_t CIntercomServiceCore::connectKeyValueTaskDone(keyValueTaskDoneSignal_t::slot_function_type _subscriber)
 {
-    return m_keyValueTaskDoneSignal.connect(_subscriber);
+    connection_t connection = m_keyValueTaskDoneSignal.connect(_subscriber);
+    // Subscriptions made before start() are sent once the channel is set up
+    if (m_SMChannel != nullptr && m_SMChannel->started())
+        m_SMChannel->pushMsg<cmdSUBSCRIBE_ON_TASK_DONE>(SEmptyCmd(), dds::env_prop<dds::dds_slot_id>());
+    return connection;
 }
 
 void CIntercomServiceCore::disconnectCustomCmd()
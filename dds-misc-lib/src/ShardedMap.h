@@ -0,0 +1,98 @@
+// Copyright 2014 GSI, Inc. All rights reserved.
+//
+//
+#ifndef _DDS_SHARDEDMAP_H_
+#define _DDS_SHARDEDMAP_H_
+
+// STD
+#include <array>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace dds::misc
+{
+    /**
+     * @brief Hash map for read-mostly concurrent access.
+     * @details Keys are distributed among shards, each of them has its own lock. Readers of a shard share the lock,
+     * thus lookups block each other neither within a shard nor across shards. Writers block only the readers of the
+     * same shard.
+     **/
+    template <class Key, class Value, size_t NofShards = 64, class Hash = std::hash<Key>>
+    class CShardedMap
+    {
+      public:
+        /// @brief Copies the value of the given key to _value.
+        /// @return false if the key is not found.
+        bool find(const Key& _key, Value& _value) const
+        {
+            const SShard& shard = getShard(_key);
+            std::shared_lock<std::shared_mutex> lock(shard.m_mutex);
+            auto it = shard.m_map.find(_key);
+            if (it == shard.m_map.end())
+                return false;
+            _value = it->second;
+            return true;
+        }
+
+        void insert_or_assign(const Key& _key, const Value& _value)
+        {
+            SShard& shard = getShard(_key);
+            std::unique_lock<std::shared_mutex> lock(shard.m_mutex);
+            shard.m_map.insert_or_assign(_key, _value);
+        }
+
+        /// @return false if the key is not found.
+        bool erase(const Key& _key)
+        {
+            SShard& shard = getShard(_key);
+            std::unique_lock<std::shared_mutex> lock(shard.m_mutex);
+            return (shard.m_map.erase(_key) > 0);
+        }
+
+        void clear()
+        {
+            for (auto& shard : m_shards)
+            {
+                std::unique_lock<std::shared_mutex> lock(shard.m_mutex);
+                shard.m_map.clear();
+            }
+        }
+
+        /// @note The result is only a hint if the map is modified concurrently.
+        size_t size() const
+        {
+            size_t result(0);
+            for (const auto& shard : m_shards)
+            {
+                std::shared_lock<std::shared_mutex> lock(shard.m_mutex);
+                result += shard.m_map.size();
+            }
+            return result;
+        }
+
+      private:
+        // Each shard takes its own cache line, otherwise the locks of neighbouring shards would contend
+        struct alignas(64) SShard
+        {
+            mutable std::shared_mutex m_mutex;
+            std::unordered_map<Key, Value, Hash> m_map;
+        };
+
+        SShard& getShard(const Key& _key)
+        {
+            return m_shards[Hash()(_key) % NofShards];
+        }
+
+        const SShard& getShard(const Key& _key) const
+        {
+            return m_shards[Hash()(_key) % NofShards];
+        }
+
+      private:
+        std::array<SShard, NofShards> m_shards;
+    };
+} // namespace dds::misc
+
+#endif /*_DDS_SHARDEDMAP_H_*/
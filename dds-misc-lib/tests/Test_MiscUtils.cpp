@@ -12,13 +12,50 @@
 using boost::unit_test::test_suite;
 
 // STD
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 // Our
 #include "MiscUtils.h"
+#include "ShardedMap.h"
+#include "TimeMeasure.h"
 
 using namespace dds::misc;
 using namespace std;
 
+// Threads look up keys concurrently, like the handlers of cmdUPDATE_KEY in the commander, which look up the channel of
+// the receiver task
+template <class L>
+double lookupKeys(size_t _nofThreads, size_t _nofKeys, uint64_t _nofTasks, L _lookup)
+{
+    vector<size_t> nofFound(_nofThreads, 0);
+    auto time = STimeMeasure<chrono::microseconds>::execution(
+        [&]()
+        {
+            vector<thread> threads;
+            for (size_t i = 0; i < _nofThreads; ++i)
+                threads.emplace_back(
+                    [&, i]()
+                    {
+                        for (size_t j = 0; j < _nofKeys; ++j)
+                        {
+                            uint64_t protocolHeaderID(0);
+                            if (_lookup((i * _nofKeys + j * 7919) % _nofTasks, protocolHeaderID))
+                                ++nofFound[i];
+                        }
+                    });
+            for (auto& v : threads)
+                v.join();
+        });
+    for (auto v : nofFound)
+        BOOST_CHECK_EQUAL(v, _nofKeys);
+    return (_nofThreads * _nofKeys) / (static_cast<double>(max<chrono::microseconds::rep>(time, 1)) / 1000000.);
+}
+
 BOOST_AUTO_TEST_SUITE(MiscCommon_Utils);
 //=============================================================================
 BOOST_AUTO_TEST_CASE(Test_MiscCommon_smart_append)
@@ -113,5 +150,89 @@ BOOST_AUTO_TEST_CASE(Test_MiscCommon_trim)
     }
 }
 //=============================================================================
+BOOST_AUTO_TEST_CASE(Test_MiscCommon_ShardedMap)
+{
+    CShardedMap<uint64_t, string, 4> map;
+    string value;
+    BOOST_CHECK(!map.find(1, value));
+
+    map.insert_or_assign(1, "one");
+    map.insert_or_assign(2, "two");
+    map.insert_or_assign(1, "uno");
+    BOOST_CHECK_EQUAL(map.size(), 2);
+    BOOST_CHECK(map.find(1, value));
+    BOOST_CHECK_EQUAL(value, "uno");
+
+    BOOST_CHECK(map.erase(2));
+    BOOST_CHECK(!map.erase(2));
+    BOOST_CHECK(!map.find(2, value));
+
+    map.clear();
+    BOOST_CHECK_EQUAL(map.size(), 0);
+
+    // Concurrent readers and writers
+    const uint64_t nofKeys(10000);
+    vector<thread> threads;
+    for (uint64_t t = 0; t < 4; ++t)
+        threads.emplace_back(
+            [&map, t, nofKeys]()
+            {
+                for (uint64_t i = t; i < nofKeys; i += 4)
+                    map.insert_or_assign(i, to_string(i));
+                string v;
+                for (uint64_t i = 0; i < nofKeys; ++i)
+                    map.find(i, v);
+            });
+    for (auto& v : threads)
+        v.join();
+    BOOST_CHECK_EQUAL(map.size(), nofKeys);
+    BOOST_CHECK(map.find(nofKeys - 1, value));
+    BOOST_CHECK_EQUAL(value, to_string(nofKeys - 1));
+}
+//=============================================================================
+BOOST_AUTO_TEST_CASE(Test_MiscCommon_ShardedMap_Performance)
+{
+    const uint64_t nofTasks(100000);
+    const size_t nofKeys(50000);
+    cout << "Lookup of " << nofTasks << " tasks, " << nofKeys << " keys per thread:\n";
+
+    // A global mutex guards the map
+    mutex mtx;
+    map<uint64_t, uint64_t> mutexMap;
+    // Shards with shared locks
+    CShardedMap<uint64_t, uint64_t> shardedMap;
+    for (uint64_t i = 0; i < nofTasks; ++i)
+    {
+        mutexMap[i] = i + 1;
+        shardedMap.insert_or_assign(i, i + 1);
+    }
+
+    for (size_t nofThreads : { 1, 2, 4, 8 })
+    {
+        const double mutexRate = lookupKeys(nofThreads,
+                                            nofKeys,
+                                            nofTasks,
+                                            [&](uint64_t _taskID, uint64_t& _protocolHeaderID)
+                                            {
+                                                lock_guard<mutex> lock(mtx);
+                                                auto it = mutexMap.find(_taskID);
+                                                if (it == mutexMap.end())
+                                                    return false;
+                                                _protocolHeaderID = it->second;
+                                                return true;
+                                            });
+        const double shardedRate =
+            lookupKeys(nofThreads,
+                       nofKeys,
+                       nofTasks,
+                       [&](uint64_t _taskID, uint64_t& _protocolHeaderID)
+                       { return shardedMap.find(_taskID, _protocolHeaderID); });
+        cout << "  " << nofThreads << " threads: mutex " << static_cast<size_t>(mutexRate) << " keys/s, sharded "
+             << static_cast<size_t>(shardedRate) << " keys/s\n";
+    }
+
+    BOOST_CHECK_EQUAL(shardedMap.size(), mutexMap.size());
+}
+//=============================================================================
 
 BOOST_AUTO_TEST_SUITE_END();
@@ -25,7 +25,7 @@ bool SAgentsInfoCmd::operator==(const SAgentsInfoCmd& _val) const
     return (m_nActiveAgents == _val.m_nActiveAgents && m_nIndex == _val.m_nIndex && m_sAgentInfo == _val.m_sAgentInfo);
 }
 
-void SAgentsInfoCmd::_convertFromData(const BYTEVector_t& _data)
+void SAgentsInfoCmd::_convertFromData(const SByteView& _data)
 {
     SAttachmentDataProvider(_data).get(m_nActiveAgents).get(m_nIndex).get(m_sAgentInfo);
 }
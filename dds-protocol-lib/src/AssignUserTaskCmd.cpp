@@ -20,7 +20,8 @@ SAssignUserTaskCmd::SAssignUserTaskCmd()
 size_t SAssignUserTaskCmd::size() const
 {
     return dsize(m_sExeFile) + dsize(m_taskID) + dsize(m_taskIndex) + dsize(m_collectionIndex) + dsize(m_taskPath) +
-           dsize(m_groupName) + dsize(m_collectionName) + dsize(m_taskName) + dsize(m_topoHash) + dsize(m_sEnvFile);
+           dsize(m_groupName) + dsize(m_collectionName) + dsize(m_taskName) + dsize(m_topoHash) + dsize(m_sEnvFile) +
+           (m_cachedFileHashes.empty() ? 0 : dsize(m_cachedFileHashes) + dsize(m_cachedFileNames));
 }
 
 bool SAssignUserTaskCmd::operator==(const SAssignUserTaskCmd& val) const
@@ -28,13 +29,14 @@ bool SAssignUserTaskCmd::operator==(const SAssignUserTaskCmd& val) const
     return (m_sExeFile == val.m_sExeFile && m_taskID == val.m_taskID && m_taskIndex == val.m_taskIndex &&
             m_collectionIndex == val.m_collectionIndex && m_taskPath == val.m_taskPath &&
             m_groupName == val.m_groupName && m_collectionName == val.m_collectionName &&
-            m_taskName == val.m_taskName && m_topoHash == val.m_topoHash && m_sEnvFile == val.m_sEnvFile);
+            m_taskName == val.m_taskName && m_topoHash == val.m_topoHash && m_sEnvFile == val.m_sEnvFile &&
+            m_cachedFileHashes == val.m_cachedFileHashes && m_cachedFileNames == val.m_cachedFileNames);
 }
 
-void SAssignUserTaskCmd::_convertFromData(const BYTEVector_t& _data)
+void SAssignUserTaskCmd::_convertFromData(const SByteView& _data)
 {
-    SAttachmentDataProvider(_data)
-        .get(m_taskIndex)
+    SAttachmentDataProvider provider(_data);
+    provider.get(m_taskIndex)
         .get(m_collectionIndex)
         .get(m_sExeFile)
         .get(m_taskID)
@@ -44,12 +46,17 @@ void SAssignUserTaskCmd::_convertFromData(const BYTEVector_t& _data)
         .get(m_taskName)
         .get(m_topoHash)
         .get(m_sEnvFile);
+    // Cached files are appended only if there are any
+    m_cachedFileHashes.clear();
+    m_cachedFileNames.clear();
+    if (!provider.eof())
+        provider.get(m_cachedFileHashes).get(m_cachedFileNames);
 }
 
 void SAssignUserTaskCmd::_convertToData(BYTEVector_t* _data) const
 {
-    SAttachmentDataProvider(_data)
-        .put(m_taskIndex)
+    SAttachmentDataProvider provider(_data);
+    provider.put(m_taskIndex)
         .put(m_collectionIndex)
         .put(m_sExeFile)
         .put(m_taskID)
@@ -59,6 +66,8 @@ void SAssignUserTaskCmd::_convertToData(BYTEVector_t* _data) const
         .put(m_taskName)
         .put(m_topoHash)
         .put(m_sEnvFile);
+    if (!m_cachedFileHashes.empty())
+        provider.put(m_cachedFileHashes).put(m_cachedFileNames);
 }
 
 std::ostream& dds::protocol_api::operator<<(std::ostream& _stream, const SAssignUserTaskCmd& val)
@@ -67,7 +76,7 @@ std::ostream& dds::protocol_api::operator<<(std::ostream& _stream, const SAssign
                    << "; taskIndex:" << val.m_taskIndex << "; collectionIndex:" << val.m_collectionIndex
                    << "; taskPath:" << val.m_taskPath << "; groupName:" << val.m_groupName
                    << "; collectionName:" << val.m_collectionName << "; taskName: " << val.m_taskName
-                   << "; topoHash: " << val.m_topoHash;
+                   << "; topoHash: " << val.m_topoHash << "; cachedFiles: " << val.m_cachedFileHashes.size();
 }
 
 bool dds::protocol_api::operator!=(const SAssignUserTaskCmd& lhs, const SAssignUserTaskCmd& rhs)
@@ -7,6 +7,9 @@
 
 // DDS
 #include "BasicCmd.h"
+// STD
+#include <string>
+#include <vector>
 
 namespace dds
 {
@@ -16,7 +19,7 @@ namespace dds
         {
             SAssignUserTaskCmd();
             size_t size() const;
-            void _convertFromData(const dds::misc::BYTEVector_t& _data);
+            void _convertFromData(const SByteView& _data);
             void _convertToData(dds::misc::BYTEVector_t* _data) const;
             bool operator==(const SAssignUserTaskCmd& val) const;
 
@@ -30,6 +33,10 @@ namespace dds
             std::string m_taskName;
             uint32_t m_topoHash;
             std::string m_sEnvFile;
+            /// Content hashes of files in the file cache of the agent, which are linked into the slot directory under
+            /// the names of m_cachedFileNames. Sent only to agents supporting g_protocolCommandsVersionFileCache.
+            std::vector<std::string> m_cachedFileHashes;
+            std::vector<std::string> m_cachedFileNames;
         };
         std::ostream& operator<<(std::ostream& _stream, const SAssignUserTaskCmd& val);
         bool operator!=(const SAssignUserTaskCmd& lhs, const SAssignUserTaskCmd& rhs);
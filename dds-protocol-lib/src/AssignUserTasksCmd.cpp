@@ -0,0 +1,135 @@
+// Copyright 2014 GSI, Inc. All rights reserved.
+//
+//
+//
+#include "AssignUserTasksCmd.h"
+// STD
+#include <algorithm>
+
+using namespace std;
+using namespace dds;
+using namespace dds::protocol_api;
+using namespace dds::misc;
+
+SAssignUserTasksCmd::SAssignUserTasksCmd()
+    : m_slots()
+{
+}
+
+size_t SAssignUserTasksCmd::size() const
+{
+    size_t size(0);
+    for (const auto& slot : m_slots)
+        size += dsize(slot.m_slotID) + sizeof(uint32_t) + slot.m_assignment.size();
+    return size;
+}
+
+bool SAssignUserTasksCmd::operator==(const SAssignUserTasksCmd& _val) const
+{
+    return std::equal(m_slots.begin(),
+                      m_slots.end(),
+                      _val.m_slots.begin(),
+                      _val.m_slots.end(),
+                      [](const SSlot& _lhs, const SSlot& _rhs)
+                      { return (_lhs.m_slotID == _rhs.m_slotID && _lhs.m_assignment == _rhs.m_assignment); });
+}
+
+void SAssignUserTasksCmd::_convertFromData(const SByteView& _data)
+{
+    m_slots.clear();
+    SAttachmentDataProvider provider(_data);
+    while (!provider.eof())
+    {
+        SSlot slot;
+        SByteView assignment;
+        provider.get(slot.m_slotID).get(assignment);
+        slot.m_assignment.convertFromData(assignment);
+        m_slots.push_back(slot);
+    }
+}
+
+void SAssignUserTasksCmd::_convertToData(BYTEVector_t* _data) const
+{
+    SAttachmentDataProvider provider(_data);
+    for (const auto& slot : m_slots)
+    {
+        // The nested command is serialized in place, prefixed with its size like a vector of uint8_t
+        provider.put(slot.m_slotID).put(static_cast<uint32_t>(slot.m_assignment.size()));
+        slot.m_assignment.convertToData(_data);
+    }
+}
+
+std::ostream& dds::protocol_api::operator<<(std::ostream& _stream, const SAssignUserTasksCmd& _val)
+{
+    _stream << "nofSlots=" << _val.m_slots.size();
+    for (const auto& slot : _val.m_slots)
+        _stream << " [slot=" << slot.m_slotID << " " << slot.m_assignment << "]";
+    return _stream;
+}
+
+bool dds::protocol_api::operator!=(const SAssignUserTasksCmd& lhs, const SAssignUserTasksCmd& rhs)
+{
+    return !(lhs == rhs);
+}
+
+//----------------------------------------------------------------------
+
+SSlotRepliesCmd::SSlotRepliesCmd()
+    : m_slots()
+{
+}
+
+size_t SSlotRepliesCmd::size() const
+{
+    size_t size(0);
+    for (const auto& slot : m_slots)
+        size += dsize(slot.m_slotID) + sizeof(uint32_t) + slot.m_reply.size();
+    return size;
+}
+
+bool SSlotRepliesCmd::operator==(const SSlotRepliesCmd& _val) const
+{
+    return std::equal(m_slots.begin(),
+                      m_slots.end(),
+                      _val.m_slots.begin(),
+                      _val.m_slots.end(),
+                      [](const SSlot& _lhs, const SSlot& _rhs)
+                      { return (_lhs.m_slotID == _rhs.m_slotID && _lhs.m_reply == _rhs.m_reply); });
+}
+
+void SSlotRepliesCmd::_convertFromData(const SByteView& _data)
+{
+    m_slots.clear();
+    SAttachmentDataProvider provider(_data);
+    while (!provider.eof())
+    {
+        SSlot slot;
+        SByteView reply;
+        provider.get(slot.m_slotID).get(reply);
+        slot.m_reply.convertFromData(reply);
+        m_slots.push_back(slot);
+    }
+}
+
+void SSlotRepliesCmd::_convertToData(BYTEVector_t* _data) const
+{
+    SAttachmentDataProvider provider(_data);
+    for (const auto& slot : m_slots)
+    {
+        provider.put(slot.m_slotID).put(static_cast<uint32_t>(slot.m_reply.size()));
+        slot.m_reply.convertToData(_data);
+    }
+}
+
+std::ostream& dds::protocol_api::operator<<(std::ostream& _stream, const SSlotRepliesCmd& _val)
+{
+    _stream << "nofSlots=" << _val.m_slots.size();
+    for (const auto& slot : _val.m_slots)
+        _stream << " [slot=" << slot.m_slotID << " " << slot.m_reply << "]";
+    return _stream;
+}
+
+bool dds::protocol_api::operator!=(const SSlotRepliesCmd& lhs, const SSlotRepliesCmd& rhs)
+{
+    return !(lhs == rhs);
+}
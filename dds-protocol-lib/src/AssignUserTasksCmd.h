@@ -0,0 +1,66 @@
+// Copyright 2014 GSI, Inc. All rights reserved.
+//
+//
+//
+#ifndef __DDS__AssignUserTasksCmd__
+#define __DDS__AssignUserTasksCmd__
+
+// DDS
+#include "AssignUserTaskCmd.h"
+#include "ReplyCmd.h"
+// STD
+#include <vector>
+
+namespace dds
+{
+    namespace protocol_api
+    {
+        ///
+        /// \brief Attachment of cmdASSIGN_USER_TASKS, which assigns and activates user tasks of several slots of an
+        /// agent at once.
+        ///
+        struct SAssignUserTasksCmd : public SBasicCmd<SAssignUserTasksCmd>
+        {
+            struct SSlot
+            {
+                uint64_t m_slotID{ 0 };
+                SAssignUserTaskCmd m_assignment;
+            };
+
+            SAssignUserTasksCmd();
+            size_t size() const;
+            void _convertFromData(const SByteView& _data);
+            void _convertToData(dds::misc::BYTEVector_t* _data) const;
+            bool operator==(const SAssignUserTasksCmd& _val) const;
+
+            std::vector<SSlot> m_slots;
+        };
+        std::ostream& operator<<(std::ostream& _stream, const SAssignUserTasksCmd& _val);
+        bool operator!=(const SAssignUserTasksCmd& lhs, const SAssignUserTasksCmd& rhs);
+
+        ///
+        /// \brief Attachment of cmdREPLY_ASSIGN_USER_TASKS, the reply of an agent to cmdASSIGN_USER_TASKS with the
+        /// status of each slot.
+        ///
+        struct SSlotRepliesCmd : public SBasicCmd<SSlotRepliesCmd>
+        {
+            struct SSlot
+            {
+                uint64_t m_slotID{ 0 };
+                SReplyCmd m_reply;
+            };
+
+            SSlotRepliesCmd();
+            size_t size() const;
+            void _convertFromData(const SByteView& _data);
+            void _convertToData(dds::misc::BYTEVector_t* _data) const;
+            bool operator==(const SSlotRepliesCmd& _val) const;
+
+            std::vector<SSlot> m_slots;
+        };
+        std::ostream& operator<<(std::ostream& _stream, const SSlotRepliesCmd& _val);
+        bool operator!=(const SSlotRepliesCmd& lhs, const SSlotRepliesCmd& rhs);
+    } // namespace protocol_api
+};    // namespace dds
+
+#endif /* defined(__DDS__AssignUserTasksCmd__) */
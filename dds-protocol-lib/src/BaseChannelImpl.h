@@ -4,12 +4,21 @@
 //
 #ifndef __DDS__BaseChannelImpl__
 #define __DDS__BaseChannelImpl__
+// API
+#include <fcntl.h>
+#include <unistd.h>
 // STD
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cstring>
 #include <deque>
+#include <fstream>
 #include <iostream>
 #include <map>
 #include <memory>
+#include <vector>
 // BOOST
 #include <boost/asio.hpp>
 #include <boost/filesystem.hpp>
@@ -20,10 +29,15 @@
 // DDS
 #include "ChannelEventHandlersImpl.h"
 #include "ChannelMessageHandlersImpl.h"
+#include "CoalescingWindow.h"
 #include "CommandAttachmentImpl.h"
 #include "Logger.h"
+#include "MPSCQueue.h"
 #include "MonitoringThread.h"
 #include "ProtocolDef.h"
+#include "ProtocolMessagePool.h"
+#include "SharedBinaryAttachment.h"
+#include "WriteQueueMonitor.h"
 
 namespace fs = boost::filesystem;
 
@@ -75,6 +89,18 @@ namespace dds
                     processBinaryAttachmentStartCmd(sender, attachmentPtr);                                            \
                     return;                                                                                            \
                 }                                                                                                      \
+                case cmdBATCH:                                                                                         \
+                {                                                                                                      \
+                    SCommandAttachmentImpl<cmdBATCH>::ptr_t attachmentPtr =                                            \
+                        SCommandAttachmentImpl<cmdBATCH>::decode(_currentMsg);                                         \
+                    processBatchCmd(attachmentPtr);                                                                    \
+                    return;                                                                                            \
+                }                                                                                                      \
+                case cmdCOMPRESSED:                                                                                    \
+                {                                                                                                      \
+                    processCompressedMsg(_currentMsg);                                                                 \
+                    return;                                                                                            \
+                }                                                                                                      \
                 case cmdHANDSHAKE:                                                                                     \
                 {                                                                                                      \
                     SCommandAttachmentImpl<cmdHANDSHAKE>::ptr_t attachmentPtr =                                        \
@@ -91,6 +117,7 @@ namespace dds
                 }                                                                                                      \
                 case cmdREPLY_HANDSHAKE_OK:                                                                            \
                 {                                                                                                      \
+                    processReplyHandshakeOKMsg(_currentMsg);                                                           \
                     SCommandAttachmentImpl<cmdREPLY_HANDSHAKE_OK>::ptr_t attachmentPtr =                               \
                         SCommandAttachmentImpl<cmdREPLY_HANDSHAKE_OK>::decode(_currentMsg);                            \
                     dispatchHandlers<>(currentCmd, sender, attachmentPtr);                                             \
@@ -192,10 +219,16 @@ namespace dds
 {
     namespace protocol_api
     {
+        /// State of an incoming binary attachment. Its pieces are written directly into a temporary file, which is
+        /// renamed once the attachment is complete.
         struct SBinaryAttachmentInfo
         {
             SBinaryAttachmentInfo()
-                : m_bytesReceived(0)
+                : m_fd(-1)
+                , m_crc32()
+                , m_nextOffset(0)
+                , m_isInOrder(true)
+                , m_bytesReceived(0)
                 , m_fileCrc32(0)
                 , m_srcCommand(0)
                 , m_fileSize(0)
@@ -203,7 +236,28 @@ namespace dds
             {
             }
 
-            dds::misc::BYTEVector_t m_data;
+            ~SBinaryAttachmentInfo()
+            {
+                closeFile();
+                // Remove the incomplete file
+                if (!m_tmpFilePath.empty())
+                    ::unlink(m_tmpFilePath.c_str());
+            }
+
+            void closeFile()
+            {
+                if (m_fd != -1)
+                {
+                    ::close(m_fd);
+                    m_fd = -1;
+                }
+            }
+
+            int m_fd;                      ///< Descriptor of the temporary file
+            std::string m_tmpFilePath;     ///< Path of the temporary file, empty once the file is complete
+            boost::crc_32_type m_crc32;    ///< CRC32 of the file, calculated as long as pieces are received in order
+            uint32_t m_nextOffset;         ///< Offset of the next piece in order
+            bool m_isInOrder;              ///< False, if pieces were received out of order
             uint32_t m_bytesReceived;
             std::string m_fileName;
             uint32_t m_fileCrc32;
@@ -215,6 +269,30 @@ namespace dds
 
         typedef std::shared_ptr<SBinaryAttachmentInfo> binaryAttachmentInfoPtr_t;
 
+        /// State of an outgoing binary attachment. Its pieces are read from the source on demand.
+        struct SBinaryAttachmentSendInfo
+        {
+            SBinaryAttachmentSendInfo()
+                : m_fileId()
+                , m_protocolHeaderID(0)
+                , m_fileSize(0)
+                , m_offset(0)
+                , m_srcCommand(0)
+            {
+            }
+
+            boost::uuids::uuid m_fileId;
+            uint64_t m_protocolHeaderID;
+            uint32_t m_fileSize;
+            uint32_t m_offset;                           ///< Offset of the next piece to send
+            uint16_t m_srcCommand;                       ///< Errors are reported for this command
+            std::string m_filePath;                      ///< Source file
+            std::ifstream m_file;                        ///< Source file stream
+            SSharedBinaryAttachment::ptr_t m_attachment; ///< Source attachment, if it is already in memory
+        };
+
+        typedef std::shared_ptr<SBinaryAttachmentSendInfo> binaryAttachmentSendInfoPtr_t;
+
         template <class T>
         class CBaseChannelImpl : public boost::noncopyable,
                                  public CChannelEventHandlersImpl,
@@ -222,10 +300,12 @@ namespace dds
                                  public std::enable_shared_from_this<T>
         {
             typedef std::deque<CProtocolMessage::protocolMessagePtr_t> protocolMessagePtrQueue_t;
-            typedef std::vector<boost::asio::mutable_buffer> protocolMessageBuffer_t;
-            typedef std::shared_ptr<boost::asio::deadline_timer> deadlineTimerPtr_t;
+            typedef std::vector<boost::asio::const_buffer> protocolMessageBuffer_t;
+            typedef std::shared_ptr<boost::asio::steady_timer> deadlineTimerPtr_t;
 
           public:
+            /// Channels work over TCP and Unix domain sockets
+            typedef boost::asio::generic::stream_protocol::socket socket_t;
             typedef std::shared_ptr<T> connectionPtr_t;
             typedef std::weak_ptr<T> weakConnectionPtr_t;
             typedef std::vector<connectionPtr_t> connectionPtrVector_t;
@@ -244,19 +324,58 @@ namespace dds
                 , m_channelType(EChannelType::UNKNOWN)
                 , m_protocolHeaderID(_protocolHeaderID)
                 , m_ioContext(_service)
+                , m_isBatchSupported(false)
+                , m_isCompressionSupported(false)
+                , m_isLargeValuesSupported(false)
+                , m_isAssignUserTasksSupported(false)
+                , m_isFileCacheSupported(false)
+                , m_isTaskDoneSubscriptionSupported(false)
                 , m_socket(_service)
                 , m_started(false)
-                , m_currentMsg(std::make_shared<CProtocolMessage>())
+                , m_headerBuffer()
+                , m_currentMsg()
+                , m_messagePool(CProtocolMessagePool::makeNew())
+                , m_writeRequests()
+                , m_isWriting(false)
                 , m_binaryAttachmentMap()
                 , m_binaryAttachmentMutex()
-                , m_deadlineTimer(
-                      std::make_shared<boost::asio::deadline_timer>(_service, boost::posix_time::milliseconds(1000)))
+                , m_binaryAttachmentSendQueue()
+                , m_nofBinaryAttachmentPiecesInFlight(0)
+                , m_binaryAttachmentSendMutex()
+                , m_coalescingWindow()
+                , m_deadlineTimer(std::make_shared<boost::asio::steady_timer>(_service))
                 , m_isShuttingDown(false)
+                , m_writeBatch()
+                , m_writeBatchMsg(std::make_shared<CProtocolMessage>())
+                , m_compressionLevel(0)
+                , m_compressionThreshold(0)
+                , m_compressionBackoff()
+                , m_writeFrames()
             {
                 try
                 {
                     m_sessionID = dds::user_defaults_api::CUserDefaults::instance().getLockedSID();
                     LOG(dds::misc::debug) << "SID: " << m_sessionID;
+
+                    const auto& options = dds::user_defaults_api::CUserDefaults::instance().getOptions();
+                    setCompression(options.m_server.m_compressionLevel, options.m_server.m_compressionThreshold);
+
+                    SWriteQueueLimits limits;
+                    limits.m_highWatermarkBytes = options.m_server.m_writeQueueHighWatermark * 1024 * 1024;
+                    limits.m_lowWatermarkBytes = options.m_server.m_writeQueueLowWatermark * 1024 * 1024;
+                    limits.m_highWatermarkMsgs = options.m_server.m_writeQueueHighWatermarkMsgs;
+                    limits.m_lowWatermarkMsgs = options.m_server.m_writeQueueLowWatermarkMsgs;
+                    limits.m_maxBytes = options.m_server.m_writeQueueMaxSize * 1024 * 1024;
+                    setWriteQueueLimits(limits);
+
+                    SCoalescingPolicy policy;
+                    policy.m_maxLatency = std::chrono::microseconds(options.m_server.m_coalescingMaxLatency);
+                    policy.m_maxBatchBytes = options.m_server.m_coalescingMaxBatchBytes;
+                    setDefaultCoalescingPolicy(policy);
+
+                    policy.m_maxLatency = std::chrono::microseconds(options.m_server.m_updateKeyCoalescingMaxLatency);
+                    policy.m_maxBatchBytes = options.m_server.m_updateKeyCoalescingMaxBatchBytes;
+                    setCoalescingPolicy(cmdUPDATE_KEY, policy);
                 }
                 catch (std::runtime_error& _error)
                 {
@@ -303,7 +422,7 @@ namespace dds
                     return;
 
                 m_started = true;
-                // Prevent Asio TCP socket to be inherited by child when using fork/exec
+                // Prevent Asio socket to be inherited by child when using fork/exec
                 ::fcntl(m_socket.native_handle(), F_SETFD, FD_CLOEXEC);
                 readHeader();
             }
@@ -316,88 +435,49 @@ namespace dds
                 close();
             }
 
-            boost::asio::ip::tcp::socket& socket()
+            socket_t& socket()
             {
                 return m_socket;
             }
 
+            /// \brief Address of the remote end or "local" for Unix domain socket connections.
+            std::string remoteAddress() const
+            {
+                boost::system::error_code ec;
+                const auto endpoint = m_socket.remote_endpoint(ec);
+                if (ec)
+                    return "unknown";
+                if (endpoint.protocol().family() == AF_UNIX)
+                    return "local";
+
+                boost::asio::ip::tcp::endpoint tcpEndpoint;
+                if (endpoint.size() > tcpEndpoint.capacity())
+                    return "unknown";
+                std::memcpy(tcpEndpoint.data(), endpoint.data(), endpoint.size());
+                tcpEndpoint.resize(endpoint.size());
+                return tcpEndpoint.address().to_string();
+            }
+
+            /// \brief Removes queued messages of the given type, which are not being sent yet.
+            /// \note The messages are removed asynchronously by the writer of the channel.
             template <ECmdType _cmd>
             void dequeueMsg()
             {
-                std::lock_guard<std::mutex> lock(m_mutexWriteBuffer);
-                m_writeQueue.erase(std::remove_if(std::begin(m_writeQueue),
-                                                  std::end(m_writeQueue),
-                                                  [](const CProtocolMessage::protocolMessagePtr_t& _msg)
-                                                  { return (_msg->header().m_cmd == _cmd); }),
-                                   std::end(m_writeQueue));
+                pushWriteRequest(SWriteRequest{ SWriteRequest::EType::Dequeue, _cmd, nullptr, {} });
             }
 
+            /// \brief Pushes a message, which can be held back and sent together with other messages.
+            /// \details When the messages are sent is decided by the coalescing policy of the command type, see
+            /// setCoalescingPolicy.
             void accumulativePushMsg(CProtocolMessage::protocolMessagePtr_t _msg, ECmdType _cmd)
             {
-                static const size_t maxAccumulativeWriteQueueSize = 10000;
                 try
                 {
-                    bool copyMessages = false;
-                    {
-                        std::lock_guard<std::mutex> lock(m_mutexWriteBuffer);
-
-                        m_deadlineTimer->cancel();
-
-                        if (cmdUNKNOWN != _cmd)
-                            m_accumulativeWriteQueue.push_back(_msg);
-
-                        copyMessages = m_accumulativeWriteQueue.size() > maxAccumulativeWriteQueueSize;
-                        if (copyMessages)
-                        {
-                            LOG(dds::misc::debug)
-                                << "copy accumulated queue to write queue "
-                                   "m_accumulativeWriteQueue.size="
-                                << m_accumulativeWriteQueue.size() << " m_writeQueue.size=" << m_writeQueue.size();
-
-                            // copy queue to main queue
-                            std::copy(m_accumulativeWriteQueue.begin(),
-                                      m_accumulativeWriteQueue.end(),
-                                      back_inserter((m_isHandshakeOK) ? m_writeQueue : m_writeQueueBeforeHandShake));
-                            m_accumulativeWriteQueue.clear();
-                        }
-
-                        auto self(this->shared_from_this());
-                        m_deadlineTimer->async_wait(
-                            [this, self](const boost::system::error_code& error)
-                            {
-                                if (!error)
-                                {
-                                    bool copyMessages = false;
-                                    {
-                                        std::lock_guard<std::mutex> lock(m_mutexWriteBuffer);
-                                        copyMessages = !m_accumulativeWriteQueue.empty();
-                                        // copy queue to main queue
-                                        if (copyMessages)
-                                        {
-                                            LOG(dds::misc::debug)
-                                                << "deadline_timer called: copy accumulated queue to write queue "
-                                                   "m_accumulativeWriteQueue.size="
-                                                << m_accumulativeWriteQueue.size()
-                                                << " m_writeQueue.size=" << m_writeQueue.size();
-                                            std::copy(m_accumulativeWriteQueue.begin(),
-                                                      m_accumulativeWriteQueue.end(),
-                                                      back_inserter((m_isHandshakeOK) ? m_writeQueue
-                                                                                      : m_writeQueueBeforeHandShake));
-                                            m_accumulativeWriteQueue.clear();
-                                        }
-                                    }
-                                    if (copyMessages)
-                                        pushMsg<cmdUNKNOWN>();
-                                }
-                            });
+                    if (cmdUNKNOWN == _cmd || !accountWriteMsg(_msg))
+                        return;
 
-                        LOG(dds::misc::debug) << "accumulativePushMsg: WriteQueue size = " << m_writeQueue.size()
-                                              << " WriteQueueBeforeHandShake = " << m_writeQueueBeforeHandShake.size()
-                                              << " accumulativeWriteQueue size = " << m_accumulativeWriteQueue.size()
-                                              << " msg = " << _msg->toString();
-                    }
-                    if (copyMessages)
-                        pushMsg<cmdUNKNOWN>();
+                    pushWriteRequest(SWriteRequest{
+                        SWriteRequest::EType::Accumulate, _cmd, std::move(_msg), CCoalescingWindow::clock_t::now() });
                 }
                 catch (std::exception& ex)
                 {
@@ -420,6 +500,30 @@ namespace dds
                 }
             }
 
+            /// \brief Pushes a message with an already encoded body. The body is shared, not copied.
+            /// \param _body The encoded attachment, if empty the attachment is encoded for this channel.
+            template <ECmdType _cmd, class A>
+            void accumulativePushEncodedMsg(const A& _attachment,
+                                            const CProtocolMessage::sharedBodyPtr_t& _body,
+                                            uint64_t _protocolHeaderID = 0)
+            {
+                if (_body == nullptr)
+                {
+                    accumulativePushMsg<_cmd>(_attachment, _protocolHeaderID);
+                    return;
+                }
+                try
+                {
+                    CProtocolMessage::protocolMessagePtr_t msg =
+                        SCommandAttachmentImpl<_cmd>::encode(_body, adjustProtocolHeaderID(_protocolHeaderID));
+                    accumulativePushMsg(msg, _cmd);
+                }
+                catch (std::exception& ex)
+                {
+                    LOG(dds::misc::error) << "BaseChannelImpl can't push accumulative message: " << ex.what();
+                }
+            }
+
             template <ECmdType _cmd>
             void accumulativePushMsg(uint64_t _protocolHeaderID = 0)
             {
@@ -431,52 +535,18 @@ namespace dds
             {
                 try
                 {
-                    std::lock_guard<std::mutex> lock(m_mutexWriteBuffer);
-                    if (!m_isHandshakeOK)
-                    {
-                        if (isCmdAllowedWithoutHandshake(_cmd))
-                            m_writeQueue.push_back(_msg);
-                        else
-                            m_writeQueueBeforeHandShake.push_back(_msg);
-                    }
-                    else
-                    {
-                        // copy the buffered queue, which has been collected before hand-shake
-                        if (!m_writeQueueBeforeHandShake.empty())
-                        {
-                            std::copy(m_writeQueueBeforeHandShake.begin(),
-                                      m_writeQueueBeforeHandShake.end(),
-                                      back_inserter(m_writeQueue));
-                            m_writeQueueBeforeHandShake.clear();
-                        }
-
-                        // add the current message to the queue
-                        if (cmdUNKNOWN != _cmd)
-                            m_writeQueue.push_back(_msg);
-                    }
+                    // cmdUNKNOWN only wakes up the writer, e.g. to send messages queued before the handshake
+                    if (cmdUNKNOWN == _cmd)
+                        _msg.reset();
+                    else if (!accountWriteMsg(_msg))
+                        return;
 
-                    LOG(dds::misc::debug) << "pushMsg: WriteQueue size = " << m_writeQueue.size()
-                                          << " WriteQueueBeforeHandShake = " << m_writeQueueBeforeHandShake.size();
+                    pushWriteRequest(SWriteRequest{ SWriteRequest::EType::Push, _cmd, std::move(_msg), {} });
                 }
                 catch (std::exception& ex)
                 {
                     LOG(dds::misc::error) << "BaseChannelImpl can't push message: " << ex.what();
                 }
-
-                // process standard async writing
-                auto self(this->shared_from_this());
-                m_ioContext.post(
-                    [this, self]
-                    {
-                        try
-                        {
-                            writeMessage();
-                        }
-                        catch (std::exception& ex)
-                        {
-                            LOG(dds::misc::error) << "BaseChannelImpl can't write message: " << ex.what();
-                        }
-                    });
             }
 
             template <ECmdType _cmd, class A>
@@ -494,6 +564,30 @@ namespace dds
                 }
             }
 
+            /// \brief Pushes a message with an already encoded body. The body is shared, not copied.
+            /// \param _body The encoded attachment, if empty the attachment is encoded for this channel.
+            template <ECmdType _cmd, class A>
+            void pushEncodedMsg(const A& _attachment,
+                                const CProtocolMessage::sharedBodyPtr_t& _body,
+                                uint64_t _protocolHeaderID = 0)
+            {
+                if (_body == nullptr)
+                {
+                    pushMsg<_cmd>(_attachment, _protocolHeaderID);
+                    return;
+                }
+                try
+                {
+                    CProtocolMessage::protocolMessagePtr_t msg =
+                        SCommandAttachmentImpl<_cmd>::encode(_body, adjustProtocolHeaderID(_protocolHeaderID));
+                    pushMsg(msg, _cmd, _protocolHeaderID);
+                }
+                catch (std::exception& ex)
+                {
+                    LOG(dds::misc::error) << "BaseChannelImpl can't push message: " << ex.what();
+                }
+            }
+
             template <ECmdType _cmd>
             void pushMsg(uint64_t _protocolHeaderID = 0)
             {
@@ -501,6 +595,60 @@ namespace dds
                 pushMsg<_cmd>(cmd, adjustProtocolHeaderID(_protocolHeaderID));
             }
 
+            /// \brief Pushes a message, which is superseded by the next message of the same kind, e.g. a progress
+            /// report. The message is dropped, if the write queue is congested.
+            /// \return false if the message was dropped.
+            bool pushCoalescibleMsg(CProtocolMessage::protocolMessagePtr_t _msg, ECmdType _cmd)
+            {
+                if (isWriteQueueCongested())
+                {
+                    m_writeQueueMonitor.drop();
+                    LOG(dds::misc::debug) << "Write queue of " << remoteEndIDString()
+                                          << " is congested, dropping a message: " << _msg->toString();
+                    return false;
+                }
+                pushMsg(_msg, _cmd);
+                return true;
+            }
+
+            template <ECmdType _cmd, class A>
+            bool pushCoalescibleMsg(const A& _attachment, uint64_t _protocolHeaderID = 0)
+            {
+                try
+                {
+                    CProtocolMessage::protocolMessagePtr_t msg =
+                        SCommandAttachmentImpl<_cmd>::encode(_attachment, adjustProtocolHeaderID(_protocolHeaderID));
+                    return pushCoalescibleMsg(msg, _cmd);
+                }
+                catch (std::exception& ex)
+                {
+                    LOG(dds::misc::error) << "BaseChannelImpl can't push message: " << ex.what();
+                }
+                return false;
+            }
+
+            /// \brief Pushes a coalescible message with an already encoded body. The body is shared, not copied.
+            /// \param _body The encoded attachment, if empty the attachment is encoded for this channel.
+            template <ECmdType _cmd, class A>
+            bool pushCoalescibleEncodedMsg(const A& _attachment,
+                                           const CProtocolMessage::sharedBodyPtr_t& _body,
+                                           uint64_t _protocolHeaderID = 0)
+            {
+                if (_body == nullptr)
+                    return pushCoalescibleMsg<_cmd>(_attachment, _protocolHeaderID);
+                try
+                {
+                    CProtocolMessage::protocolMessagePtr_t msg =
+                        SCommandAttachmentImpl<_cmd>::encode(_body, adjustProtocolHeaderID(_protocolHeaderID));
+                    return pushCoalescibleMsg(msg, _cmd);
+                }
+                catch (std::exception& ex)
+                {
+                    LOG(dds::misc::error) << "BaseChannelImpl can't push message: " << ex.what();
+                }
+                return false;
+            }
+
             template <ECmdType _cmd, class A>
             void sendYourself(const A& _attachment, uint64_t _protocolHeaderID = 0)
             {
@@ -518,28 +666,39 @@ namespace dds
                 sendYourself<_cmd>(cmd, adjustProtocolHeaderID(_protocolHeaderID));
             }
 
+            /// \brief Sends the given file as a binary attachment.
+            /// \details The file is read piece by piece, while previous pieces are being sent. Only a limited number
+            /// of pieces is queued at a time.
             void pushBinaryAttachmentCmd(const std::string& _srcFilePath,
                                          const std::string& _fileName,
                                          uint16_t _cmdSource,
                                          uint64_t _protocolHeaderID)
             {
-                dds::misc::BYTEVector_t data;
-
-                std::string srcFilePath(_srcFilePath);
+                binaryAttachmentSendInfoPtr_t info = std::make_shared<SBinaryAttachmentSendInfo>();
+                info->m_filePath = _srcFilePath;
                 // Resolve environment variables
-                dds::misc::smart_path(&srcFilePath);
+                dds::misc::smart_path(&info->m_filePath);
+
+                info->m_file.open(info->m_filePath, std::ios::binary);
+                if (!info->m_file.is_open() || !info->m_file.good())
+                {
+                    throw std::runtime_error("Could not open the source file: " + info->m_filePath);
+                }
 
-                std::ifstream f(srcFilePath);
-                if (!f.is_open() || !f.good())
+                // Calculate the size and the checksum of the file without loading it completely
+                boost::crc_32_type fileCrc32;
+                std::vector<char> buf(maxBinaryAttachmentPieceSize);
+                size_t fileSize(0);
+                while (info->m_file.read(buf.data(), buf.size()) || info->m_file.gcount() > 0)
                 {
-                    throw std::runtime_error("Could not open the source file: " + srcFilePath);
+                    fileCrc32.process_bytes(buf.data(), info->m_file.gcount());
+                    fileSize += info->m_file.gcount();
                 }
-                f.seekg(0, std::ios::end);
-                data.reserve(f.tellg());
-                f.seekg(0, std::ios::beg);
-                data.assign((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+                info->m_file.clear();
+                info->m_file.seekg(0, std::ios::beg);
 
-                pushBinaryAttachmentCmd(data, _fileName, _cmdSource, _protocolHeaderID);
+                info->m_fileSize = static_cast<uint32_t>(fileSize);
+                pushBinaryAttachmentCmd(info, fileCrc32.checksum(), _fileName, _cmdSource, _protocolHeaderID);
             }
 
             void pushBinaryAttachmentCmd(const dds::misc::BYTEVector_t& _data,
@@ -547,50 +706,25 @@ namespace dds
                                          uint16_t _cmdSource,
                                          uint64_t _protocolHeaderID)
             {
-                static const int maxCommandSize = 65536;
-                int nofParts =
-                    static_cast<int>((_data.size() % maxCommandSize == 0) ? (_data.size() / maxCommandSize)
-                                                                          : (_data.size() / maxCommandSize + 1));
-                boost::crc_32_type fileCrc32;
-                fileCrc32.process_bytes(&_data[0], _data.size());
-
-                boost::uuids::uuid fileId = boost::uuids::random_generator()();
-
-                // Generate start message
-                SBinaryAttachmentStartCmd start_cmd;
-                start_cmd.m_fileId = fileId;
-                start_cmd.m_srcCommand = _cmdSource;
-                start_cmd.m_fileName = _fileName;
-                start_cmd.m_fileSize = static_cast<uint32_t>(_data.size());
-                start_cmd.m_fileCrc32 = fileCrc32.checksum();
-                pushMsg<cmdBINARY_ATTACHMENT_START>(start_cmd, _protocolHeaderID);
-
-                for (int i = 0; i < nofParts; ++i)
-                {
-                    SBinaryAttachmentCmd cmd;
-                    cmd.m_fileId = fileId;
-
-                    uint32_t offset = i * maxCommandSize;
-                    uint32_t size =
-                        static_cast<uint32_t>((i != (nofParts - 1)) ? maxCommandSize : (_data.size() - offset));
-
-                    auto iter_begin = _data.begin() + offset;
-                    auto iter_end = iter_begin + size;
-                    std::copy(iter_begin, iter_end, std::back_inserter(cmd.m_data));
-
-                    cmd.m_size = size;
-                    cmd.m_offset = offset;
-
-                    boost::crc_32_type crc32;
-                    crc32.process_bytes(&(*iter_begin), size);
-
-                    cmd.m_crc32 = crc32.checksum();
+                pushBinaryAttachmentCmd(
+                    SSharedBinaryAttachment::makeFromData(_data), _fileName, _cmdSource, _protocolHeaderID);
+            }
 
-                    pushMsg<cmdBINARY_ATTACHMENT>(cmd, _protocolHeaderID);
-                }
+            /// \brief Sends the given shared attachment.
+            /// \details The attachment is already split into pieces and checksummed. Pieces reference its data.
+            void pushBinaryAttachmentCmd(SSharedBinaryAttachment::ptr_t _attachment,
+                                         const std::string& _fileName,
+                                         uint16_t _cmdSource,
+                                         uint64_t _protocolHeaderID)
+            {
+                binaryAttachmentSendInfoPtr_t info = std::make_shared<SBinaryAttachmentSendInfo>();
+                info->m_fileSize = _attachment->size();
+                const uint32_t fileCrc32 = _attachment->m_crc32;
+                info->m_attachment = std::move(_attachment);
+                pushBinaryAttachmentCmd(info, fileCrc32, _fileName, _cmdSource, _protocolHeaderID);
             }
 
-            void processBinaryAttachmentStartCmd(const SSenderInfo& /*_sender*/,
+            void processBinaryAttachmentStartCmd(const SSenderInfo& _sender,
                                                  SCommandAttachmentImpl<cmdBINARY_ATTACHMENT_START>::ptr_t _attachment)
             {
                 boost::uuids::uuid fileId = _attachment->m_fileId;
@@ -599,20 +733,44 @@ namespace dds
                     // Lock with global map mutex
                     std::lock_guard<std::mutex> lock(m_binaryAttachmentMutex);
 
-                    binaryAttachmentMap_t::iterator iter_info = m_binaryAttachmentMap.find(fileId);
-                    bool exists = iter_info != m_binaryAttachmentMap.end();
+                    if (m_binaryAttachmentMap.find(fileId) != m_binaryAttachmentMap.end())
+                        return;
+                }
 
-                    if (!exists)
-                    {
-                        m_binaryAttachmentMap[fileId] = std::make_shared<SBinaryAttachmentInfo>();
-                        iter_info = m_binaryAttachmentMap.find(fileId);
-                        iter_info->second->m_startTime = std::chrono::steady_clock::now();
-                        iter_info->second->m_fileName = _attachment->m_fileName;
-                        iter_info->second->m_fileSize = _attachment->m_fileSize;
-                        iter_info->second->m_fileCrc32 = _attachment->m_fileCrc32;
-                        iter_info->second->m_srcCommand = _attachment->m_srcCommand;
-                        iter_info->second->m_data.resize(_attachment->m_fileSize);
-                    }
+                binaryAttachmentInfoPtr_t info = std::make_shared<SBinaryAttachmentInfo>();
+                info->m_startTime = std::chrono::steady_clock::now();
+                info->m_fileName = _attachment->m_fileName;
+                info->m_fileSize = _attachment->m_fileSize;
+                info->m_fileCrc32 = _attachment->m_fileCrc32;
+                info->m_srcCommand = _attachment->m_srcCommand;
+
+                // Preallocate the file, pieces are written at their offsets
+                fs::path dir(user_defaults_api::CUserDefaults::instance().getWrkDir());
+                const std::string tmpFilePath(dir.append(to_string(fileId) + ".part").string());
+                info->m_fd = ::open(tmpFilePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+                if (info->m_fd != -1)
+                    info->m_tmpFilePath = tmpFilePath;
+                if (info->m_fd == -1 || ::ftruncate(info->m_fd, info->m_fileSize) != 0)
+                {
+                    std::stringstream ss;
+                    ss << "Could not create file " << tmpFilePath << ": " << std::strerror(errno);
+                    LOG(dds::misc::error) << ss.str();
+                    sendYourself<cmdSIMPLE_MSG>(SSimpleMsgCmd(ss.str(), dds::misc::error, info->m_srcCommand),
+                                                _sender.m_ID);
+                    return;
+                }
+
+                // An empty file has no pieces, it is complete right away
+                if (info->m_fileSize == 0)
+                {
+                    finalizeBinaryAttachment(_sender, fileId, info);
+                    return;
+                }
+
+                {
+                    // Lock with global map mutex
+                    std::lock_guard<std::mutex> lock(m_binaryAttachmentMutex);
+                    m_binaryAttachmentMap.emplace(fileId, info);
                 }
             }
 
@@ -621,13 +779,12 @@ namespace dds
             {
                 boost::uuids::uuid fileId = _attachment->m_fileId;
                 binaryAttachmentInfoPtr_t info;
-                binaryAttachmentMap_t::iterator iter_info;
 
                 {
                     // Lock with global map mutex
                     std::lock_guard<std::mutex> lock(m_binaryAttachmentMutex);
 
-                    iter_info = m_binaryAttachmentMap.find(fileId);
+                    binaryAttachmentMap_t::iterator iter_info = m_binaryAttachmentMap.find(fileId);
                     bool exists = iter_info != m_binaryAttachmentMap.end();
 
                     if (!exists)
@@ -639,24 +796,37 @@ namespace dds
                     info = iter_info->second;
                 }
 
+                if (_attachment->m_size == 0)
+                {
+                    // The sender failed to read the file, it has already reported the error
+                    std::stringstream ss;
+                    ss << "Binary attachment [" << fileId << "] is aborted by the sender at offset "
+                       << _attachment->m_offset;
+                    onBinaryAttachmentError(_sender, fileId, info, ss.str());
+                    return;
+                }
+
+                const SByteView payload(_attachment->payload());
                 boost::crc_32_type crc32;
-                crc32.process_bytes(&_attachment->m_data[0], _attachment->m_data.size());
+                crc32.process_bytes(payload.data(), payload.size());
 
                 if (crc32.checksum() != _attachment->m_crc32)
                 {
-                    {
-                        // Lock with global map mutex
-                        std::lock_guard<std::mutex> lock(m_binaryAttachmentMutex);
-                        // Remove info from map
-                        m_binaryAttachmentMap.erase(iter_info);
-                    }
                     std::stringstream ss;
                     ss << "Received binary attachment [" << fileId << "] has wrong CRC32 checksum: " << crc32.checksum()
                        << " instead of " << _attachment->m_crc32 << "offset=" << _attachment->m_offset
                        << " size=" << _attachment->m_size;
-                    LOG(dds::misc::error) << ss.str();
-                    sendYourself<cmdSIMPLE_MSG>(SSimpleMsgCmd(ss.str(), dds::misc::error, info->m_srcCommand),
-                                                _sender.m_ID);
+                    onBinaryAttachmentError(_sender, fileId, info, ss.str());
+                    return;
+                }
+
+                if (payload.size() != _attachment->m_size ||
+                    static_cast<uint64_t>(_attachment->m_offset) + payload.size() > info->m_fileSize)
+                {
+                    std::stringstream ss;
+                    ss << "Received binary attachment [" << fileId << "] has wrong size: offset=" << _attachment->m_offset
+                       << " size=" << payload.size() << " file size=" << info->m_fileSize;
+                    onBinaryAttachmentError(_sender, fileId, info, ss.str());
                     return;
                 }
 
@@ -665,75 +835,45 @@ namespace dds
                     // Lock with local mutex for each file
                     std::lock_guard<std::mutex> lock(info->m_mutex);
 
-                    info->m_bytesReceived += _attachment->m_size;
-
-                    std::copy(_attachment->m_data.begin(),
-                              _attachment->m_data.end(),
-                              info->m_data.begin() + _attachment->m_offset);
+                    if (info->m_fd == -1)
+                        return; // The file is already processed
 
-                    allBytesReceived = info->m_bytesReceived == info->m_fileSize;
-                    if (allBytesReceived)
+                    size_t written(0);
+                    while (written < payload.size())
                     {
-                        // Check file CRC32
-                        boost::crc_32_type crc32;
-                        crc32.process_bytes(&info->m_data[0], info->m_data.size());
-
-                        if (crc32.checksum() != info->m_fileCrc32)
+                        ssize_t n = ::pwrite(info->m_fd,
+                                             payload.data() + written,
+                                             payload.size() - written,
+                                             _attachment->m_offset + written);
+                        if (n == -1 && errno == EINTR)
+                            continue;
+                        if (n <= 0)
                         {
-                            {
-                                // Lock with global map mutex
-                                std::lock_guard<std::mutex> lock(m_binaryAttachmentMutex);
-                                // Remove info from map
-                                m_binaryAttachmentMap.erase(iter_info);
-                            }
                             std::stringstream ss;
-                            ss << "Received binary file [" << fileId
-                               << "] has wrong CRC32 checksum: " << crc32.checksum() << " instead of "
-                               << _attachment->m_crc32;
-                            LOG(dds::misc::error) << ss.str();
-                            sendYourself<cmdSIMPLE_MSG>(SSimpleMsgCmd(ss.str(), dds::misc::error, info->m_srcCommand),
-                                                        _sender.m_ID);
-                            return;
-                        }
-
-                        fs::path dir(user_defaults_api::CUserDefaults::instance().getWrkDir());
-                        const std::string filePath(dir.append(to_string(fileId)).string());
-                        std::ofstream f(filePath.c_str());
-                        if (!f.is_open() || !f.good())
-                        {
-                            {
-                                // Lock with global map mutex
-                                std::lock_guard<std::mutex> lock(m_binaryAttachmentMutex);
-                                // Remove info from map
-                                m_binaryAttachmentMap.erase(iter_info);
-                            }
-                            std::stringstream ss;
-                            ss << "Could not open file: " << filePath;
-                            LOG(dds::misc::error) << ss.str();
-                            sendYourself<cmdSIMPLE_MSG>(SSimpleMsgCmd(ss.str(), dds::misc::error, info->m_srcCommand),
-                                                        _sender.m_ID);
+                            ss << "Could not write binary attachment [" << fileId << "] to " << info->m_tmpFilePath
+                               << ": " << std::strerror(errno);
+                            onBinaryAttachmentError(_sender, fileId, info, ss.str());
                             return;
                         }
+                        written += n;
+                    }
 
-                        for (const auto& v : info->m_data)
-                        {
-                            f << v;
-                        }
-                        f.close();
-
-                        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
-                        std::chrono::microseconds downloadTime =
-                            std::chrono::duration_cast<std::chrono::microseconds>(now - info->m_startTime);
-
-                        // Send message to yourself
-                        SBinaryAttachmentReceivedCmd reply_cmd;
-                        reply_cmd.m_receivedFilePath = filePath;
-                        reply_cmd.m_requestedFileName = info->m_fileName;
-                        reply_cmd.m_srcCommand = info->m_srcCommand;
-                        reply_cmd.m_downloadTime = static_cast<uint32_t>(downloadTime.count());
-                        reply_cmd.m_receivedFileSize = info->m_fileSize;
-                        sendYourself<cmdBINARY_ATTACHMENT_RECEIVED>(reply_cmd, _sender.m_ID);
+                    // Pieces of a file are sent in order, thus the file checksum is calculated on the fly
+                    if (info->m_isInOrder && _attachment->m_offset == info->m_nextOffset)
+                    {
+                        info->m_crc32.process_bytes(payload.data(), payload.size());
+                        info->m_nextOffset += _attachment->m_size;
                     }
+                    else
+                    {
+                        info->m_isInOrder = false;
+                    }
+
+                    info->m_bytesReceived += _attachment->m_size;
+
+                    allBytesReceived = info->m_bytesReceived == info->m_fileSize;
+                    if (allBytesReceived && !finalizeBinaryAttachment(_sender, fileId, info))
+                        return;
                 }
 
                 if (allBytesReceived)
@@ -741,10 +881,65 @@ namespace dds
                     // Lock with global map mutex
                     std::lock_guard<std::mutex> lock(m_binaryAttachmentMutex);
                     // Remove info from map
-                    m_binaryAttachmentMap.erase(iter_info);
+                    m_binaryAttachmentMap.erase(fileId);
+                }
+            }
+
+            /// \brief Unpacks a batch frame and processes the packed messages one by one.
+            void processBatchCmd(SCommandAttachmentImpl<cmdBATCH>::ptr_t _attachment)
+            {
+                // The remote end sends batch frames, thus it can receive them as well
+                m_isBatchSupported = true;
+
+                T* pThis = static_cast<T*>(this);
+                for (const auto& v : _attachment->m_msgs)
+                {
+                    if (v.m_cmd == cmdBATCH)
+                    {
+                        LOG(dds::misc::error) << "Nested batch frames are not supported. Received from "
+                                              << remoteEndIDString();
+                        continue;
+                    }
+
+                    CProtocolMessage::protocolMessagePtr_t msg =
+                        m_messagePool->acquire(CProtocolMessage::header_length + v.m_body.size());
+                    msg->encode(v.m_cmd, v.m_body.data(), v.m_body.size(), v.m_ID);
+                    msg->setLargeValueFormat(m_isLargeValuesSupported);
+                    pThis->processMessage(msg);
                 }
             }
 
+            /// \brief Uncompresses a compressed message and processes the original message.
+            void processCompressedMsg(const CProtocolMessage::protocolMessagePtr_t& _msg)
+            {
+                CProtocolMessage::protocolMessagePtr_t msg = m_messagePool->acquire(CProtocolMessage::header_length);
+                msg->decodeCompressed(*_msg);
+                if (msg->header().m_cmd == cmdCOMPRESSED)
+                {
+                    LOG(dds::misc::error) << "Nested compressed messages are not supported. Received from "
+                                          << remoteEndIDString();
+                    return;
+                }
+
+                LOG(dds::misc::debug) << "Uncompressed a message from " << remoteEndIDString() << ": "
+                                      << _msg->body_length() << " -> " << msg->body_length() << " bytes";
+                T* pThis = static_cast<T*>(this);
+                pThis->processMessage(msg);
+            }
+
+            /// \brief Servers, which support g_protocolCommandsVersionCompression, reply to the handshake with their
+            /// SVersionCmd. Older servers send an empty reply.
+            void processReplyHandshakeOKMsg(const CProtocolMessage::protocolMessagePtr_t& _msg)
+            {
+                if (_msg->body_length() == 0)
+                    return;
+
+                const CProtocolMessage& msg = *_msg;
+                SVersionCmd remoteVersion;
+                remoteVersion.convertFromData(SByteView(msg.body(), msg.body_length()));
+                setRemoteCommandsVersion(remoteVersion.m_commandsVersion);
+            }
+
             bool started()
             {
                 return m_started;
@@ -757,8 +952,7 @@ namespace dds
                 {
                     T* pThis = static_cast<T*>(this);
                     std::stringstream ss;
-                    ss << pThis->_remoteEndIDString() << " [" << socket().remote_endpoint().address().to_string()
-                       << "]";
+                    ss << pThis->_remoteEndIDString() << " [" << remoteAddress() << "]";
                     return ss.str();
                 }
                 catch (...)
@@ -772,26 +966,300 @@ namespace dds
                 return m_protocolHeaderID;
             }
 
+            /// \brief Returns hit/miss counters of the pool of received messages.
+            CProtocolMessagePool::SStats getMessagePoolStats() const
+            {
+                return m_messagePool->getStats();
+            }
+
+            /// \brief Backpressure signal. Senders should hold back or drop messages, which can be skipped, while the
+            /// write queue is congested.
+            bool isWriteQueueCongested() const
+            {
+                return m_writeQueueMonitor.isCongested();
+            }
+
+            /// \brief Returns depth and size of the write queue, which includes messages being sent.
+            SWriteQueueStats getWriteQueueStats() const
+            {
+                return m_writeQueueMonitor.getStats();
+            }
+
+            void setWriteQueueLimits(const SWriteQueueLimits& _limits)
+            {
+                m_writeQueueMonitor.setLimits(_limits);
+            }
+
+            /// \brief Sets the coalescing policy of messages of the given type pushed via accumulativePushMsg.
+            void setCoalescingPolicy(ECmdType _cmd, const SCoalescingPolicy& _policy)
+            {
+                std::lock_guard<std::mutex> lock(m_mutexWriteSettings);
+                m_coalescingWindow.setPolicy(_cmd, _policy);
+            }
+
+            /// \brief True if the remote end can receive batch frames, see g_protocolCommandsVersionBatch.
+            bool isBatchSupported() const
+            {
+                return m_isBatchSupported;
+            }
+
+            /// \brief True if the remote end can receive compressed messages, see g_protocolCommandsVersionCompression.
+            bool isCompressionSupported() const
+            {
+                return m_isCompressionSupported;
+            }
+
+            /// \brief True if the remote end can receive values exceeding 2^16 symbols, see
+            /// g_protocolCommandsVersionLargeValues.
+            bool isLargeValuesSupported() const
+            {
+                return m_isLargeValuesSupported;
+            }
+
+            /// \brief True if the remote end can process cmdASSIGN_USER_TASKS, see
+            /// g_protocolCommandsVersionAssignUserTasks.
+            bool isAssignUserTasksSupported() const
+            {
+                return m_isAssignUserTasksSupported;
+            }
+
+            /// \brief True if the remote end keeps uploaded files in its file cache, see
+            /// g_protocolCommandsVersionFileCache.
+            bool isFileCacheSupported() const
+            {
+                return m_isFileCacheSupported;
+            }
+
+            /// \brief True if the remote end subscribes on cmdUSER_TASK_DONE, see
+            /// g_protocolCommandsVersionTaskDoneSubscription.
+            bool isTaskDoneSubscriptionSupported() const
+            {
+                return m_isTaskDoneSubscriptionSupported;
+            }
+
+            /// \brief Messages with bodies of at least _threshold bytes are compressed, if the remote end supports it.
+            /// \param _level zlib compression level from 1 (fastest) to 9 (best), 0 - no compression.
+            void setCompression(unsigned int _level, size_t _threshold)
+            {
+                std::lock_guard<std::mutex> lock(m_mutexWriteSettings);
+                m_compressionLevel = std::min(_level, 9u);
+                // Compression doesn't pay off for tiny messages
+                m_compressionThreshold = std::max<size_t>(_threshold, 64);
+            }
+
+            /// \brief Sets the coalescing policy of message types, which don't have an own policy.
+            void setDefaultCoalescingPolicy(const SCoalescingPolicy& _policy)
+            {
+                std::lock_guard<std::mutex> lock(m_mutexWriteSettings);
+                m_coalescingWindow.setDefaultPolicy(_policy);
+            }
+
           private:
             uint64_t adjustProtocolHeaderID(uint64_t _protocolHeaderID) const
             {
                 return _protocolHeaderID != 0 ? _protocolHeaderID : m_protocolHeaderID;
             }
 
+            void onBinaryAttachmentError(const SSenderInfo& _sender,
+                                         const boost::uuids::uuid& _fileId,
+                                         binaryAttachmentInfoPtr_t _info,
+                                         const std::string& _msg)
+            {
+                {
+                    // Lock with global map mutex
+                    std::lock_guard<std::mutex> lock(m_binaryAttachmentMutex);
+                    // Remove info from map, the incomplete file is removed with the info
+                    m_binaryAttachmentMap.erase(_fileId);
+                }
+                _info->closeFile();
+                LOG(dds::misc::error) << _msg;
+                sendYourself<cmdSIMPLE_MSG>(SSimpleMsgCmd(_msg, dds::misc::error, _info->m_srcCommand), _sender.m_ID);
+            }
+
+            /// \brief Checks the checksum of the complete file, moves it to its final place and notifies the handlers.
+            /// \return false on error, the error is already reported.
+            bool finalizeBinaryAttachment(const SSenderInfo& _sender,
+                                          const boost::uuids::uuid& _fileId,
+                                          const binaryAttachmentInfoPtr_t& _info)
+            {
+                _info->closeFile();
+
+                // Check file CRC32
+                uint32_t fileCrc32 =
+                    _info->m_isInOrder ? _info->m_crc32.checksum() : fileChecksum(_info->m_tmpFilePath);
+                if (fileCrc32 != _info->m_fileCrc32)
+                {
+                    std::stringstream ss;
+                    ss << "Received binary file [" << _fileId << "] has wrong CRC32 checksum: " << fileCrc32
+                       << " instead of " << _info->m_fileCrc32;
+                    onBinaryAttachmentError(_sender, _fileId, _info, ss.str());
+                    return false;
+                }
+
+                fs::path dir(user_defaults_api::CUserDefaults::instance().getWrkDir());
+                const std::string filePath(dir.append(to_string(_fileId)).string());
+                // The complete file appears atomically
+                if (::rename(_info->m_tmpFilePath.c_str(), filePath.c_str()) != 0)
+                {
+                    std::stringstream ss;
+                    ss << "Could not rename " << _info->m_tmpFilePath << " to " << filePath << ": "
+                       << std::strerror(errno);
+                    onBinaryAttachmentError(_sender, _fileId, _info, ss.str());
+                    return false;
+                }
+                _info->m_tmpFilePath.clear();
+
+                std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                std::chrono::microseconds downloadTime =
+                    std::chrono::duration_cast<std::chrono::microseconds>(now - _info->m_startTime);
+
+                // Send message to yourself
+                SBinaryAttachmentReceivedCmd reply_cmd;
+                reply_cmd.m_receivedFilePath = filePath;
+                reply_cmd.m_requestedFileName = _info->m_fileName;
+                reply_cmd.m_srcCommand = _info->m_srcCommand;
+                reply_cmd.m_downloadTime = static_cast<uint32_t>(downloadTime.count());
+                reply_cmd.m_receivedFileSize = _info->m_fileSize;
+                sendYourself<cmdBINARY_ATTACHMENT_RECEIVED>(reply_cmd, _sender.m_ID);
+                return true;
+            }
+
+            /// \brief Calculates CRC32 of the given file, reading it piece by piece.
+            static uint32_t fileChecksum(const std::string& _filePath)
+            {
+                std::ifstream f(_filePath, std::ios::binary);
+                boost::crc_32_type crc32;
+                std::vector<char> buf(maxBinaryAttachmentPieceSize);
+                while (f.read(buf.data(), buf.size()) || f.gcount() > 0)
+                    crc32.process_bytes(buf.data(), f.gcount());
+                return crc32.checksum();
+            }
+
+            void pushBinaryAttachmentCmd(binaryAttachmentSendInfoPtr_t _info,
+                                         uint32_t _fileCrc32,
+                                         const std::string& _fileName,
+                                         uint16_t _cmdSource,
+                                         uint64_t _protocolHeaderID)
+            {
+                _info->m_fileId = boost::uuids::random_generator()();
+                _info->m_protocolHeaderID = _protocolHeaderID;
+                _info->m_srcCommand = _cmdSource;
+
+                // Generate start message
+                SBinaryAttachmentStartCmd start_cmd;
+                start_cmd.m_fileId = _info->m_fileId;
+                start_cmd.m_srcCommand = _cmdSource;
+                start_cmd.m_fileName = _fileName;
+                start_cmd.m_fileSize = _info->m_fileSize;
+                start_cmd.m_fileCrc32 = _fileCrc32;
+                pushMsg<cmdBINARY_ATTACHMENT_START>(start_cmd, _protocolHeaderID);
+
+                if (_info->m_fileSize == 0)
+                    return;
+
+                {
+                    std::lock_guard<std::mutex> lock(m_binaryAttachmentSendMutex);
+                    m_binaryAttachmentSendQueue.push_back(_info);
+                }
+                pushBinaryAttachmentPieces();
+            }
+
+            /// \brief Queues the next pieces of outgoing binary attachments, as long as the window allows.
+            /// \details If a file can't be read, the transfer is aborted with an empty piece, thus the remote end
+            /// drops the incomplete file. The error is reported to the handlers of this channel.
+            void pushBinaryAttachmentPieces()
+            {
+                std::vector<std::pair<SSimpleMsgCmd, uint64_t>> errors;
+                {
+                    std::lock_guard<std::mutex> lock(m_binaryAttachmentSendMutex);
+                    pushBinaryAttachmentPieces(errors);
+                }
+                // Handlers might push new attachments
+                for (const auto& error : errors)
+                    sendYourself<cmdSIMPLE_MSG>(error.first, error.second);
+            }
+
+            /// \note m_binaryAttachmentSendMutex must be locked.
+            void pushBinaryAttachmentPieces(std::vector<std::pair<SSimpleMsgCmd, uint64_t>>& _errors)
+            {
+                while (m_nofBinaryAttachmentPiecesInFlight < maxBinaryAttachmentPiecesInFlight &&
+                       !m_binaryAttachmentSendQueue.empty())
+                {
+                    binaryAttachmentSendInfoPtr_t info = m_binaryAttachmentSendQueue.front();
+
+                    SBinaryAttachmentCmd cmd;
+                    cmd.m_fileId = info->m_fileId;
+                    cmd.m_offset = info->m_offset;
+                    cmd.m_size = std::min<uint32_t>(maxBinaryAttachmentPieceSize, info->m_fileSize - info->m_offset);
+
+                    if (info->m_attachment != nullptr)
+                    {
+                        // The piece and its checksum are ready
+                        cmd.setPayload(info->m_attachment->piece(cmd.m_offset), info->m_attachment);
+                        cmd.m_crc32 = info->m_attachment->pieceCrc32(cmd.m_offset);
+                    }
+                    else
+                    {
+                        cmd.m_data.resize(cmd.m_size);
+                        info->m_file.read(reinterpret_cast<char*>(cmd.m_data.data()), cmd.m_size);
+                        if (static_cast<uint32_t>(info->m_file.gcount()) != cmd.m_size)
+                        {
+                            std::stringstream ss;
+                            ss << "Failed to read binary attachment [" << info->m_fileId << "] from "
+                               << info->m_filePath << " at offset " << cmd.m_offset;
+                            LOG(dds::misc::error) << ss.str();
+                            m_binaryAttachmentSendQueue.pop_front();
+                            _errors.emplace_back(SSimpleMsgCmd(ss.str(), dds::misc::error, info->m_srcCommand),
+                                                 info->m_protocolHeaderID);
+
+                            SBinaryAttachmentCmd abortCmd;
+                            abortCmd.m_fileId = info->m_fileId;
+                            abortCmd.m_offset = cmd.m_offset;
+                            ++m_nofBinaryAttachmentPiecesInFlight;
+                            pushMsg<cmdBINARY_ATTACHMENT>(abortCmd, info->m_protocolHeaderID);
+                            continue;
+                        }
+
+                        boost::crc_32_type crc32;
+                        crc32.process_bytes(cmd.m_data.data(), cmd.m_data.size());
+                        cmd.m_crc32 = crc32.checksum();
+                    }
+
+                    info->m_offset += cmd.m_size;
+                    if (info->m_offset == info->m_fileSize)
+                        m_binaryAttachmentSendQueue.pop_front();
+
+                    ++m_nofBinaryAttachmentPiecesInFlight;
+                    pushMsg<cmdBINARY_ATTACHMENT>(cmd, info->m_protocolHeaderID);
+                }
+            }
+
+            void onBinaryAttachmentPiecesSent(size_t _nofPieces)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_binaryAttachmentSendMutex);
+                    m_nofBinaryAttachmentPiecesInFlight -= std::min(_nofPieces, m_nofBinaryAttachmentPiecesInFlight);
+                }
+                pushBinaryAttachmentPieces();
+            }
+
             void readHeader()
             {
                 auto self(this->shared_from_this());
                 boost::asio::async_read(
                     m_socket,
-                    boost::asio::buffer(m_currentMsg->data(), CProtocolMessage::header_length),
+                    boost::asio::buffer(m_headerBuffer),
                     [this, self](boost::system::error_code ec, std::size_t length)
                     {
                         if (!ec)
                         {
                             LOG(dds::misc::debug) << "Received message HEADER from " << remoteEndIDString() << ": "
                                                   << length << " bytes, expected " << CProtocolMessage::header_length;
+                            // Take a message with a buffer large enough for the body from the pool
+                            m_currentMsg = m_messagePool->acquire(m_headerBuffer.data());
+                            m_currentMsg->setLargeValueFormat(m_isLargeValuesSupported);
                         }
-                        if (!ec && m_currentMsg->decode_header())
+                        if (!ec)
                         {
                             // If the header is ok, receive the body of the message
                             readBody();
@@ -827,7 +1295,7 @@ namespace dds
                     pThis->processMessage(m_currentMsg);
 
                     // Read next message
-                    m_currentMsg = std::make_shared<CProtocolMessage>();
+                    m_currentMsg.reset();
                     readHeader();
                     return;
                 }
@@ -848,7 +1316,7 @@ namespace dds
                             pThis->processMessage(m_currentMsg);
 
                             // Read next message
-                            m_currentMsg = std::make_shared<CProtocolMessage>();
+                            m_currentMsg.reset();
                             readHeader();
                         }
                         else if ((boost::asio::error::eof == ec) || (boost::asio::error::connection_reset == ec))
@@ -871,31 +1339,420 @@ namespace dds
             }
 
           private:
-            void writeMessage()
+            /// \brief Bulk messages are sent with lower priority than control messages.
+            static bool isBulkCmd(uint16_t _cmd)
+            {
+                return (_cmd == cmdBINARY_ATTACHMENT);
+            }
+
+            /// \brief Request to the writer, which owns the write queues.
+            struct SWriteRequest
+            {
+                enum class EType
+                {
+                    Push,
+                    Accumulate,
+                    Dequeue
+                };
+                EType m_type;
+                ECmdType m_cmd;
+                CProtocolMessage::protocolMessagePtr_t m_msg;  ///< nullptr only wakes up the writer
+                CCoalescingWindow::clock_t::time_point m_time; ///< Arrival time of accumulated messages
+            };
+
+            /// \brief Queues the request for the writer and starts the writer, unless it's already running.
+            /// \details Producers never block each other or the writer. The writer takes all queued requests at once.
+            void pushWriteRequest(SWriteRequest&& _request)
+            {
+                m_writeRequests.push(std::move(_request));
+
+                // Pairs with the fence in writeMessage: either the writer sees the request, or we see it stopped
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (m_isWriting.load(std::memory_order_relaxed) ||
+                    m_isWriting.exchange(true, std::memory_order_acquire))
+                    return; // The running writer picks up the request
+
+                auto self(this->shared_from_this());
+                m_ioContext.post([this, self] { writeMessage(); });
+            }
+
+            /// \brief Puts the message into the write queue of its priority class.
+            /// \note Called by the writer only.
+            void enqueueWriteMsg(const CProtocolMessage::protocolMessagePtr_t& _msg)
+            {
+                // The handshake is done at this point, thus the capabilities of the remote end are known
+                if (_msg->isLargeValueFormat() && !m_isLargeValuesSupported)
+                {
+                    LOG(dds::misc::error) << "Remote end " << remoteEndIDString()
+                                          << " doesn't support values exceeding 2^16 symbols. Dropped message: "
+                                          << _msg->toString();
+                    m_writeQueueMonitor.remove(_msg->length());
+                    return;
+                }
+                if (isBulkCmd(_msg->header().m_cmd))
+                    m_bulkWriteQueue.push_back(_msg);
+                else
+                    m_writeQueue.push_back(_msg);
+            }
+
+            /// \brief Accounts the message, which is about to be queued.
+            /// \return false if the write queue overflowed. The message must be dropped then and the channel is closed,
+            /// since the remote end doesn't keep up with the messages.
+            bool accountWriteMsg(const CProtocolMessage::protocolMessagePtr_t& _msg)
+            {
+                if (m_writeQueueMonitor.add(_msg->length()))
+                {
+                    reportWriteQueueCongestion();
+                    return true;
+                }
+
+                LOG(dds::misc::error) << "Write queue of " << remoteEndIDString() << " overflowed ("
+                                      << m_writeQueueMonitor.getStats().m_nofBytes
+                                      << " bytes are queued). Closing the connection. Dropped message: "
+                                      << _msg->toString();
+                auto self(this->shared_from_this());
+                m_ioContext.post([this, self] { stop(); });
+                return false;
+            }
+
+            /// \brief Logs the stats of the write queue, when it becomes congested and when it recovers.
+            void reportWriteQueueCongestion()
+            {
+                bool isCongested(false);
+                if (!m_writeQueueMonitor.takeCongestionChange(isCongested))
+                    return;
+
+                const SWriteQueueStats stats{ m_writeQueueMonitor.getStats() };
+                if (isCongested)
+                    LOG(dds::misc::warning) << "Write queue of " << remoteEndIDString() << " is congested: "
+                                            << stats.m_nofMessages << " messages, " << stats.m_nofBytes
+                                            << " bytes are queued. Congestions so far: " << stats.m_nofCongestions;
+                else
+                    LOG(dds::misc::info) << "Write queue of " << remoteEndIDString() << " is no longer congested: "
+                                         << stats.m_nofMessages << " messages, " << stats.m_nofBytes
+                                         << " bytes are queued (peak " << stats.m_maxNofMessages << " messages, "
+                                         << stats.m_maxNofBytes << " bytes). Dropped: " << stats.m_nofDropped;
+            }
+
+            /// \brief Takes all pending write requests and distributes their messages to the write queues.
+            /// \param _isWriteCompleted true if the requests were queued while the previous write was in progress.
+            /// \note Called by the writer only, m_mutexWriteSettings must be locked.
+            void processWriteRequests(bool _isWriteCompleted)
+            {
+                // Messages queued before the handshake go first
+                const bool isHandshakeOK = m_isHandshakeOK;
+                auto moveMsgsBeforeHandShake = [this, isHandshakeOK]()
+                {
+                    if (!isHandshakeOK || m_writeQueueBeforeHandShake.empty())
+                        return;
+                    for (const auto& msg : m_writeQueueBeforeHandShake)
+                        enqueueWriteMsg(msg);
+                    m_writeQueueBeforeHandShake.clear();
+                };
+
+                m_writeRequests.popAll(
+                    [&](SWriteRequest& _request)
+                    {
+                        switch (_request.m_type)
+                        {
+                            case SWriteRequest::EType::Push:
+                                if (_request.m_msg == nullptr)
+                                    break;
+                                if (isHandshakeOK)
+                                {
+                                    moveMsgsBeforeHandShake();
+                                    enqueueWriteMsg(_request.m_msg);
+                                }
+                                else if (isCmdAllowedWithoutHandshake(_request.m_cmd))
+                                {
+                                    m_writeQueue.push_back(_request.m_msg);
+                                }
+                                else
+                                {
+                                    m_writeQueueBeforeHandShake.push_back(_request.m_msg);
+                                }
+                                break;
+
+                            case SWriteRequest::EType::Accumulate:
+                            {
+                                m_accumulativeWriteQueue.push_back(_request.m_msg);
+                                const bool isLinkIdle =
+                                    !_isWriteCompleted && m_writeQueue.empty() && m_bulkWriteQueue.empty();
+                                if (m_coalescingWindow.add(
+                                        _request.m_cmd, _request.m_msg->length(), isLinkIdle, _request.m_time))
+                                {
+                                    LOG(dds::misc::debug) << "copy accumulated queue to write queue "
+                                                             "m_accumulativeWriteQueue.size="
+                                                          << m_accumulativeWriteQueue.size()
+                                                          << " m_writeQueue.size=" << m_writeQueue.size();
+                                    moveAccumulatedMsgs(isHandshakeOK);
+                                }
+                                else if (m_accumulativeWriteQueue.size() == 1 ||
+                                         m_coalescingWindow.deadline() < m_deadlineTimer->expiry())
+                                {
+                                    // The first message of a batch or a message with a shorter latency budget sets the
+                                    // deadline
+                                    startCoalescingTimer();
+                                }
+                                break;
+                            }
+
+                            case SWriteRequest::EType::Dequeue:
+                                removeQueuedMsgs(_request.m_cmd);
+                                break;
+                        }
+                    });
+                moveMsgsBeforeHandShake();
+
+                if (!m_accumulativeWriteQueue.empty())
+                {
+                    // Accumulated messages are sent along with other messages, once the previous write has completed,
+                    // or when the deadline of the batch has expired
+                    const bool isDeadlineExpired = !m_coalescingWindow.empty() &&
+                                                   m_coalescingWindow.deadline() <= CCoalescingWindow::clock_t::now();
+                    const bool sendAlong =
+                        isHandshakeOK && (_isWriteCompleted || !m_writeQueue.empty() || !m_bulkWriteQueue.empty());
+                    if (isDeadlineExpired || sendAlong)
+                        moveAccumulatedMsgs(isHandshakeOK);
+                }
+
+                LOG(dds::misc::debug) << "Write queues of " << remoteEndIDString()
+                                      << ": WriteQueue size = " << m_writeQueue.size()
+                                      << " BulkWriteQueue size = " << m_bulkWriteQueue.size()
+                                      << " WriteQueueBeforeHandShake = " << m_writeQueueBeforeHandShake.size()
+                                      << " accumulativeWriteQueue size = " << m_accumulativeWriteQueue.size()
+                                      << " queued bytes = " << m_writeQueueMonitor.getStats().m_nofBytes;
+            }
+
+            /// \brief Removes queued messages of the given type.
+            /// \note Called by the writer only.
+            void removeQueuedMsgs(uint16_t _cmd)
+            {
+                for (auto queue : { &m_writeQueue, &m_bulkWriteQueue })
+                {
+                    queue->erase(std::remove_if(std::begin(*queue),
+                                                std::end(*queue),
+                                                [this, _cmd](const CProtocolMessage::protocolMessagePtr_t& _msg)
+                                                {
+                                                    if (_msg->header().m_cmd != _cmd)
+                                                        return false;
+                                                    m_writeQueueMonitor.remove(_msg->length());
+                                                    return true;
+                                                }),
+                                 std::end(*queue));
+                }
+            }
+
+            /// \brief Moves accumulated messages to the write queue.
+            /// \note Called by the writer only.
+            void moveAccumulatedMsgs(bool _isHandshakeOK)
+            {
+                for (const auto& msg : m_accumulativeWriteQueue)
+                {
+                    if (_isHandshakeOK)
+                        enqueueWriteMsg(msg);
+                    else
+                        m_writeQueueBeforeHandShake.push_back(msg);
+                }
+                m_accumulativeWriteQueue.clear();
+                m_coalescingWindow.reset();
+            }
+
+            /// \brief Wakes up the writer once the deadline of the current batch expires.
+            /// \note Called by the writer only.
+            void startCoalescingTimer()
+            {
+                // Cancels the pending wait
+                m_deadlineTimer->expires_at(m_coalescingWindow.deadline());
+                auto self(this->shared_from_this());
+                m_deadlineTimer->async_wait(
+                    [this, self](const boost::system::error_code& error)
+                    {
+                        if (error)
+                            return;
+                        // The writer sends the batch, unless it's already sent or a new batch is started
+                        pushWriteRequest(SWriteRequest{ SWriteRequest::EType::Push, cmdUNKNOWN, nullptr, {} });
+                    });
+            }
+
+            /// \brief Adds the message to the send buffer.
+            /// \note Called by the writer only.
+            void addToWriteBuffer(const CProtocolMessage::protocolMessagePtr_t& _msg)
+            {
+                LOG(dds::misc::debug) << "Sending to " << remoteEndIDString() << " a message: " << _msg->toString();
+                if (cmdSHUTDOWN == _msg->header().m_cmd)
+                    m_isShuttingDown = true;
+                const CProtocolMessage& msg = *_msg;
+                if (msg.hasSharedBody())
+                {
+                    // The header and the shared body are located in different buffers
+                    m_writeBuffer.push_back(boost::asio::buffer(msg.data(), CProtocolMessage::header_length));
+                    m_writeBuffer.push_back(boost::asio::buffer(msg.body(), msg.body_length()));
+                }
+                else
+                {
+                    addFrameToWriteBuffer(msg);
+                }
+                m_writeBufferQueue.push_back(_msg);
+            }
+
+            /// \brief Adds the buffer of the message to the send buffer. Big messages are compressed, if the remote end
+            /// supports it.
+            /// \note Messages with shared bodies are not compressed, since that would be repeated for each recipient.
+            /// \note Called by the writer only.
+            void addFrameToWriteBuffer(const CProtocolMessage& _msg)
+            {
+                if (m_isCompressionSupported && m_compressionLevel > 0 && _msg.body_length() >= m_compressionThreshold)
+                {
+                    unsigned int& backoff = m_compressionBackoff[_msg.header().m_cmd];
+                    if (backoff > 0)
+                    {
+                        --backoff;
+                    }
+                    else
+                    {
+                        CProtocolMessage::protocolMessagePtr_t frame = std::make_shared<CProtocolMessage>();
+                        if (frame->encodeCompressed(_msg, m_compressionLevel))
+                        {
+                            LOG(dds::misc::debug) << "Compressed a message to " << remoteEndIDString() << ": "
+                                                  << _msg.body_length() << " -> " << frame->body_length() << " bytes";
+                            m_writeBuffer.push_back(boost::asio::buffer(frame->data(), frame->length()));
+                            m_writeFrames.push_back(frame);
+                            return;
+                        }
+                        // The data is incompressible, e.g. an already compressed file. Don't waste time on the next
+                        // messages of this kind.
+                        backoff = compressionBackoff;
+                    }
+                }
+                m_writeBuffer.push_back(boost::asio::buffer(_msg.data(), _msg.length()));
+            }
+
+            /// \brief Small messages can be packed into batch frames.
+            static bool isBatchableMsg(const CProtocolMessage& _msg)
+            {
+                const uint16_t cmd = _msg.header().m_cmd;
+                return (_msg.body_length() <= maxBatchedMsgBodyLength && !isBulkCmd(cmd) && cmd != cmdBATCH &&
+                        cmd != cmdSHUTDOWN && cmd != cmdHANDSHAKE && cmd != cmdREPLY_HANDSHAKE_OK &&
+                        cmd != cmdREPLY_HANDSHAKE_ERR);
+            }
+
+            /// \brief Packs leading small control messages into one batch frame and adds it to the send buffer.
+            /// \details Packed messages are removed from the control queue.
+            /// \return true if the frame is full. The rest of the queue should wait for the next write then.
+            /// \note Called by the writer only.
+            bool addBatchToWriteBuffer()
+            {
+                m_writeBatch.clear();
+                size_t batchSize(0);
+                auto iter = m_writeQueue.begin();
+                for (; iter != m_writeQueue.end() && isBatchableMsg(**iter); ++iter)
+                {
+                    const CProtocolMessage& msg = **iter;
+                    batchSize += SBatchCmd::msgSize(msg.body_length());
+                    if (batchSize > maxBatchBodyLength)
+                        break;
+                    m_writeBatch.add(msg.header().m_cmd, msg.header().m_ID, SByteView(msg.body(), msg.body_length()));
+                }
+
+                // A single message doesn't need a frame
+                if (m_writeBatch.m_msgs.size() < 2)
+                {
+                    m_writeBatch.clear();
+                    return false;
+                }
+
+                const bool isFull = (iter != m_writeQueue.end() && isBatchableMsg(**iter));
+                m_writeBatchMsg->encodeAttachment(cmdBATCH, m_writeBatch, m_protocolHeaderID);
+                m_writeBatch.clear();
+                addFrameToWriteBuffer(*m_writeBatchMsg);
+
+                LOG(dds::misc::debug) << "Sending to " << remoteEndIDString() << " a batch of "
+                                      << std::distance(m_writeQueue.begin(), iter) << " messages";
+                // Keep the packed messages for the accounting of the write queue
+                m_writeBufferQueue.insert(m_writeBufferQueue.end(), m_writeQueue.begin(), iter);
+                m_writeQueue.erase(m_writeQueue.begin(), iter);
+                return isFull;
+            }
+
+            /// \brief Sends queued messages. Only one writer runs at a time, the one which has set m_isWriting.
+            /// \param _isWriteCompleted true if called on completion of the previous write.
+            void writeMessage(bool _isWriteCompleted = false)
+            {
+                try
+                {
+                    writeQueuedMessages(_isWriteCompleted);
+                }
+                catch (std::exception& ex)
+                {
+                    onWriteError(ex);
+                }
+            }
+
+            /// \brief Drops the state of the failed writer, releases the writer role and closes the channel.
+            /// \details Messages of the failed write are lost, thus the remote end would get an inconsistent stream.
+            /// \note Called by the writer only.
+            void onWriteError(const std::exception& _ex)
+            {
+                LOG(dds::misc::error) << "BaseChannelImpl can't write message to " << remoteEndIDString() << ": "
+                                      << _ex.what() << ". Closing the connection.";
+                for (auto queue : { &m_writeBufferQueue,
+                                    &m_writeQueue,
+                                    &m_bulkWriteQueue,
+                                    &m_writeQueueBeforeHandShake,
+                                    &m_accumulativeWriteQueue })
+                {
+                    for (const auto& msg : *queue)
+                        m_writeQueueMonitor.remove(msg->length());
+                    queue->clear();
+                }
+                m_writeBuffer.clear();
+                m_writeFrames.clear();
+                m_writeBatch.clear();
+                m_coalescingWindow.reset();
+                m_isWriting.store(false, std::memory_order_release);
+                stop();
+            }
+
+            /// \note Called by the writer only, see writeMessage.
+            void writeQueuedMessages(bool _isWriteCompleted)
             {
                 // To avoid sending of a bunch of small messages, we pack as many messages as possible into one write
                 // request (GH-38).
                 // Copy messages from the queue to send buffer (which should remain until the write handler is called)
+                // Settings are changed rarely, thus the writer locks them once per run
+                std::lock_guard<std::mutex> lockWriteSettings(m_mutexWriteSettings);
+                while (true)
                 {
-                    std::lock_guard<std::mutex> lockWriteBuffer(m_mutexWriteBuffer);
-                    if (!m_writeBuffer.empty())
-                        return; // a write is in progress, don't start anything
+                    processWriteRequests(_isWriteCompleted);
 
-                    if (m_writeQueue.empty())
-                        return; // There is nothing to send.
+                    if (!m_writeQueue.empty() || !m_bulkWriteQueue.empty())
+                        break;
 
-                    for (auto i : m_writeQueue)
-                    {
-                        LOG(dds::misc::debug)
-                            << "Sending to " << remoteEndIDString() << " a message: " << i->toString();
-                        if (cmdSHUTDOWN == i->header().m_cmd)
-                            m_isShuttingDown = true;
-                        m_writeBuffer.push_back(boost::asio::buffer(i->data(), i->length()));
-                        m_writeBufferQueue.push_back(i);
-                    }
+                    // There is nothing to send. Stop writing, unless a request has arrived in the meantime.
+                    m_isWriting.store(false, std::memory_order_release);
+                    // Pairs with the fence in pushWriteRequest
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    if (m_writeRequests.empty() || m_isWriting.exchange(true, std::memory_order_acquire))
+                        return;
+                }
+
+                // All pending control messages go first
+                const bool isBatchFull = m_isBatchSupported && addBatchToWriteBuffer();
+                if (!isBatchFull)
+                {
+                    for (const auto& msg : m_writeQueue)
+                        addToWriteBuffer(msg);
                     m_writeQueue.clear();
                 }
 
+                // Only one bulk message per write request, thus control messages wait for at most one bulk message
+                if (!m_bulkWriteQueue.empty())
+                {
+                    addToWriteBuffer(m_bulkWriteQueue.front());
+                    m_bulkWriteQueue.pop_front();
+                }
+
                 auto self(this->shared_from_this());
                 boost::asio::async_write(
                     m_socket,
@@ -916,15 +1773,24 @@ namespace dds
                                     stop();
                                 }
 
-                                // lock the modification of the container
-                                {
-                                    std::lock_guard<std::mutex> lock(m_mutexWriteBuffer);
-
-                                    m_writeBuffer.clear();
-                                    m_writeBufferQueue.clear();
-                                }
+                                // The writer owns the buffers, until it's done
+                                const size_t nofBinaryAttachmentPieces =
+                                    std::count_if(m_writeBufferQueue.begin(),
+                                                  m_writeBufferQueue.end(),
+                                                  [](const CProtocolMessage::protocolMessagePtr_t& _msg)
+                                                  { return (_msg->header().m_cmd == cmdBINARY_ATTACHMENT); });
+                                for (const auto& msg : m_writeBufferQueue)
+                                    m_writeQueueMonitor.remove(msg->length());
+                                reportWriteQueueCongestion();
+                                m_writeBuffer.clear();
+                                m_writeBufferQueue.clear();
+                                m_writeFrames.clear();
+
+                                // continue sending binary attachments
+                                if (nofBinaryAttachmentPieces > 0)
+                                    onBinaryAttachmentPiecesSent(nofBinaryAttachmentPieces);
                                 // we might need to send more messages
-                                writeMessage();
+                                writeMessage(true);
                             }
                             else if ((boost::asio::error::eof == _ec) || (boost::asio::error::connection_reset == _ec))
                             {
@@ -948,7 +1814,7 @@ namespace dds
                         }
                         catch (std::exception& ex)
                         {
-                            LOG(dds::misc::error) << "BaseChannelImpl can't write message (callback): " << ex.what();
+                            onWriteError(ex);
                         }
                     });
             }
@@ -973,37 +1839,92 @@ namespace dds
           private:
             void close()
             {
-                m_socket.close();
+                // Errors don't matter, the socket is released anyway
+                boost::system::error_code ec;
+                m_socket.close(ec);
             }
 
           protected:
-            bool m_isHandshakeOK;
+            /// \brief Enables the optional features supported by the remote end.
+            void setRemoteCommandsVersion(uint16_t _version)
+            {
+                if (_version >= g_protocolCommandsVersionBatch)
+                    m_isBatchSupported = true;
+                if (_version >= g_protocolCommandsVersionCompression)
+                    m_isCompressionSupported = true;
+                if (_version >= g_protocolCommandsVersionLargeValues)
+                    m_isLargeValuesSupported = true;
+                if (_version >= g_protocolCommandsVersionAssignUserTasks)
+                    m_isAssignUserTasksSupported = true;
+                if (_version >= g_protocolCommandsVersionFileCache)
+                    m_isFileCacheSupported = true;
+                if (_version >= g_protocolCommandsVersionTaskDoneSubscription)
+                    m_isTaskDoneSubscriptionSupported = true;
+                LOG(dds::misc::debug) << "Remote end " << remoteEndIDString() << " supports protocol commands version "
+                                      << _version;
+            }
+
+          protected:
+            std::atomic<bool> m_isHandshakeOK;                    ///< Set by the handshake handler, read by the writer
             EChannelType m_channelType;
             std::string m_sessionID;
             uint64_t m_protocolHeaderID;
             boost::asio::io_context& m_ioContext;
+            std::atomic<bool> m_isBatchSupported;                ///< Remote end can receive batch frames
+            std::atomic<bool> m_isCompressionSupported;          ///< Remote end can receive compressed messages
+            std::atomic<bool> m_isLargeValuesSupported;          ///< Remote end can receive values over 2^16 symbols
+            std::atomic<bool> m_isAssignUserTasksSupported;      ///< Remote end can process cmdASSIGN_USER_TASKS
+            std::atomic<bool> m_isFileCacheSupported;            ///< Remote end can process cmdCHECK_CACHED_FILES
+            std::atomic<bool> m_isTaskDoneSubscriptionSupported; ///< Remote end sends cmdSUBSCRIBE_ON_TASK_DONE
 
           private:
-            boost::asio::ip::tcp::socket m_socket;
+            socket_t m_socket;
             bool m_started;
+            std::array<CProtocolMessage::data_t, CProtocolMessage::header_length> m_headerBuffer;
             CProtocolMessage::protocolMessagePtr_t m_currentMsg;
+            CProtocolMessagePool::ptr_t m_messagePool; ///< Recycles buffers of received messages
+            CMPSCQueue<SWriteRequest> m_writeRequests; ///< Requests of producers to the writer
+            std::atomic<bool> m_isWriting;             ///< Set while a writer runs, it exclusively owns the write state
 
-            protocolMessagePtrQueue_t m_writeQueue;
+            protocolMessagePtrQueue_t m_writeQueue;     ///< Control messages
+            protocolMessagePtrQueue_t m_bulkWriteQueue; ///< Bulk messages, e.g. pieces of binary attachments
             protocolMessagePtrQueue_t m_writeQueueBeforeHandShake;
 
-            std::mutex m_mutexWriteBuffer;
+            std::mutex m_mutexWriteSettings; ///< Guards coalescing and compression settings used by the writer
             protocolMessageBuffer_t m_writeBuffer;
             protocolMessagePtrQueue_t m_writeBufferQueue;
+            CWriteQueueMonitor m_writeQueueMonitor; ///< Accounts all queued messages, which are not sent yet
 
             // BinaryAttachment
             typedef std::map<boost::uuids::uuid, binaryAttachmentInfoPtr_t> binaryAttachmentMap_t;
             binaryAttachmentMap_t m_binaryAttachmentMap;
             std::mutex m_binaryAttachmentMutex;
 
+            // Outgoing binary attachments
+            static constexpr uint32_t maxBinaryAttachmentPieceSize = SSharedBinaryAttachment::maxPieceSize;
+            static constexpr size_t maxBinaryAttachmentPiecesInFlight = 16;
+            std::deque<binaryAttachmentSendInfoPtr_t> m_binaryAttachmentSendQueue;
+            size_t m_nofBinaryAttachmentPiecesInFlight;
+            std::mutex m_binaryAttachmentSendMutex;
+
             protocolMessagePtrQueue_t m_accumulativeWriteQueue;
+            CCoalescingWindow m_coalescingWindow; ///< Decides when accumulated messages are sent
             deadlineTimerPtr_t m_deadlineTimer;
 
             bool m_isShuttingDown;
+
+            // Batch frames
+            static constexpr size_t maxBatchedMsgBodyLength = 4096; ///< Bigger messages are sent in own frames
+            static constexpr size_t maxBatchBodyLength = 64 * 1024; ///< Max size of packed messages in a frame
+            SBatchCmd m_writeBatch;                                 ///< Messages packed into the frame being sent
+            CProtocolMessage::protocolMessagePtr_t m_writeBatchMsg; ///< Frame being sent, its buffer is reused
+
+            // Compression
+            static constexpr unsigned int compressionBackoff = 16; ///< Messages not compressed after a failed attempt
+            unsigned int m_compressionLevel;
+            size_t m_compressionThreshold;
+            std::map<uint16_t, unsigned int> m_compressionBackoff; ///< Messages to skip per command
+            std::vector<CProtocolMessage::protocolMessagePtr_t> m_writeFrames; ///< Compressed frames being sent
         };
     } // namespace protocol_api
 } // namespace dds
@@ -9,6 +9,7 @@
 #include "INet.h"
 #include "def.h"
 // STD
+#include <limits>
 #include <sstream>
 #include <string>
 // BOOST
@@ -112,29 +113,123 @@ namespace dds
             return boost::uuids::uuid::static_size();
         }
 
+        ///
+        /// \brief Non-owning read-only view of a contiguous range of bytes.
+        /// \details Commands are decoded directly from the buffer of the protocol message via this view. The owner of the
+        /// buffer must outlive the view.
+        ///
+        struct SByteView
+        {
+            SByteView()
+                : m_data(nullptr)
+                , m_size(0)
+                , m_isLargeValueFormat(false)
+            {
+            }
+
+            SByteView(const uint8_t* _data, size_t _size, bool _isLargeValueFormat = false)
+                : m_data(_data)
+                , m_size(_size)
+                , m_isLargeValueFormat(_isLargeValueFormat)
+            {
+            }
+
+            SByteView(const dds::misc::BYTEVector_t& _data)
+                : m_data(_data.data())
+                , m_size(_data.size())
+                , m_isLargeValueFormat(false)
+            {
+            }
+
+            const uint8_t* data() const
+            {
+                return m_data;
+            }
+
+            size_t size() const
+            {
+                return m_size;
+            }
+
+            bool empty() const
+            {
+                return m_size == 0;
+            }
+
+            const uint8_t* begin() const
+            {
+                return m_data;
+            }
+
+            const uint8_t* end() const
+            {
+                return m_data + m_size;
+            }
+
+            uint8_t operator[](size_t _pos) const
+            {
+                return m_data[_pos];
+            }
+
+            /// \brief True if large values in the data are prefixed with the escaped 32-bit length.
+            /// \see readLargeValue
+            bool isLargeValueFormat() const
+            {
+                return m_isLargeValueFormat;
+            }
+
+          private:
+            const uint8_t* m_data;
+            size_t m_size;
+            bool m_isLargeValueFormat;
+        };
+
+        /// \brief Helper function calculating size of the byte view. It is serialized as vector of uint8_t.
+        template <>
+        inline size_t dsize<SByteView>(const SByteView& _value)
+        {
+            return _value.size() * sizeof(uint8_t) + sizeof(uint32_t);
+        }
+
+        /// \brief Helper function checking that _size bytes can be read from _data at position _pos.
+        inline void checkReadSize(const SByteView* _data, size_t _pos, size_t _size)
+        {
+            if (_pos + _size > _data->size())
+            {
+                std::stringstream ss;
+                ss << "Protocol message data is too short, can't read " << _size << " bytes at position " << _pos
+                   << " of " << _data->size();
+                throw std::runtime_error(ss.str());
+            }
+        }
+
         ///
         /// \brief Helper template function reading data from byte array.
         ///
         template <typename T>
-        void readData(T* _value, const dds::misc::BYTEVector_t* _data, size_t* _nPos);
+        void readData(T* _value, const SByteView* _data, size_t* _nPos);
 
         template <>
-        inline void readData<uint8_t>(uint8_t* _value, const dds::misc::BYTEVector_t* _data, size_t* _nPos)
+        inline void readData<uint8_t>(uint8_t* _value, const SByteView* _data, size_t* _nPos)
         {
             if (_data == nullptr || _nPos == nullptr || _value == nullptr)
                 throw std::invalid_argument("readDataFromContainer");
 
+            checkReadSize(_data, *_nPos, sizeof(uint8_t));
+
             *_value = (*_data)[*_nPos];
 
             ++(*_nPos);
         }
 
         template <>
-        inline void readData<uint16_t>(uint16_t* _value, const dds::misc::BYTEVector_t* _data, size_t* _nPos)
+        inline void readData<uint16_t>(uint16_t* _value, const SByteView* _data, size_t* _nPos)
         {
             if (_data == nullptr || _nPos == nullptr || _value == nullptr)
                 throw std::invalid_argument("readDataFromContainer");
 
+            checkReadSize(_data, *_nPos, sizeof(uint16_t));
+
             *_value = (*_data)[*_nPos];
             *_value += ((*_data)[++(*_nPos)] << 8);
 
@@ -144,11 +239,13 @@ namespace dds
         }
 
         template <>
-        inline void readData<uint32_t>(uint32_t* _value, const dds::misc::BYTEVector_t* _data, size_t* _nPos)
+        inline void readData<uint32_t>(uint32_t* _value, const SByteView* _data, size_t* _nPos)
         {
             if (_data == nullptr || _nPos == nullptr || _value == nullptr)
                 throw std::invalid_argument("readDataFromContainer");
 
+            checkReadSize(_data, *_nPos, sizeof(uint32_t));
+
             *_value = (*_data)[*_nPos];
             *_value += ((*_data)[++(*_nPos)] << 8);
             *_value += ((*_data)[++(*_nPos)] << 16);
@@ -160,11 +257,13 @@ namespace dds
         }
 
         template <>
-        inline void readData<uint64_t>(uint64_t* _value, const dds::misc::BYTEVector_t* _data, size_t* _nPos)
+        inline void readData<uint64_t>(uint64_t* _value, const SByteView* _data, size_t* _nPos)
         {
             if (_data == nullptr || _nPos == nullptr || _value == nullptr)
                 throw std::invalid_argument("readDataFromContainer");
 
+            checkReadSize(_data, *_nPos, sizeof(uint64_t));
+
             *_value = (*_data)[*_nPos];
             *_value += ((uint64_t)(*_data)[++(*_nPos)] << 8);
             *_value += ((uint64_t)(*_data)[++(*_nPos)] << 16);
@@ -180,7 +279,7 @@ namespace dds
         }
 
         template <>
-        inline void readData<std::string>(std::string* _value, const dds::misc::BYTEVector_t* _data, size_t* _nPos)
+        inline void readData<std::string>(std::string* _value, const SByteView* _data, size_t* _nPos)
         {
             if (_data == nullptr || _nPos == nullptr || _value == nullptr)
                 throw std::invalid_argument("readDataFromContainer");
@@ -193,33 +292,27 @@ namespace dds
             uint16_t n = 0;
             readData(&n, _data, _nPos);
 
-            dds::misc::BYTEVector_t::const_iterator iter = _data->begin();
-            std::advance(iter, *_nPos);
-            dds::misc::BYTEVector_t::const_iterator iter_end = _data->begin();
-            std::advance(iter_end, (*_nPos + n));
-            std::copy(iter, iter_end, back_inserter(*_value));
+            checkReadSize(_data, *_nPos, n);
+            _value->append(reinterpret_cast<const char*>(_data->data() + *_nPos), n);
 
             *_nPos += n;
         }
 
         template <>
-        inline void readData<boost::uuids::uuid>(boost::uuids::uuid* _value,
-                                                 const dds::misc::BYTEVector_t* _data,
-                                                 size_t* _nPos)
+        inline void readData<boost::uuids::uuid>(boost::uuids::uuid* _value, const SByteView* _data, size_t* _nPos)
         {
             if (_data == nullptr || _nPos == nullptr || _value == nullptr)
                 throw std::invalid_argument("readDataFromContainer");
 
-            dds::misc::BYTEVector_t::const_iterator iter = _data->begin();
-            std::advance(iter, *_nPos);
-            dds::misc::BYTEVector_t::const_iterator iter_end = _data->begin();
-            std::advance(iter_end, (*_nPos + boost::uuids::uuid::static_size()));
-            copy(iter, iter_end, _value->begin());
+            checkReadSize(_data, *_nPos, boost::uuids::uuid::static_size());
+
+            const uint8_t* iter = _data->begin() + *_nPos;
+            std::copy(iter, iter + boost::uuids::uuid::static_size(), _value->begin());
             (*_nPos) += boost::uuids::uuid::static_size();
         }
 
         template <typename T>
-        inline void readDataVector(std::vector<T>* _value, const dds::misc::BYTEVector_t* _data, size_t* _nPos)
+        inline void readDataVector(std::vector<T>* _value, const SByteView* _data, size_t* _nPos)
         {
             if (_data == nullptr || _nPos == nullptr || _value == nullptr)
                 throw std::invalid_argument("readDataFromContainer");
@@ -243,7 +336,7 @@ namespace dds
 
         template <>
         inline void readData<std::vector<uint8_t>>(std::vector<uint8_t>* _value,
-                                                   const dds::misc::BYTEVector_t* _data,
+                                                   const SByteView* _data,
                                                    size_t* _nPos)
         {
             if (_data == nullptr || _nPos == nullptr || _value == nullptr)
@@ -256,18 +349,32 @@ namespace dds
             uint32_t n = 0;
             readData(&n, _data, _nPos);
 
-            dds::misc::BYTEVector_t::const_iterator iter = _data->begin();
-            std::advance(iter, *_nPos);
-            dds::misc::BYTEVector_t::const_iterator iter_end = _data->begin();
-            std::advance(iter_end, (*_nPos + n));
-            std::copy(iter, iter_end, back_inserter(*_value));
+            checkReadSize(_data, *_nPos, n);
+            const uint8_t* iter = _data->begin() + *_nPos;
+            _value->insert(_value->end(), iter, iter + n);
+
+            *_nPos += n;
+        }
+
+        /// \brief Reads a vector of uint8_t without copying it. The resulting view references _data.
+        template <>
+        inline void readData<SByteView>(SByteView* _value, const SByteView* _data, size_t* _nPos)
+        {
+            if (_data == nullptr || _nPos == nullptr || _value == nullptr)
+                throw std::invalid_argument("readDataFromContainer");
+
+            uint32_t n = 0;
+            readData(&n, _data, _nPos);
+
+            checkReadSize(_data, *_nPos, n);
+            *_value = SByteView(_data->data() + *_nPos, n);
 
             *_nPos += n;
         }
 
         template <>
         inline void readData<std::vector<uint16_t>>(std::vector<uint16_t>* _value,
-                                                    const dds::misc::BYTEVector_t* _data,
+                                                    const SByteView* _data,
                                                     size_t* _nPos)
         {
             readDataVector<uint16_t>(_value, _data, _nPos);
@@ -275,7 +382,7 @@ namespace dds
 
         template <>
         inline void readData<std::vector<uint32_t>>(std::vector<uint32_t>* _value,
-                                                    const dds::misc::BYTEVector_t* _data,
+                                                    const SByteView* _data,
                                                     size_t* _nPos)
         {
             readDataVector<uint32_t>(_value, _data, _nPos);
@@ -283,7 +390,7 @@ namespace dds
 
         template <>
         inline void readData<std::vector<uint64_t>>(std::vector<uint64_t>* _value,
-                                                    const dds::misc::BYTEVector_t* _data,
+                                                    const SByteView* _data,
                                                     size_t* _nPos)
         {
             readDataVector<uint64_t>(_value, _data, _nPos);
@@ -291,7 +398,7 @@ namespace dds
 
         template <>
         inline void readData<std::vector<std::string>>(std::vector<std::string>* _value,
-                                                       const dds::misc::BYTEVector_t* _data,
+                                                       const SByteView* _data,
                                                        size_t* _nPos)
         {
             readDataVector<std::string>(_value, _data, _nPos);
@@ -366,7 +473,7 @@ namespace dds
 
             uint16_t n = _value.size();
             pushData(n, _data);
-            copy(_value.begin(), _value.end(), back_inserter(*_data));
+            _data->insert(_data->end(), _value.begin(), _value.end());
         }
 
         template <>
@@ -375,7 +482,7 @@ namespace dds
             if (_data == nullptr)
                 throw std::invalid_argument("pushDataFromContainer");
 
-            copy(_value.begin(), _value.end(), back_inserter(*_data));
+            _data->insert(_data->end(), _value.begin(), _value.end());
         }
 
         template <typename T>
@@ -410,7 +517,22 @@ namespace dds
 
             uint32_t n = static_cast<uint32_t>(_value.size());
             pushData(n, _data);
-            copy(_value.begin(), _value.end(), back_inserter(*_data));
+            _data->insert(_data->end(), _value.begin(), _value.end());
+        }
+
+        template <>
+        inline void pushData<SByteView>(const SByteView& _value, dds::misc::BYTEVector_t* _data)
+        {
+            if (_data == nullptr)
+                throw std::invalid_argument("pushDataFromContainer");
+
+            if (_value.size() > std::numeric_limits<uint32_t>::max())
+                throw std::invalid_argument("Vector<uint8_t> size can't exceed 2^32 symbols. Vector size: " +
+                                            std::to_string(_value.size()));
+
+            uint32_t n = static_cast<uint32_t>(_value.size());
+            pushData(n, _data);
+            _data->insert(_data->end(), _value.begin(), _value.end());
         }
 
         template <>
@@ -438,16 +560,77 @@ namespace dds
             pushDataVector<std::string>(_value, _data);
         }
 
+        /// \brief Length prefix, which escapes the 32-bit length of a large value.
+        /// \details Large values are serialized as regular strings if they are shorter than the escape. Otherwise the
+        /// escape is followed by the 32-bit length. Messages without large values stay byte identical to the old
+        /// format. The format is only understood by peers with g_protocolCommandsVersionLargeValues.
+        constexpr uint16_t g_largeValueEscape = std::numeric_limits<uint16_t>::max();
+
+        /// \brief True if the value requires the large value format.
+        inline bool isLargeValue(const std::string& _value)
+        {
+            return (_value.size() >= g_largeValueEscape);
+        }
+
+        /// \brief Helper function calculating size of a large value
+        inline size_t dsizeLargeValue(const std::string& _value)
+        {
+            return dsize(_value) + (isLargeValue(_value) ? sizeof(uint32_t) : 0);
+        }
+
+        /// \brief Helper function reading a value, which can exceed 2^16 symbols.
+        inline void readLargeValue(std::string* _value, const SByteView* _data, size_t* _nPos)
+        {
+            if (_data == nullptr || _nPos == nullptr || _value == nullptr)
+                throw std::invalid_argument("readDataFromContainer");
+
+            uint16_t n16 = 0;
+            readData(&n16, _data, _nPos);
+
+            // Peers without large value support send the escape as a regular length
+            uint32_t n = n16;
+            if (n16 == g_largeValueEscape && _data->isLargeValueFormat())
+                readData(&n, _data, _nPos);
+
+            checkReadSize(_data, *_nPos, n);
+            _value->append(reinterpret_cast<const char*>(_data->data() + *_nPos), n);
+
+            *_nPos += n;
+        }
+
+        /// \brief Helper function pushing a value, which can exceed 2^16 symbols.
+        inline void pushLargeValue(const std::string& _value, dds::misc::BYTEVector_t* _data)
+        {
+            if (_data == nullptr)
+                throw std::invalid_argument("pushDataFromContainer");
+
+            if (!isLargeValue(_value))
+            {
+                pushData(_value, _data);
+                return;
+            }
+
+            if (_value.size() > std::numeric_limits<uint32_t>::max())
+                throw std::invalid_argument("Value size can't exceed 2^32 symbols. Value size: " +
+                                            std::to_string(_value.size()));
+
+            pushData(g_largeValueEscape, _data);
+            pushData(static_cast<uint32_t>(_value.size()), _data);
+            _data->insert(_data->end(), _value.begin(), _value.end());
+        }
+
         struct SAttachmentDataProvider
         {
             SAttachmentDataProvider(dds::misc::BYTEVector_t* _data)
                 : m_data(_data)
+                , m_view()
                 , m_pos(0)
             {
             }
 
-            SAttachmentDataProvider(const dds::misc::BYTEVector_t& _data)
-                : m_data(const_cast<dds::misc::BYTEVector_t*>(&_data))
+            SAttachmentDataProvider(const SByteView& _data)
+                : m_data(nullptr)
+                , m_view(_data)
                 , m_pos(0)
             {
             }
@@ -455,10 +638,23 @@ namespace dds
             template <typename T>
             SAttachmentDataProvider& get(T& _value)
             {
-                readData(&_value, m_data, &m_pos);
+                readData(&_value, &m_view, &m_pos);
                 return *this;
             }
 
+            /// \brief Reads a value, which can exceed 2^16 symbols.
+            SAttachmentDataProvider& getLargeValue(std::string& _value)
+            {
+                readLargeValue(&_value, &m_view, &m_pos);
+                return *this;
+            }
+
+            /// \brief True if all input data has been read.
+            bool eof() const
+            {
+                return (m_pos >= m_view.size());
+            }
+
             template <typename T>
             const SAttachmentDataProvider& put(const T& _value) const
             {
@@ -466,15 +662,23 @@ namespace dds
                 return *this;
             }
 
+            /// \brief Pushes a value, which can exceed 2^16 symbols.
+            const SAttachmentDataProvider& putLargeValue(const std::string& _value) const
+            {
+                pushLargeValue(_value, m_data);
+                return *this;
+            }
+
           private:
-            dds::misc::BYTEVector_t* m_data;
+            dds::misc::BYTEVector_t* m_data; ///< Output buffer for put
+            SByteView m_view;                ///< Input data for get
             size_t m_pos;
         };
 
         template <class _Owner>
         struct SBasicCmd
         {
-            void convertFromData(const dds::misc::BYTEVector_t& _data)
+            void convertFromData(const SByteView& _data)
             {
                 _Owner* p = reinterpret_cast<_Owner*>(this);
                 if (_data.size() < p->size())
@@ -490,6 +694,12 @@ namespace dds
                 const _Owner* p = reinterpret_cast<const _Owner*>(this);
                 p->_convertToData(_data);
             }
+            /// \brief True if the command has to be serialized in the large value format.
+            /// \details Commands with large value fields hide this function.
+            bool hasLargeValues() const
+            {
+                return false;
+            }
         };
     } // namespace protocol_api
 } // namespace dds
@@ -0,0 +1,88 @@
+// Copyright 2014 GSI, Inc. All rights reserved.
+//
+//
+//
+#include "BatchCmd.h"
+// STD
+#include <algorithm>
+
+using namespace std;
+using namespace dds;
+using namespace dds::protocol_api;
+using namespace dds::misc;
+
+SBatchCmd::SBatchCmd()
+    : m_msgs()
+    , m_dataOwner()
+{
+}
+
+size_t SBatchCmd::msgSize(size_t _bodyLength)
+{
+    return sizeof(uint16_t) + sizeof(uint64_t) + sizeof(uint32_t) + _bodyLength;
+}
+
+size_t SBatchCmd::size() const
+{
+    size_t size(0);
+    for (const auto& msg : m_msgs)
+        size += msgSize(msg.m_body.size());
+    return size;
+}
+
+bool SBatchCmd::operator==(const SBatchCmd& _val) const
+{
+    return std::equal(m_msgs.begin(),
+                      m_msgs.end(),
+                      _val.m_msgs.begin(),
+                      _val.m_msgs.end(),
+                      [](const SMsg& _lhs, const SMsg& _rhs)
+                      {
+                          return (_lhs.m_cmd == _rhs.m_cmd && _lhs.m_ID == _rhs.m_ID &&
+                                  _lhs.m_body.size() == _rhs.m_body.size() &&
+                                  std::equal(_lhs.m_body.begin(), _lhs.m_body.end(), _rhs.m_body.begin()));
+                      });
+}
+
+void SBatchCmd::add(uint16_t _cmd, uint64_t _ID, const SByteView& _body)
+{
+    m_msgs.push_back(SMsg{ _cmd, _ID, _body });
+}
+
+void SBatchCmd::clear()
+{
+    m_msgs.clear();
+    m_dataOwner.reset();
+}
+
+void SBatchCmd::_convertFromData(const SByteView& _data)
+{
+    m_msgs.clear();
+    SAttachmentDataProvider provider(_data);
+    while (!provider.eof())
+    {
+        SMsg msg;
+        provider.get(msg.m_cmd).get(msg.m_ID).get(msg.m_body);
+        m_msgs.push_back(msg);
+    }
+}
+
+void SBatchCmd::_convertToData(BYTEVector_t* _data) const
+{
+    SAttachmentDataProvider provider(_data);
+    for (const auto& msg : m_msgs)
+        provider.put(msg.m_cmd).put(msg.m_ID).put(msg.m_body);
+}
+
+std::ostream& dds::protocol_api::operator<<(std::ostream& _stream, const SBatchCmd& _val)
+{
+    _stream << "nofMsgs=" << _val.m_msgs.size();
+    for (const auto& msg : _val.m_msgs)
+        _stream << " [cmd=" << msg.m_cmd << " ID=" << msg.m_ID << " size=" << msg.m_body.size() << "]";
+    return _stream;
+}
+
+bool dds::protocol_api::operator!=(const SBatchCmd& lhs, const SBatchCmd& rhs)
+{
+    return !(lhs == rhs);
+}
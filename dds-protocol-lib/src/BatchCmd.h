@@ -0,0 +1,53 @@
+// Copyright 2014 GSI, Inc. All rights reserved.
+//
+//
+//
+#ifndef __DDS__BatchCmd__
+#define __DDS__BatchCmd__
+
+// DDS
+#include "BasicCmd.h"
+// STD
+#include <memory>
+#include <vector>
+
+namespace dds
+{
+    namespace protocol_api
+    {
+        ///
+        /// \brief Attachment of cmdBATCH, which packs several small messages into one frame.
+        /// \details Each packed message is stored as its command, ID and body. Decoded bodies reference the decoded
+        /// buffer, which is kept alive by m_dataOwner.
+        ///
+        struct SBatchCmd : public SBasicCmd<SBatchCmd>
+        {
+            struct SMsg
+            {
+                uint16_t m_cmd;
+                uint64_t m_ID;
+                SByteView m_body;
+            };
+
+            SBatchCmd();
+            size_t size() const;
+            void _convertFromData(const SByteView& _data);
+            void _convertToData(dds::misc::BYTEVector_t* _data) const;
+            bool operator==(const SBatchCmd& _val) const;
+            /// \brief Adds a message. The body is not copied and must stay valid, until the batch is encoded.
+            void add(uint16_t _cmd, uint64_t _ID, const SByteView& _body);
+            void clear();
+
+            /// \brief Size, which a message with the given body adds to the batch.
+            static size_t msgSize(size_t _bodyLength);
+
+            std::vector<SMsg> m_msgs;
+            /// The owner (usually the protocol message) keeps the decoded buffer alive.
+            std::shared_ptr<const void> m_dataOwner;
+        };
+        std::ostream& operator<<(std::ostream& _stream, const SBatchCmd& _val);
+        bool operator!=(const SBatchCmd& lhs, const SBatchCmd& rhs);
+    } // namespace protocol_api
+};    // namespace dds
+
+#endif /* defined(__DDS__BatchCmd__) */
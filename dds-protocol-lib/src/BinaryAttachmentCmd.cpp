@@ -3,6 +3,8 @@
 //
 //
 #include "BinaryAttachmentCmd.h"
+// STD
+#include <algorithm>
 
 using namespace std;
 using namespace dds;
@@ -15,40 +17,56 @@ SBinaryAttachmentCmd::SBinaryAttachmentCmd()
     , m_size(0)
     , m_crc32(0)
     , m_data()
+    , m_dataOwner()
+    , m_dataView()
 {
 }
 
 size_t SBinaryAttachmentCmd::size() const
 {
-    return dsize(m_fileId) + dsize(m_data) + dsize(m_offset) + dsize(m_size) + dsize(m_crc32);
+    return dsize(m_fileId) + dsize(payload()) + dsize(m_offset) + dsize(m_size) + dsize(m_crc32);
 }
 
 bool SBinaryAttachmentCmd::operator==(const SBinaryAttachmentCmd& _val) const
 {
-    unsigned int i = 0;
-    for (auto c : _val.m_data)
-    {
-        if (m_data[i++] != c)
-            return false;
-    }
-    return (m_fileId == _val.m_fileId && m_offset == _val.m_offset && m_size == _val.m_size && m_crc32 == _val.m_crc32);
+    SByteView lhs(payload());
+    SByteView rhs(_val.payload());
+    return (m_fileId == _val.m_fileId && m_offset == _val.m_offset && m_size == _val.m_size &&
+            m_crc32 == _val.m_crc32 && lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin()));
+}
+
+SByteView SBinaryAttachmentCmd::payload() const
+{
+    return (m_dataOwner ? m_dataView : SByteView(m_data));
+}
+
+void SBinaryAttachmentCmd::setPayload(const SByteView& _data, std::shared_ptr<const void> _owner)
+{
+    m_data.clear();
+    m_dataOwner = move(_owner);
+    m_dataView = _data;
 }
 
-void SBinaryAttachmentCmd::_convertFromData(const BYTEVector_t& _data)
+void SBinaryAttachmentCmd::_convertFromData(const SByteView& _data)
 {
-    SAttachmentDataProvider(_data).get(m_fileId).get(m_offset).get(m_size).get(m_crc32).get(m_data);
+    SAttachmentDataProvider provider(_data);
+    provider.get(m_fileId).get(m_offset).get(m_size).get(m_crc32);
+    if (m_dataOwner)
+        provider.get(m_dataView);
+    else
+        provider.get(m_data);
 }
 
 void SBinaryAttachmentCmd::_convertToData(BYTEVector_t* _data) const
 {
-    SAttachmentDataProvider(_data).put(m_fileId).put(m_offset).put(m_size).put(m_crc32).put(m_data);
+    SAttachmentDataProvider(_data).put(m_fileId).put(m_offset).put(m_size).put(m_crc32).put(payload());
 }
 
 std::ostream& dds::protocol_api::operator<<(std::ostream& _stream, const SBinaryAttachmentCmd& _val)
 {
     _stream << "fileId=" << _val.m_fileId << " offset=" << _val.m_offset << " size=" << _val.m_size
             << " crc32=" << _val.m_crc32;
-    for (const auto& c : _val.m_data)
+    for (const auto& c : _val.payload())
     {
         _stream << c;
     }
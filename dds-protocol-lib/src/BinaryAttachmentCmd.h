@@ -10,6 +10,8 @@
 // BOOST
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_io.hpp>
+// STD
+#include <memory>
 
 namespace dds
 {
@@ -19,15 +21,25 @@ namespace dds
         {
             SBinaryAttachmentCmd();
             size_t size() const;
-            void _convertFromData(const dds::misc::BYTEVector_t& _data);
+            void _convertFromData(const SByteView& _data);
             void _convertToData(dds::misc::BYTEVector_t* _data) const;
             bool operator==(const SBinaryAttachmentCmd& _val) const;
+            /// \brief Piece of binary data, either m_data or the referenced part of the owner's buffer.
+            SByteView payload() const;
+            /// \brief References the piece of binary data in the buffer of the given owner instead of copying it.
+            void setPayload(const SByteView& _data, std::shared_ptr<const void> _owner);
 
             boost::uuids::uuid m_fileId;    ///< Unique ID of the file
             uint32_t m_offset;              ///< Offset for this piece of binary data
-            uint32_t m_size;                ///< Size of this piece of binary data
+            uint32_t m_size;                ///< Size of this piece of binary data, an empty piece aborts the transfer
             uint32_t m_crc32;               ///< CRC checksum of this piece of binary data
             dds::misc::BYTEVector_t m_data; ///< Piece of binary data
+            /// If set before decoding, the piece of binary data is not copied into m_data, but references the decoded
+            /// buffer. The owner (usually the protocol message) keeps the buffer alive.
+            std::shared_ptr<const void> m_dataOwner;
+
+          private:
+            SByteView m_dataView; ///< Piece of binary data referencing the owner's buffer
         };
         std::ostream& operator<<(std::ostream& _stream, const SBinaryAttachmentCmd& _val);
         bool operator!=(const SBinaryAttachmentCmd& lhs, const SBinaryAttachmentCmd& rhs);
@@ -30,7 +30,7 @@ bool SBinaryAttachmentReceivedCmd::operator==(const SBinaryAttachmentReceivedCmd
             m_downloadTime == _val.m_downloadTime);
 }
 
-void SBinaryAttachmentReceivedCmd::_convertFromData(const BYTEVector_t& _data)
+void SBinaryAttachmentReceivedCmd::_convertFromData(const SByteView& _data)
 {
     SAttachmentDataProvider(_data)
         .get(m_srcCommand)
@@ -28,7 +28,7 @@ bool SBinaryAttachmentStartCmd::operator==(const SBinaryAttachmentStartCmd& _val
             m_fileSize == _val.m_fileSize && m_srcCommand == _val.m_srcCommand);
 }
 
-void SBinaryAttachmentStartCmd::_convertFromData(const BYTEVector_t& _data)
+void SBinaryAttachmentStartCmd::_convertFromData(const SByteView& _data)
 {
     SAttachmentDataProvider(_data).get(m_fileId).get(m_fileName).get(m_fileSize).get(m_fileCrc32).get(m_srcCommand);
 }
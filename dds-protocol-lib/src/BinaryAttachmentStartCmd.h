@@ -19,7 +19,7 @@ namespace dds
         {
             SBinaryAttachmentStartCmd();
             size_t size() const;
-            void _convertFromData(const dds::misc::BYTEVector_t& _data);
+            void _convertFromData(const SByteView& _data);
             void _convertToData(dds::misc::BYTEVector_t* _data) const;
             bool operator==(const SBinaryAttachmentStartCmd& _val) const;
 
@@ -0,0 +1,48 @@
+// Copyright 2014 GSI, Inc. All rights reserved.
+//
+//
+//
+#include "CachedFilesCmd.h"
+
+using namespace std;
+using namespace dds;
+using namespace dds::protocol_api;
+using namespace dds::misc;
+
+SCachedFilesCmd::SCachedFilesCmd()
+    : m_hashes()
+{
+}
+
+size_t SCachedFilesCmd::size() const
+{
+    return dsize(m_hashes);
+}
+
+bool SCachedFilesCmd::operator==(const SCachedFilesCmd& _val) const
+{
+    return (m_hashes == _val.m_hashes);
+}
+
+void SCachedFilesCmd::_convertFromData(const SByteView& _data)
+{
+    SAttachmentDataProvider(_data).get(m_hashes);
+}
+
+void SCachedFilesCmd::_convertToData(BYTEVector_t* _data) const
+{
+    SAttachmentDataProvider(_data).put(m_hashes);
+}
+
+std::ostream& dds::protocol_api::operator<<(std::ostream& _stream, const SCachedFilesCmd& _val)
+{
+    _stream << "nofHashes=" << _val.m_hashes.size();
+    for (const auto& hash : _val.m_hashes)
+        _stream << " " << hash;
+    return _stream;
+}
+
+bool dds::protocol_api::operator!=(const SCachedFilesCmd& lhs, const SCachedFilesCmd& rhs)
+{
+    return !(lhs == rhs);
+}
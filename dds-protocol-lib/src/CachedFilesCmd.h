@@ -0,0 +1,38 @@
+// Copyright 2014 GSI, Inc. All rights reserved.
+//
+//
+//
+#ifndef __DDS__CachedFilesCmd__
+#define __DDS__CachedFilesCmd__
+
+// DDS
+#include "BasicCmd.h"
+// STD
+#include <string>
+#include <vector>
+
+namespace dds
+{
+    namespace protocol_api
+    {
+        ///
+        /// \brief Attachment of cmdCHECK_CACHED_FILES and cmdREPLY_CHECK_CACHED_FILES.
+        /// \details The commander sends the content hashes of the files it needs on an agent, the agent replies with
+        /// the hashes missing in its file cache.
+        ///
+        struct SCachedFilesCmd : public SBasicCmd<SCachedFilesCmd>
+        {
+            SCachedFilesCmd();
+            size_t size() const;
+            void _convertFromData(const SByteView& _data);
+            void _convertToData(dds::misc::BYTEVector_t* _data) const;
+            bool operator==(const SCachedFilesCmd& _val) const;
+
+            std::vector<std::string> m_hashes; ///< See SSharedBinaryAttachment::contentHash
+        };
+        std::ostream& operator<<(std::ostream& _stream, const SCachedFilesCmd& _val);
+        bool operator!=(const SCachedFilesCmd& lhs, const SCachedFilesCmd& rhs);
+    } // namespace protocol_api
+};    // namespace dds
+
+#endif /* defined(__DDS__CachedFilesCmd__) */
@@ -20,7 +20,10 @@ namespace dds
             OnRemoteEndDissconnected,
             OnHandshakeOK,
             OnHandshakeFailed,
-            OnReplyAddSlot
+            OnReplyAddSlot,
+            /// Indexed keys of the channel have changed, see SChannelKeys. m_ID of the sender is the protocol header ID
+            /// of the changed slot or 0 for the whole channel.
+            OnChannelKeysChanged
         };
 
         class CChannelEventHandlersImpl : private CBaseEventHandlersImpl<EChannelEvents>
@@ -34,6 +37,7 @@ namespace dds
             DDS_REGISTER_EVENT_HANDLER(EChannelEvents, EChannelEvents::OnHandshakeOK, void(const SSenderInfo&))
             DDS_REGISTER_EVENT_HANDLER(EChannelEvents, EChannelEvents::OnHandshakeFailed, void(const SSenderInfo&))
             DDS_REGISTER_EVENT_HANDLER(EChannelEvents, EChannelEvents::OnReplyAddSlot, void(const SSenderInfo&))
+            DDS_REGISTER_EVENT_HANDLER(EChannelEvents, EChannelEvents::OnChannelKeysChanged, void(const SSenderInfo&))
             DDS_END_EVENT_HANDLERS
         };
     } // namespace protocol_api
@@ -5,6 +5,9 @@
 
 #ifndef __DDS__ChannelInfo_h
 #define __DDS__ChannelInfo_h
+// STD
+#include <cstdint>
+#include <vector>
 
 namespace dds
 {
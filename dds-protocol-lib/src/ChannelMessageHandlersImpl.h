@@ -45,6 +45,9 @@ namespace dds
             DDS_REGISTER_MESSAGE_HANDLER(cmdSTOP_USER_TASK)
             DDS_REGISTER_MESSAGE_HANDLER(cmdLOBBY_MEMBER_HANDSHAKE)
             DDS_REGISTER_MESSAGE_HANDLER(cmdREPLY)
+            DDS_REGISTER_MESSAGE_HANDLER(cmdREPLY_ASSIGN_USER_TASKS)
+            DDS_REGISTER_MESSAGE_HANDLER(cmdREPLY_CHECK_CACHED_FILES)
+            DDS_REGISTER_MESSAGE_HANDLER(cmdSUBSCRIBE_ON_TASK_DONE)
             DDS_END_EVENT_HANDLERS
         };
     } // namespace protocol_api
@@ -0,0 +1,523 @@
+// Copyright 2014 GSI, Inc. All rights reserved.
+//
+//
+//
+
+#ifndef __DDS__ChannelRegistry_h
+#define __DDS__ChannelRegistry_h
+// DDS
+#include "ChannelInfo.h"
+#include "ProtocolDef.h"
+#include "ShardedMap.h"
+// STD
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace dds
+{
+    namespace protocol_api
+    {
+        /// \brief Properties of a registered channel, which are indexed by CChannelRegistry.
+        /// \details The channel type provides them by getChannelKeys(protocolHeaderID, isSlot). It reports changes by
+        /// the OnChannelKeysChanged event.
+        struct SChannelKeys
+        {
+            uint64_t m_agentID{ 0 };              ///< ID of the agent, 0 if unknown
+            uint64_t m_taskID{ 0 };               ///< Task executed by a slot, 0 if none
+            uint32_t m_state{ 0 };                ///< State of the channel defined by its type, e.g. of a task slot
+            std::string m_host;                   ///< Host of the remote end, empty if unknown
+            bool m_isTaskDoneSubscriber{ false }; ///< The remote end receives cmdUSER_TASK_DONE events
+
+            bool operator==(const SChannelKeys& _other) const
+            {
+                return (m_agentID == _other.m_agentID && m_taskID == _other.m_taskID && m_state == _other.m_state &&
+                        m_host == _other.m_host && m_isTaskDoneSubscriber == _other.m_isTaskDoneSubscriber);
+            }
+        };
+
+        /// \class CChannelRegistry
+        /// \brief Channels of a connection manager with secondary indexes.
+        /// \details Writers (accept, new slots, state changes, disconnects) are serialized by a mutex and update the
+        /// indexes incrementally. Each index keeps channels with the same key in a bucket. A bucket publishes an
+        /// immutable list of its channels RCU-style by an atomic shared_ptr. Readers never take the writer mutex. They
+        /// load the published list and share it until the next change of the bucket. After a change the first reader
+        /// rebuilds the list, holding only the lock of that bucket. A change of one channel only invalidates the
+        /// lists of buckets it leaves or joins, thus a burst of changes costs one rebuild of each affected list.
+        /// Keys are taken from the channels before the writer mutex is locked.
+        template <class T>
+        class CChannelRegistry
+        {
+          public:
+            typedef SChannelInfo<T> channelInfo_t;
+            /// An immutable list of channels. Writers replace it, readers keep it as long as they need it.
+            typedef std::shared_ptr<const typename channelInfo_t::container_t> containerPtr_t;
+
+          private:
+            typedef std::pair<EChannelType, bool> kind_t;
+            typedef std::tuple<EChannelType, bool, uint32_t> state_t;
+
+            struct SEntry
+            {
+                channelInfo_t m_info;
+                kind_t m_kind;
+                SChannelKeys m_keys;
+                uint64_t m_keysVersion{ 0 }; ///< Keys taken later have a higher version
+            };
+
+            struct SLookup
+            {
+                uint64_t m_seq{ 0 };
+                channelInfo_t m_info;
+            };
+
+            /// Channels with the same key in order of registration
+            class CBucket
+            {
+              public:
+                void insert(uint64_t _seq, const channelInfo_t& _info)
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_entries.emplace(_seq, _info);
+                    m_size = m_entries.size();
+                    std::atomic_store(&m_list, containerPtr_t());
+                }
+
+                /// \return false if the bucket is empty.
+                bool erase(uint64_t _seq)
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (m_entries.erase(_seq) != 0)
+                    {
+                        m_size = m_entries.size();
+                        std::atomic_store(&m_list, containerPtr_t());
+                    }
+                    return !m_entries.empty();
+                }
+
+                containerPtr_t list()
+                {
+                    containerPtr_t list{ std::atomic_load(&m_list) };
+                    if (list != nullptr)
+                        return list;
+
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    // Another reader might have rebuilt it already
+                    list = std::atomic_load(&m_list);
+                    if (list == nullptr)
+                    {
+                        auto newList = std::make_shared<typename channelInfo_t::container_t>();
+                        newList->reserve(m_entries.size());
+                        for (const auto& v : m_entries)
+                            newList->push_back(v.second);
+                        list = std::move(newList);
+                        std::atomic_store(&m_list, list);
+                    }
+                    return list;
+                }
+
+                size_t size() const
+                {
+                    return m_size;
+                }
+
+                void clear()
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_entries.clear();
+                    m_size = 0;
+                    std::atomic_store(&m_list, containerPtr_t());
+                }
+
+              private:
+                std::mutex m_mutex;                          ///< Guards the entries of this bucket only
+                std::map<uint64_t, channelInfo_t> m_entries; ///< By sequence number of the registration
+                std::atomic<size_t> m_size{ 0 };
+                containerPtr_t m_list; ///< Accessed atomically. Built on demand, reset on change.
+            };
+
+            template <class K>
+            class CIndex
+            {
+              public:
+                void insert(const K& _key, uint64_t _seq, const channelInfo_t& _info)
+                {
+                    bucket(_key)->insert(_seq, _info);
+                }
+
+                void erase(const K& _key, uint64_t _seq)
+                {
+                    std::shared_ptr<CBucket> b{ find(_key) };
+                    if (b == nullptr || b->erase(_seq))
+                        return;
+                    // Writers are serialized, nobody refills the bucket meanwhile
+                    std::unique_lock<std::shared_mutex> lock(m_mutex);
+                    m_buckets.erase(_key);
+                }
+
+                containerPtr_t list(const K& _key) const
+                {
+                    std::shared_ptr<CBucket> b{ find(_key) };
+                    return (b != nullptr) ? b->list() : emptyList();
+                }
+
+                size_t size(const K& _key) const
+                {
+                    std::shared_ptr<CBucket> b{ find(_key) };
+                    return (b != nullptr) ? b->size() : 0;
+                }
+
+                void clear()
+                {
+                    std::unique_lock<std::shared_mutex> lock(m_mutex);
+                    m_buckets.clear();
+                }
+
+              private:
+                std::shared_ptr<CBucket> find(const K& _key) const
+                {
+                    std::shared_lock<std::shared_mutex> lock(m_mutex);
+                    auto it = m_buckets.find(_key);
+                    return (it != m_buckets.end()) ? it->second : nullptr;
+                }
+
+                std::shared_ptr<CBucket> bucket(const K& _key)
+                {
+                    std::shared_ptr<CBucket> b{ find(_key) };
+                    if (b != nullptr)
+                        return b;
+                    std::unique_lock<std::shared_mutex> lock(m_mutex);
+                    std::shared_ptr<CBucket>& newBucket = m_buckets[_key];
+                    if (newBucket == nullptr)
+                        newBucket = std::make_shared<CBucket>();
+                    return newBucket;
+                }
+
+              private:
+                mutable std::shared_mutex m_mutex; ///< Guards the map of buckets, not their content
+                std::map<K, std::shared_ptr<CBucket>> m_buckets;
+            };
+
+          public:
+            void add(const channelInfo_t& _channelInfo)
+            {
+                SEntry entry;
+                entry.m_info = _channelInfo;
+                updateKeys(entry);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                const uint64_t seq{ ++m_lastSeq };
+                insert(seq, entry);
+                m_entries.emplace(seq, std::move(entry));
+                m_byChannel[_channelInfo.m_channel.get()].push_back(seq);
+                m_size = m_entries.size();
+            }
+
+            void remove(const T* _channel)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto it = m_byChannel.find(_channel);
+                if (it == m_byChannel.end())
+                    return;
+                for (uint64_t seq : it->second)
+                {
+                    auto entryIt = m_entries.find(seq);
+                    erase(seq, entryIt->second);
+                    m_entries.erase(entryIt);
+                }
+                m_byChannel.erase(it);
+                m_size = m_entries.size();
+            }
+
+            /// \brief Sets the protocol header ID of the channel registered without one.
+            /// \return false if the channel is not registered.
+            bool updateProtocolHeaderID(const T* _channel, uint64_t _protocolHeaderID)
+            {
+                uint64_t seq{ 0 };
+                SEntry updated;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    auto it = m_byChannel.find(_channel);
+                    if (it == m_byChannel.end())
+                        return false;
+                    for (uint64_t v : it->second)
+                    {
+                        const SEntry& entry = m_entries[v];
+                        if (entry.m_info.m_protocolHeaderID == 0)
+                        {
+                            seq = v;
+                            updated.m_info = entry.m_info;
+                            break;
+                        }
+                    }
+                }
+                if (seq == 0)
+                    return false;
+
+                updated.m_info.m_protocolHeaderID = _protocolHeaderID;
+                updateKeys(updated);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                // The channel might have been removed or updated meanwhile
+                auto it = m_entries.find(seq);
+                if (it == m_entries.end() || it->second.m_info.m_protocolHeaderID != 0)
+                    return false;
+                erase(seq, it->second);
+                it->second = std::move(updated);
+                insert(seq, it->second);
+                return true;
+            }
+
+            /// \brief Re-indexes the channel after its type or keys have changed.
+            /// \param _protocolHeaderID The entry to re-index, 0 for all entries of the channel.
+            void update(const T* _channel, uint64_t _protocolHeaderID = 0)
+            {
+                std::vector<std::pair<uint64_t, SEntry>> updated;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    auto it = m_byChannel.find(_channel);
+                    if (it == m_byChannel.end())
+                        return;
+                    for (uint64_t seq : it->second)
+                    {
+                        const SEntry& entry = m_entries[seq];
+                        if (_protocolHeaderID == 0 || entry.m_info.m_protocolHeaderID == _protocolHeaderID)
+                            updated.emplace_back(seq, SEntry{ entry.m_info, entry.m_kind, entry.m_keys });
+                    }
+                }
+
+                for (auto& v : updated)
+                    updateKeys(v.second);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (auto& v : updated)
+                {
+                    // Keys taken by a concurrent update after ours win
+                    auto it = m_entries.find(v.first);
+                    if (it == m_entries.end() || it->second.m_keysVersion > v.second.m_keysVersion ||
+                        it->second.m_info.m_protocolHeaderID != v.second.m_info.m_protocolHeaderID)
+                        continue;
+                    SEntry& entry = it->second;
+                    if (v.second.m_kind != entry.m_kind || !(v.second.m_keys == entry.m_keys))
+                        reindex(v.first, entry, v.second);
+                    entry.m_kind = v.second.m_kind;
+                    entry.m_keys = std::move(v.second.m_keys);
+                    entry.m_keysVersion = v.second.m_keysVersion;
+                }
+            }
+
+            void clear()
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_entries.clear();
+                m_byChannel.clear();
+                m_byID.clear();
+                m_byTaskID.clear();
+                m_all.clear();
+                m_byKind.clear();
+                m_byState.clear();
+                m_byAgentID.clear();
+                m_byHost.clear();
+                m_taskDoneSubscribers.clear();
+                m_size = 0;
+            }
+
+            size_t size() const
+            {
+                return m_size;
+            }
+
+            /// \brief All channels.
+            containerPtr_t channels()
+            {
+                return m_all.list();
+            }
+
+            /// \brief Channels of the given type, either slots or not.
+            containerPtr_t channels(EChannelType _type, bool _isSlot)
+            {
+                return m_byKind.list(kind_t(_type, _isSlot));
+            }
+
+            /// \brief Channels of the given type and state, either slots or not.
+            containerPtr_t channels(EChannelType _type, bool _isSlot, uint32_t _state)
+            {
+                return m_byState.list(state_t(_type, _isSlot, _state));
+            }
+
+            /// \brief Number of channels of the given type and state, either slots or not.
+            size_t count(EChannelType _type, bool _isSlot, uint32_t _state) const
+            {
+                return m_byState.size(state_t(_type, _isSlot, _state));
+            }
+
+            /// \brief The channel of the agent and its slots.
+            containerPtr_t channelsOfAgent(uint64_t _agentID)
+            {
+                return m_byAgentID.list(_agentID);
+            }
+
+            /// \brief Channels of remote ends on the given host.
+            containerPtr_t channelsOnHost(const std::string& _host)
+            {
+                return m_byHost.list(_host);
+            }
+
+            /// \brief Channels, which receive cmdUSER_TASK_DONE events.
+            containerPtr_t taskDoneSubscribers()
+            {
+                return m_taskDoneSubscribers.list();
+            }
+
+            /// \brief Finds the channel with the given protocol header ID.
+            /// \return false if there is no such channel.
+            bool find(uint64_t _protocolHeaderID, channelInfo_t& _result) const
+            {
+                return find(m_byID, _protocolHeaderID, _result);
+            }
+
+            /// \brief Finds the slot, which executes the given task.
+            /// \return false if there is no such slot.
+            bool findByTaskID(uint64_t _taskID, channelInfo_t& _result) const
+            {
+                return find(m_byTaskID, _taskID, _result);
+            }
+
+          private:
+            typedef dds::misc::CShardedMap<uint64_t, SLookup> lookup_t;
+
+            static containerPtr_t emptyList()
+            {
+                static const containerPtr_t empty{ std::make_shared<typename channelInfo_t::container_t>() };
+                return empty;
+            }
+
+            /// Called without the writer mutex, the channel might lock its own data
+            void updateKeys(SEntry& _entry)
+            {
+                const channelInfo_t& info = _entry.m_info;
+                _entry.m_keysVersion = ++m_lastKeysVersion;
+                _entry.m_kind = kind_t(info.m_channel->getChannelType(), info.m_isSlot);
+                _entry.m_keys = info.m_channel->getChannelKeys(info.m_protocolHeaderID, info.m_isSlot);
+            }
+
+            static bool find(const lookup_t& _index, uint64_t _key, channelInfo_t& _result)
+            {
+                SLookup v;
+                if (!_index.find(_key, v))
+                    return false;
+                _result = v.m_info;
+                return true;
+            }
+
+            void insert(uint64_t _seq, const SEntry& _entry)
+            {
+                const channelInfo_t& info = _entry.m_info;
+                const SChannelKeys& keys = _entry.m_keys;
+                m_all.insert(_seq, info);
+                m_byKind.insert(_entry.m_kind, _seq, info);
+                m_byState.insert(state_t(_entry.m_kind.first, _entry.m_kind.second, keys.m_state), _seq, info);
+                if (info.m_protocolHeaderID != 0)
+                    m_byID.insert_or_assign(info.m_protocolHeaderID, SLookup{ _seq, info });
+                if (keys.m_taskID != 0)
+                    m_byTaskID.insert_or_assign(keys.m_taskID, SLookup{ _seq, info });
+                if (keys.m_agentID != 0)
+                    m_byAgentID.insert(keys.m_agentID, _seq, info);
+                if (!keys.m_host.empty())
+                    m_byHost.insert(keys.m_host, _seq, info);
+                if (keys.m_isTaskDoneSubscriber)
+                    m_taskDoneSubscribers.insert(_seq, info);
+            }
+
+            void erase(uint64_t _seq, const SEntry& _entry)
+            {
+                const channelInfo_t& info = _entry.m_info;
+                const SChannelKeys& keys = _entry.m_keys;
+                m_all.erase(_seq);
+                m_byKind.erase(_entry.m_kind, _seq);
+                m_byState.erase(state_t(_entry.m_kind.first, _entry.m_kind.second, keys.m_state), _seq);
+                eraseIfEqual(m_byID, info.m_protocolHeaderID, _seq);
+                eraseIfEqual(m_byTaskID, keys.m_taskID, _seq);
+                m_byAgentID.erase(keys.m_agentID, _seq);
+                m_byHost.erase(keys.m_host, _seq);
+                m_taskDoneSubscribers.erase(_seq);
+            }
+
+            /// Moves the entry only between buckets, which keys have changed. Lists of other buckets stay valid.
+            void reindex(uint64_t _seq, const SEntry& _old, const SEntry& _new)
+            {
+                const channelInfo_t& info = _new.m_info;
+                const SChannelKeys& oldKeys = _old.m_keys;
+                const SChannelKeys& newKeys = _new.m_keys;
+                if (_old.m_kind != _new.m_kind)
+                {
+                    m_byKind.erase(_old.m_kind, _seq);
+                    m_byKind.insert(_new.m_kind, _seq, info);
+                }
+                const state_t oldState(_old.m_kind.first, _old.m_kind.second, oldKeys.m_state);
+                const state_t newState(_new.m_kind.first, _new.m_kind.second, newKeys.m_state);
+                if (oldState != newState)
+                {
+                    m_byState.erase(oldState, _seq);
+                    m_byState.insert(newState, _seq, info);
+                }
+                if (oldKeys.m_taskID != newKeys.m_taskID)
+                {
+                    eraseIfEqual(m_byTaskID, oldKeys.m_taskID, _seq);
+                    if (newKeys.m_taskID != 0)
+                        m_byTaskID.insert_or_assign(newKeys.m_taskID, SLookup{ _seq, info });
+                }
+                if (oldKeys.m_agentID != newKeys.m_agentID)
+                {
+                    m_byAgentID.erase(oldKeys.m_agentID, _seq);
+                    if (newKeys.m_agentID != 0)
+                        m_byAgentID.insert(newKeys.m_agentID, _seq, info);
+                }
+                if (oldKeys.m_host != newKeys.m_host)
+                {
+                    m_byHost.erase(oldKeys.m_host, _seq);
+                    if (!newKeys.m_host.empty())
+                        m_byHost.insert(newKeys.m_host, _seq, info);
+                }
+                if (oldKeys.m_isTaskDoneSubscriber != newKeys.m_isTaskDoneSubscriber)
+                {
+                    if (newKeys.m_isTaskDoneSubscriber)
+                        m_taskDoneSubscribers.insert(_seq, info);
+                    else
+                        m_taskDoneSubscribers.erase(_seq);
+                }
+            }
+
+            /// Another entry might have taken over the key
+            static void eraseIfEqual(lookup_t& _index, uint64_t _key, uint64_t _seq)
+            {
+                SLookup v;
+                if (_index.find(_key, v) && v.m_seq == _seq)
+                    _index.erase(_key);
+            }
+
+          private:
+            std::mutex m_mutex; ///< Serializes writers
+            uint64_t m_lastSeq{ 0 };
+            std::atomic<uint64_t> m_lastKeysVersion{ 0 };
+            std::map<uint64_t, SEntry> m_entries;                            ///< By sequence number of the registration
+            std::unordered_map<const T*, std::vector<uint64_t>> m_byChannel; ///< Entries of a channel and its slots
+            std::atomic<size_t> m_size{ 0 };
+            lookup_t m_byID;     ///< Protocol header ID to entry
+            lookup_t m_byTaskID; ///< Task ID to the slot entry
+            CBucket m_all;
+            CIndex<kind_t> m_byKind;
+            CIndex<state_t> m_byState;
+            CIndex<uint64_t> m_byAgentID;
+            CIndex<std::string> m_byHost;
+            CBucket m_taskDoneSubscribers;
+        };
+    } // namespace protocol_api
+} // namespace dds
+#endif /* __DDS__ChannelRegistry_h */
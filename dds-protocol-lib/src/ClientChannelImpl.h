@@ -11,6 +11,7 @@
 #include "Version.h"
 // STD
 #include <functional>
+#include <vector>
 
 namespace dds
 {
@@ -62,19 +63,33 @@ namespace dds
             {
             }
 
+          public:
+            typedef std::vector<boost::asio::generic::stream_protocol::endpoint> endpoints_t;
+
           public:
             void reconnect()
             {
-                connect(m_endpoint_iterator);
+                connect(m_endpoints);
             }
 
             void connect(boost::asio::ip::tcp::resolver::iterator _endpoint_iterator)
             {
-                m_endpoint_iterator = _endpoint_iterator;
+                endpoints_t endpoints;
+                for (; _endpoint_iterator != boost::asio::ip::tcp::resolver::iterator(); ++_endpoint_iterator)
+                    endpoints.push_back(_endpoint_iterator->endpoint());
+                connect(endpoints);
+            }
+
+            /// \brief Connects to the first reachable endpoint.
+            /// \details Endpoints can be of different protocols, e.g. a Unix domain socket followed by TCP endpoints
+            /// as a fallback.
+            void connect(const endpoints_t& _endpoints)
+            {
+                m_endpoints = _endpoints;
                 boost::asio::async_connect(
                     this->socket(),
-                    _endpoint_iterator,
-                    [this](boost::system::error_code ec, boost::asio::ip::tcp::resolver::iterator)
+                    m_endpoints,
+                    [this](boost::system::error_code ec, const boost::asio::generic::stream_protocol::endpoint&)
                     {
                         if (!ec)
                         {
@@ -102,7 +117,7 @@ namespace dds
             }
 
           private:
-            boost::asio::ip::tcp::resolver::iterator m_endpoint_iterator;
+            endpoints_t m_endpoints;
         };
     } // namespace protocol_api
 } // namespace dds
@@ -0,0 +1,80 @@
+// Copyright 2014 GSI, Inc. All rights reserved.
+//
+//
+//
+#include "CoalescingWindow.h"
+// STD
+#include <algorithm>
+
+using namespace std;
+using namespace dds;
+using namespace dds::protocol_api;
+
+// Weight of the last interval in the moving average is 1/averageIntervalWeight
+static const int averageIntervalWeight = 8;
+
+void CCoalescingWindow::setPolicy(uint16_t _cmd, const SCoalescingPolicy& _policy)
+{
+    m_policies[_cmd] = _policy;
+}
+
+void CCoalescingWindow::setDefaultPolicy(const SCoalescingPolicy& _policy)
+{
+    m_defaultPolicy = _policy;
+}
+
+const SCoalescingPolicy& CCoalescingWindow::getPolicy(uint16_t _cmd) const
+{
+    auto iter = m_policies.find(_cmd);
+    return (iter != m_policies.end()) ? iter->second : m_defaultPolicy;
+}
+
+bool CCoalescingWindow::add(uint16_t _cmd, size_t _msgSize, bool _isLinkIdle, clock_t::time_point _now)
+{
+    const SCoalescingPolicy& policy = getPolicy(_cmd);
+
+    // Estimate the arrival rate
+    if (m_hasLastArrival)
+    {
+        const clock_t::duration interval = max(clock_t::duration::zero(), _now - m_lastArrival);
+        if (m_averageInterval == clock_t::duration::max())
+            m_averageInterval = interval;
+        else
+            m_averageInterval += (interval - m_averageInterval) / averageIntervalWeight;
+    }
+    m_hasLastArrival = true;
+    m_lastArrival = _now;
+
+    const clock_t::time_point deadline = _now + policy.m_maxLatency;
+    m_deadline = (m_nofMsgs == 0) ? deadline : min(m_deadline, deadline);
+    ++m_nofMsgs;
+    m_nofBytes += _msgSize;
+
+    // The batch is full or can't be held back any longer
+    if (m_nofMsgs >= policy.m_maxBatchMsgs || m_nofBytes >= policy.m_maxBatchBytes || _now >= m_deadline)
+        return true;
+
+    // Low load: the next message is not expected within the latency budget
+    return (_isLinkIdle && m_averageInterval >= policy.m_maxLatency);
+}
+
+void CCoalescingWindow::reset()
+{
+    m_nofMsgs = 0;
+    m_nofBytes = 0;
+}
+
+bool CCoalescingWindow::empty() const
+{
+    return (m_nofMsgs == 0);
+}
+
+CCoalescingWindow::clock_t::time_point CCoalescingWindow::deadline() const
+{
+    return m_deadline;
+}
+
+CCoalescingWindow::clock_t::duration CCoalescingWindow::averageInterval() const
+{
+    return m_averageInterval;
+}
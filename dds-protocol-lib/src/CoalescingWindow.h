@@ -0,0 +1,71 @@
+// Copyright 2014 GSI, Inc. All rights reserved.
+//
+//
+//
+#ifndef __DDS__CoalescingWindow__
+#define __DDS__CoalescingWindow__
+// STD
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+namespace dds
+{
+    namespace protocol_api
+    {
+        /// \brief Coalescing policy of a command type sent via accumulativePushMsg.
+        struct SCoalescingPolicy
+        {
+            std::chrono::microseconds m_maxLatency{ 10000 }; ///< Max time a message can be held back, 0 - no delay
+            size_t m_maxBatchBytes{ 64 * 1024 };             ///< A batch is sent once it reaches this size
+            size_t m_maxBatchMsgs{ 10000 };                  ///< A batch is sent once it has this number of messages
+        };
+
+        ///
+        /// \brief Decides when accumulated messages are sent, similar to Nagle's algorithm with a deadline.
+        /// \details A batch is sent once it is full or its deadline, which is set by the first message of the batch, has
+        /// expired. If the link is idle and messages arrive at a lower rate than the latency budget, there is nothing
+        /// to wait for and the batch is sent immediately. The arrival rate is estimated by a moving average of the
+        /// intervals between messages.
+        /// \note The caller must synchronize all calls.
+        ///
+        class CCoalescingWindow
+        {
+          public:
+            typedef std::chrono::steady_clock clock_t;
+
+          public:
+            void setPolicy(uint16_t _cmd, const SCoalescingPolicy& _policy);
+            void setDefaultPolicy(const SCoalescingPolicy& _policy);
+            const SCoalescingPolicy& getPolicy(uint16_t _cmd) const;
+
+            /// \brief Adds a message to the current batch.
+            /// \param _isLinkIdle true if nothing is being sent or waiting to be sent.
+            /// \return true if the batch must be sent now.
+            bool add(uint16_t _cmd, size_t _msgSize, bool _isLinkIdle, clock_t::time_point _now = clock_t::now());
+            /// \brief The batch is sent or discarded.
+            void reset();
+
+            bool empty() const;
+            /// \brief Time, when the current batch must be sent at the latest.
+            clock_t::time_point deadline() const;
+            /// \brief Estimated interval between messages.
+            clock_t::duration averageInterval() const;
+
+          private:
+            std::map<uint16_t, SCoalescingPolicy> m_policies;
+            SCoalescingPolicy m_defaultPolicy;
+
+            size_t m_nofMsgs{ 0 };
+            size_t m_nofBytes{ 0 };
+            clock_t::time_point m_deadline;
+
+            bool m_hasLastArrival{ false };
+            clock_t::time_point m_lastArrival;
+            clock_t::duration m_averageInterval{ clock_t::duration::max() };
+        };
+    } // namespace protocol_api
+} // namespace dds
+
+#endif /* defined(__DDS__CoalescingWindow__) */
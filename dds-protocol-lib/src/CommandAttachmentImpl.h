@@ -7,9 +7,12 @@
 // DDS
 #include "AgentsInfoCmd.h"
 #include "AssignUserTaskCmd.h"
+#include "AssignUserTasksCmd.h"
+#include "BatchCmd.h"
 #include "BinaryAttachmentCmd.h"
 #include "BinaryAttachmentReceivedCmd.h"
 #include "BinaryAttachmentStartCmd.h"
+#include "CachedFilesCmd.h"
 #include "CustomCmdCmd.h"
 #include "GetPropValuesCmd.h"
 #include "HostInfoCmd.h"
@@ -34,15 +37,32 @@
         static ptr_t decode(CProtocolMessage::protocolMessagePtr_t _msg)                              \
         {                                                                                             \
             ptr_t p = std::make_shared<_class>();                                                     \
-            p->convertFromData(_msg->bodyToContainer());                                              \
+            setDataOwner(p.get(), _msg);                                                              \
+            const CProtocolMessage& msg = *_msg;                                                      \
+            p->convertFromData(SByteView(msg.body(), msg.body_length(), msg.isLargeValueFormat()));   \
             return p;                                                                                 \
         }                                                                                             \
                                                                                                       \
         static CProtocolMessage::protocolMessagePtr_t encode(const _class& _attachment, uint64_t _ID) \
         {                                                                                             \
-            dds::misc::BYTEVector_t data;                                                             \
-            _attachment.convertToData(&data);                                                         \
-            return std::make_shared<CProtocolMessage>(_cmd, data, _ID);                               \
+            return std::make_shared<CProtocolMessage>(_cmd, _attachment, _ID);                        \
+        }                                                                                             \
+                                                                                                      \
+        static CProtocolMessage::sharedBodyPtr_t encodeBody(const _class& _attachment)                \
+        {                                                                                             \
+            /* Shared bodies don't carry the format, large values are encoded for each channel */     \
+            if (_attachment.hasLargeValues())                                                         \
+                return nullptr;                                                                       \
+            auto data = std::make_shared<dds::misc::BYTEVector_t>();                                  \
+            data->reserve(_attachment.size());                                                        \
+            _attachment.convertToData(data.get());                                                    \
+            return data;                                                                              \
+        }                                                                                             \
+                                                                                                      \
+        static CProtocolMessage::protocolMessagePtr_t encode(CProtocolMessage::sharedBodyPtr_t _body, \
+                                                             uint64_t _ID)                            \
+        {                                                                                             \
+            return std::make_shared<CProtocolMessage>(_cmd, _body, _ID);                              \
         }                                                                                             \
     };
 
@@ -55,6 +75,23 @@ namespace dds
         {
         };
         //----------------------------------------------------------------------
+        /// Commands are decoded directly from the message buffer. Commands which can reference the buffer instead of
+        /// copying it overload this function to take shared ownership of the message.
+        template <class T>
+        inline void setDataOwner(T* /*_attachment*/, const CProtocolMessage::protocolMessagePtr_t& /*_msg*/)
+        {
+        }
+
+        inline void setDataOwner(SBinaryAttachmentCmd* _attachment, const CProtocolMessage::protocolMessagePtr_t& _msg)
+        {
+            _attachment->m_dataOwner = _msg;
+        }
+
+        inline void setDataOwner(SBatchCmd* _attachment, const CProtocolMessage::protocolMessagePtr_t& _msg)
+        {
+            _attachment->m_dataOwner = _msg;
+        }
+        //----------------------------------------------------------------------
         template <ECmdType>
         struct SCommandAttachmentImpl;
         //----------------------------------------------------------------------
@@ -73,6 +110,16 @@ namespace dds
                 dds::misc::BYTEVector_t data;
                 return std::make_shared<CProtocolMessage>(_cmd, data, _ID);
             }
+
+            static CProtocolMessage::sharedBodyPtr_t encodeBody(const SEmptyCmd& /*_attachment*/)
+            {
+                return std::make_shared<dds::misc::BYTEVector_t>();
+            }
+
+            static CProtocolMessage::protocolMessagePtr_t encode(CProtocolMessage::sharedBodyPtr_t _body, uint64_t _ID)
+            {
+                return std::make_shared<CProtocolMessage>(_cmd, _body, _ID);
+            }
         };
 
         REGISTER_CMD_ATTACHMENT(SVersionCmd, cmdHANDSHAKE)
@@ -101,6 +148,11 @@ namespace dds
         REGISTER_CMD_ATTACHMENT(SIDCmd, cmdADD_SLOT)
         REGISTER_CMD_ATTACHMENT(SIDCmd, cmdREPLY_ADD_SLOT)
         REGISTER_CMD_ATTACHMENT(SIDCmd, cmdACTIVATE_USER_TASK)
+        REGISTER_CMD_ATTACHMENT(SBatchCmd, cmdBATCH)
+        REGISTER_CMD_ATTACHMENT(SAssignUserTasksCmd, cmdASSIGN_USER_TASKS)
+        REGISTER_CMD_ATTACHMENT(SSlotRepliesCmd, cmdREPLY_ASSIGN_USER_TASKS)
+        REGISTER_CMD_ATTACHMENT(SCachedFilesCmd, cmdCHECK_CACHED_FILES)
+        REGISTER_CMD_ATTACHMENT(SCachedFilesCmd, cmdREPLY_CHECK_CACHED_FILES)
     } // namespace protocol_api
 } // namespace dds
 
@@ -0,0 +1,87 @@
+// Copyright 2014 GSI, Inc. All rights reserved.
+//
+//
+//
+#include "Compression.h"
+// STD
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+// ZLIB
+#include <zlib.h>
+
+using namespace std;
+using namespace dds;
+using namespace dds::protocol_api;
+
+// Size of the buffer used to read and write files
+static const size_t fileBufferSize = 256 * 1024;
+
+size_t dds::protocol_api::compressedSizeBound(size_t _size)
+{
+    return compressBound(_size);
+}
+
+size_t dds::protocol_api::compressData(
+    const uint8_t* _src, size_t _srcSize, uint8_t* _dest, size_t _destSize, int _level)
+{
+    uLongf destSize = _destSize;
+    const int ret = compress2(_dest, &destSize, _src, _srcSize, _level);
+    if (ret != Z_OK)
+        throw runtime_error("Failed to compress data: " + string(zError(ret)));
+    return destSize;
+}
+
+void dds::protocol_api::uncompressData(const uint8_t* _src, size_t _srcSize, uint8_t* _dest, size_t _destSize)
+{
+    uLongf destSize = _destSize;
+    const int ret = uncompress(_dest, &destSize, _src, _srcSize);
+    if (ret != Z_OK)
+        throw runtime_error("Failed to uncompress data: " + string(zError(ret)));
+    if (destSize != _destSize)
+        throw runtime_error("Failed to uncompress data: size mismatch");
+}
+
+void dds::protocol_api::compressFile(const string& _srcFilePath, const string& _destFilePath, int _level)
+{
+    ifstream src(_srcFilePath, ios::binary);
+    if (!src.is_open())
+        throw runtime_error("Could not open the source file: " + _srcFilePath);
+
+    const string mode("wb" + to_string(_level));
+    unique_ptr<gzFile_s, decltype(&gzclose)> dest(gzopen(_destFilePath.c_str(), mode.c_str()), &gzclose);
+    if (dest == nullptr)
+        throw runtime_error("Could not open the destination file: " + _destFilePath);
+
+    vector<char> buf(fileBufferSize);
+    while (src.read(buf.data(), buf.size()) || src.gcount() > 0)
+    {
+        if (gzwrite(dest.get(), buf.data(), static_cast<unsigned int>(src.gcount())) != src.gcount())
+            throw runtime_error("Could not write the destination file: " + _destFilePath);
+    }
+
+    if (gzclose(dest.release()) != Z_OK)
+        throw runtime_error("Could not write the destination file: " + _destFilePath);
+}
+
+void dds::protocol_api::uncompressFile(const string& _srcFilePath, const string& _destFilePath)
+{
+    unique_ptr<gzFile_s, decltype(&gzclose)> src(gzopen(_srcFilePath.c_str(), "rb"), &gzclose);
+    if (src == nullptr)
+        throw runtime_error("Could not open the source file: " + _srcFilePath);
+
+    ofstream dest(_destFilePath, ios::binary);
+    if (!dest.is_open())
+        throw runtime_error("Could not open the destination file: " + _destFilePath);
+
+    vector<char> buf(fileBufferSize);
+    int size(0);
+    while ((size = gzread(src.get(), buf.data(), static_cast<unsigned int>(buf.size()))) > 0)
+        dest.write(buf.data(), size);
+
+    if (size < 0)
+        throw runtime_error("Could not uncompress the source file: " + _srcFilePath);
+    if (!dest.flush())
+        throw runtime_error("Could not write the destination file: " + _destFilePath);
+}
@@ -0,0 +1,41 @@
+// Copyright 2014 GSI, Inc. All rights reserved.
+//
+//
+//
+#ifndef __DDS__Compression__
+#define __DDS__Compression__
+// STD
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace dds
+{
+    namespace protocol_api
+    {
+        /// \brief Max size of the data, which is produced by compressing _size bytes.
+        size_t compressedSizeBound(size_t _size);
+
+        /// \brief Compresses the data with zlib.
+        /// \param _dest buffer of at least compressedSizeBound(_srcSize) bytes.
+        /// \param _level compression level from 1 (fastest) to 9 (best).
+        /// \return size of the compressed data.
+        /// \throw std::runtime_error if the data can't be compressed.
+        size_t compressData(const uint8_t* _src, size_t _srcSize, uint8_t* _dest, size_t _destSize, int _level);
+
+        /// \brief Uncompresses zlib compressed data.
+        /// \param _destSize exact size of the uncompressed data.
+        /// \throw std::runtime_error if the data is corrupted or its uncompressed size doesn't match _destSize.
+        void uncompressData(const uint8_t* _src, size_t _srcSize, uint8_t* _dest, size_t _destSize);
+
+        /// \brief Compresses the file into a gzip file, which can be also uncompressed by "gzip -d".
+        /// \throw std::runtime_error on failure.
+        void compressFile(const std::string& _srcFilePath, const std::string& _destFilePath, int _level);
+
+        /// \brief Uncompresses the gzip file.
+        /// \throw std::runtime_error on failure.
+        void uncompressFile(const std::string& _srcFilePath, const std::string& _destFilePath);
+    } // namespace protocol_api
+} // namespace dds
+
+#endif /* defined(__DDS__Compression__) */
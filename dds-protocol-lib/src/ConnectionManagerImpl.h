@@ -6,15 +6,18 @@
 #ifndef __DDS__ConnectionManagerImpl__
 #define __DDS__ConnectionManagerImpl__
 // DDS
-#include "ChannelInfo.h"
+#include "ChannelRegistry.h"
 #include "CommandAttachmentImpl.h"
 #include "MonitoringThread.h"
 #include "Options.h"
 #include "ProtocolMessage.h"
 // STD
+#include <algorithm>
+#include <atomic>
 #include <mutex>
 // BOOST
 #include <boost/asio/basic_socket_acceptor.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
 #include <boost/thread/thread.hpp>
 // MiscCommon
 #include "INet.h"
@@ -26,10 +29,15 @@ namespace dds
 #if BOOST_VERSION >= 107000
         typedef boost::asio::basic_socket_acceptor<boost::asio::ip::tcp, boost::asio::io_context::executor_type>
             asioAcceptor_t;
+        typedef boost::asio::basic_socket_acceptor<boost::asio::local::stream_protocol,
+                                                   boost::asio::io_context::executor_type>
+            asioLocalAcceptor_t;
 #else
         typedef boost::asio::basic_socket_acceptor<boost::asio::ip::tcp> asioAcceptor_t;
+        typedef boost::asio::basic_socket_acceptor<boost::asio::local::stream_protocol> asioLocalAcceptor_t;
 #endif
         typedef std::shared_ptr<asioAcceptor_t> asioAcceptorPtr_t;
+        typedef std::shared_ptr<asioLocalAcceptor_t> asioLocalAcceptorPtr_t;
 
         /// \class CConnectionManagerImpl
         /// \brief Base class for connection managers.
@@ -40,7 +48,6 @@ namespace dds
             typedef SChannelInfo<T> channelInfo_t;
             typedef SWeakChannelInfo<T> weakChannelInfo_t;
             typedef std::function<bool(const channelInfo_t& _channelInfo, bool& /*_stop*/)> conditionFunction_t;
-            using channelContainerCache_t = std::map<uint64_t, weakChannelInfo_t>;
 
           public:
             CConnectionManagerImpl(size_t _minPort, size_t _maxPort, bool _useUITransport)
@@ -88,12 +95,23 @@ namespace dds
                     A* pThis = static_cast<A*>(this);
                     pThis->_start();
 
-                    const double maxIdleTime =
-                        user_defaults_api::CUserDefaults::instance().getOptions().m_server.m_idleTime;
+                    const auto& serverOptions = user_defaults_api::CUserDefaults::instance().getOptions().m_server;
+                    const double maxIdleTime = serverOptions.m_idleTime;
 
                     CMonitoringThread::instance().start(maxIdleTime,
                                                         []() { LOG(dds::misc::info) << "Idle callback called."; });
 
+                    // a thread pool for the DDS transport engine
+                    // may return 0 when not able to detect
+                    unsigned int concurrentThreads = (0 == _nThreads) ? std::thread::hardware_concurrency() : _nThreads;
+                    // we need at least 2 threads
+                    if (concurrentThreads < 2)
+                        concurrentThreads = 2;
+
+                    // Shards must exist before the first connection is accepted
+                    if (serverOptions.m_ioContextPerThread)
+                        createShards(concurrentThreads);
+
                     bindPortAndListen(m_acceptor);
                     createClientAndStartAccept(m_acceptor);
 
@@ -103,21 +121,35 @@ namespace dds
                     {
                         bindPortAndListen(m_acceptorUI);
                         createClientAndStartAccept(m_acceptorUI);
+
+                        // Clients on the same host prefer the Unix domain socket
+                        bindLocalAndListen(m_acceptorLocal);
+                        if (m_acceptorLocal != nullptr)
+                            createClientAndStartAccept(m_acceptorLocal);
                     }
 
                     // Create a server info file
                     createInfoFile();
 
-                    // a thread pool for the DDS transport engine
-                    // may return 0 when not able to detect
-                    unsigned int concurrentThreads = (0 == _nThreads) ? std::thread::hardware_concurrency() : _nThreads;
-                    // we need at least 2 threads
-                    if (concurrentThreads < 2)
-                        concurrentThreads = 2;
-                    LOG(dds::misc::info) << "Starting DDS transport engine using " << concurrentThreads
-                                         << " concurrent threads.";
-                    for (unsigned int x = 0; x < concurrentThreads; ++x)
+                    if (m_shards.empty())
+                    {
+                        LOG(dds::misc::info) << "Starting DDS transport engine using " << concurrentThreads
+                                             << " concurrent threads.";
+                        for (unsigned int x = 0; x < concurrentThreads; ++x)
+                        {
+                            m_workerThreads.create_thread([this]()
+                                                          { runService(10, m_acceptor->get_executor().context()); });
+                        }
+                    }
+                    else
                     {
+                        LOG(dds::misc::info) << "Starting DDS transport engine using " << m_shards.size()
+                                             << " io_context shards, one thread per shard.";
+                        for (auto& shard : m_shards)
+                        {
+                            m_workerThreads.create_thread([this, shard]() { runService(10, *shard); });
+                        }
+                        // Accepts new connections and runs jobs, which are not bound to a connection
                         m_workerThreads.create_thread([this]()
                                                       { runService(10, m_acceptor->get_executor().context()); });
                     }
@@ -200,12 +232,22 @@ namespace dds
                     m_acceptor->close();
                     m_acceptor->get_executor().context().stop();
 
+                    m_shardWorkGuards.clear();
+                    for (auto& shard : m_shards)
+                        shard->stop();
+
                     if (m_acceptorUI != nullptr)
                     {
                         m_acceptorUI->close();
                         m_acceptorUI->get_executor().context().stop();
                     }
 
+                    if (m_acceptorLocal != nullptr)
+                    {
+                        m_acceptorLocal->close();
+                        ::unlink(m_localSocketPath.c_str());
+                    }
+
                     for (const auto& v : channels)
                     {
                         if (v.m_channel.expired())
@@ -214,7 +256,6 @@ namespace dds
                         ptr->stop();
                     }
 
-                    std::lock_guard<std::mutex> lock(m_mutex);
                     m_channels.clear();
                 }
                 catch (std::bad_weak_ptr& e)
@@ -230,78 +271,81 @@ namespace dds
           protected:
             void updateChannelProtocolHeaderID(const weakChannelInfo_t& _channelInfo)
             {
-                std::lock_guard<std::mutex> lock(m_mutex);
-
                 auto p = _channelInfo.m_channel.lock();
                 if (p == nullptr)
                     return;
 
-                for (auto& inf : m_channels)
-                {
-                    if (inf.m_channel.get() == p.get() && inf.m_protocolHeaderID == 0)
-                    {
-                        inf.m_protocolHeaderID = _channelInfo.m_protocolHeaderID;
-                        return;
-                    }
-                }
+                if (m_channels.updateProtocolHeaderID(p.get(), _channelInfo.m_protocolHeaderID))
+                    return;
                 LOG(dds::misc::error) << "Failed to update protocol channel header ID <"
                                       << _channelInfo.m_protocolHeaderID << "> . Channel is not registered";
             }
 
+            /// \brief Re-indexes the channel after its keys have changed, see SChannelKeys.
+            /// \param _protocolHeaderID The changed slot, 0 for the whole channel.
+            void updateChannelKeys(const T* _channel, uint64_t _protocolHeaderID = 0)
+            {
+                m_channels.update(_channel, _protocolHeaderID);
+            }
+
             weakChannelInfo_t getChannelByID(uint64_t _protocolHeaderID)
             {
-                std::lock_guard<std::mutex> lock(m_mutex);
+                channelInfo_t v;
+                if (!m_channels.find(_protocolHeaderID, v))
+                    return weakChannelInfo_t();
+                return weakChannelInfo_t(v.m_channel, v.m_protocolHeaderID, v.m_isSlot);
+            }
 
-                // Initial creation of the cache
-                if (m_channelsCache.empty())
-                {
-                    for (auto& v : m_channels)
-                    {
-                        if (v.m_protocolHeaderID == 0)
-                            continue;
-                        //    commander_cmd::SAgentInfo inf = v.m_channel->getAgentInfo(v.m_protocolHeaderID);
-                        m_channelsCache.insert(std::make_pair(
-                            v.m_protocolHeaderID, weakChannelInfo_t(v.m_channel, v.m_protocolHeaderID, v.m_isSlot)));
-                    }
-                }
+            /// \brief Returns the slot, which executes the given task.
+            weakChannelInfo_t getChannelByTaskID(uint64_t _taskID)
+            {
+                channelInfo_t v;
+                if (!m_channels.findByTaskID(_taskID, v))
+                    return weakChannelInfo_t();
+                return weakChannelInfo_t(v.m_channel, v.m_protocolHeaderID, v.m_isSlot);
+            }
 
-                // Value found in the cache
-                auto it = m_channelsCache.find(_protocolHeaderID);
-                if (it != m_channelsCache.end())
-                    return it->second;
+            typename weakChannelInfo_t::container_t getChannels(conditionFunction_t _condition = nullptr)
+            {
+                return filterChannels(*m_channels.channels(), _condition);
+            }
 
-                for (auto& v : m_channels)
-                {
-                    //  commander_cmd::SAgentInfo inf = v.m_channel->getAgentInfo(v.m_protocolHeaderID);
-                    if (v.m_protocolHeaderID == _protocolHeaderID)
-                    {
-                        // Add the item into the cache
-                        m_channelsCache.insert(std::make_pair(
-                            v.m_protocolHeaderID, weakChannelInfo_t(v.m_channel, v.m_protocolHeaderID, v.m_isSlot)));
-                        // TODO: need to clean cache from dead channels
-                        return weakChannelInfo_t(v.m_channel, v.m_protocolHeaderID, v.m_isSlot);
-                    }
-                }
-                return weakChannelInfo_t();
+            /// \brief Returns channels of the given type using the index instead of checking all channels.
+            /// \param _isSlot true for task slots of agents, false for the agent channels themselves.
+            typename weakChannelInfo_t::container_t getChannels(EChannelType _type,
+                                                                bool _isSlot,
+                                                                conditionFunction_t _condition = nullptr)
+            {
+                return filterChannels(*m_channels.channels(_type, _isSlot), _condition);
             }
 
-            typename weakChannelInfo_t::container_t getChannels(conditionFunction_t _condition = nullptr)
+            /// \brief Returns channels of the given type and state, see SChannelKeys::m_state.
+            typename weakChannelInfo_t::container_t getChannels(EChannelType _type,
+                                                                bool _isSlot,
+                                                                uint32_t _state,
+                                                                conditionFunction_t _condition = nullptr)
             {
-                std::lock_guard<std::mutex> lock(m_mutex);
+                return filterChannels(*m_channels.channels(_type, _isSlot, _state), _condition);
+            }
 
-                typename weakChannelInfo_t::container_t result;
-                result.reserve(m_channels.size());
-                for (auto& v : m_channels)
-                {
-                    bool stop = false;
-                    if (_condition == nullptr || _condition(v, stop))
-                    {
-                        result.push_back(weakChannelInfo_t(v.m_channel, v.m_protocolHeaderID, v.m_isSlot));
-                        if (stop)
-                            break;
-                    }
-                }
-                return result;
+            /// \brief Returns the channel of the agent and its slots.
+            typename weakChannelInfo_t::container_t getChannelsOfAgent(uint64_t _agentID,
+                                                                       conditionFunction_t _condition = nullptr)
+            {
+                return filterChannels(*m_channels.channelsOfAgent(_agentID), _condition);
+            }
+
+            /// \brief Returns channels of remote ends on the given host.
+            typename weakChannelInfo_t::container_t getChannelsOnHost(const std::string& _host,
+                                                                      conditionFunction_t _condition = nullptr)
+            {
+                return filterChannels(*m_channels.channelsOnHost(_host), _condition);
+            }
+
+            /// \brief Returns channels, which receive cmdUSER_TASK_DONE events.
+            typename weakChannelInfo_t::container_t getTaskDoneSubscribers(conditionFunction_t _condition = nullptr)
+            {
+                return filterChannels(*m_channels.taskDoneSubscribers(), _condition);
             }
 
             template <ECmdType _cmd, class AttachmentType>
@@ -310,40 +354,68 @@ namespace dds
                 try
                 {
                     typename weakChannelInfo_t::container_t channels(getChannels(_condition));
+                    if (channels.empty())
+                        return;
 
-                    for (const auto& v : channels)
+                    // Encode the attachment only once. Each channel gets its own header only. Attachments with large
+                    // values are encoded for each channel.
+                    CProtocolMessage::sharedBodyPtr_t body = SCommandAttachmentImpl<_cmd>::encodeBody(_attachment);
+
+                    for (const auto& v : deferCongestedChannels(channels))
                     {
                         if (v.m_channel.expired())
                             continue;
                         auto ptr = v.m_channel.lock();
-                        ptr->template pushMsg<_cmd>(_attachment, v.m_protocolHeaderID);
+                        ptr->template pushEncodedMsg<_cmd>(_attachment, body, v.m_protocolHeaderID);
                     }
                 }
                 catch (std::bad_weak_ptr& e)
                 {
                     // TODO: Do we need to log something here?
                 }
+                catch (std::exception& e)
+                {
+                    LOG(dds::misc::error) << "Can't broadcast message: " << e.what();
+                }
             }
 
             template <ECmdType _cmd, class AttachmentType>
             void accumulativeBroadcastMsg(const AttachmentType& _attachment, conditionFunction_t _condition = nullptr)
+            {
+                accumulativeBroadcastMsg<_cmd>(_attachment, getChannels(_condition));
+            }
+
+            /// \brief Broadcasts the message to the given channels, e.g. selected by an index.
+            template <ECmdType _cmd, class AttachmentType>
+            void accumulativeBroadcastMsg(const AttachmentType& _attachment,
+                                          const typename weakChannelInfo_t::container_t& _channels)
             {
                 try
                 {
-                    typename weakChannelInfo_t::container_t channels(getChannels(_condition));
+                    if (_channels.empty())
+                        return;
+                    typename weakChannelInfo_t::container_t channels(deferCongestedChannels(_channels));
+
+                    // Encode the attachment only once. Each channel gets its own header only. Attachments with large
+                    // values are encoded for each channel.
+                    CProtocolMessage::sharedBodyPtr_t body = SCommandAttachmentImpl<_cmd>::encodeBody(_attachment);
 
                     for (const auto& v : channels)
                     {
                         if (v.m_channel.expired())
                             continue;
                         auto ptr = v.m_channel.lock();
-                        ptr->template accumulativePushMsg<_cmd>(_attachment, v.m_protocolHeaderID);
+                        ptr->template accumulativePushEncodedMsg<_cmd>(_attachment, body, v.m_protocolHeaderID);
                     }
                 }
                 catch (std::bad_weak_ptr& e)
                 {
                     // TODO: Do we need to log something here?
                 }
+                catch (std::exception& e)
+                {
+                    LOG(dds::misc::error) << "Can't broadcast accumulative message: " << e.what();
+                }
             }
 
             template <ECmdType _cmd>
@@ -353,50 +425,50 @@ namespace dds
                 broadcastMsg<_cmd>(cmd, _condition);
             }
 
+            /// \brief Sends the given file to all matching channels. The file is read and split into pieces once.
             void broadcastBinaryAttachmentCmd(const std::string& _srcFilePath,
                                               const std::string& _fileName,
                                               uint16_t _cmdSource,
                                               conditionFunction_t _condition = nullptr)
             {
-                dds::misc::BYTEVector_t data;
-
-                std::string srcFilePath(_srcFilePath);
-                // Resolve environment variables
-                dds::misc::smart_path(&srcFilePath);
-
-                std::ifstream f(srcFilePath);
-                if (!f.is_open() || !f.good())
-                {
-                    throw std::runtime_error("Could not open the source file: " + srcFilePath);
-                }
-                f.seekg(0, std::ios::end);
-                data.reserve(f.tellg());
-                f.seekg(0, std::ios::beg);
-                data.assign((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
-
-                broadcastBinaryAttachmentCmd(data, _fileName, _cmdSource, _condition);
+                broadcastBinaryAttachmentCmd(
+                    SSharedBinaryAttachment::makeFromFile(_srcFilePath), _fileName, _cmdSource, _condition);
             }
 
             void broadcastBinaryAttachmentCmd(const dds::misc::BYTEVector_t& _data,
                                               const std::string& _fileName,
                                               uint16_t _cmdSource,
                                               conditionFunction_t _condition = nullptr)
+            {
+                broadcastBinaryAttachmentCmd(
+                    SSharedBinaryAttachment::makeFromData(_data), _fileName, _cmdSource, _condition);
+            }
+
+            /// \brief Sends the given attachment to all matching channels. All channels share its pieces.
+            void broadcastBinaryAttachmentCmd(SSharedBinaryAttachment::ptr_t _attachment,
+                                              const std::string& _fileName,
+                                              uint16_t _cmdSource,
+                                              conditionFunction_t _condition = nullptr)
             {
                 try
                 {
-                    typename weakChannelInfo_t::container_t channels(getChannels(_condition));
+                    typename weakChannelInfo_t::container_t channels(deferCongestedChannels(getChannels(_condition)));
 
                     for (const auto& v : channels)
                     {
+                        auto channel = v.m_channel.lock();
+                        if (channel == nullptr)
+                            continue;
                         // Post each push call, otherwise it will block other pushes until "post" each block of the
-                        // binary file if the file is big.
-                        this->m_ioContext.post(
-                            [&]
+                        // binary file if the file is big. The call is posted to the thread of the channel.
+                        boost::asio::post(
+                            channel->socket().get_executor(),
+                            [v, _attachment, _fileName, _cmdSource]
                             {
                                 if (v.m_channel.expired())
                                     return;
                                 auto ptr = v.m_channel.lock();
-                                ptr->pushBinaryAttachmentCmd(_data, _fileName, _cmdSource, v.m_protocolHeaderID);
+                                ptr->pushBinaryAttachmentCmd(_attachment, _fileName, _cmdSource, v.m_protocolHeaderID);
                             });
                     }
                 }
@@ -404,16 +476,80 @@ namespace dds
                 {
                     // TODO: Do we need to log something here?
                 }
+                catch (std::exception& e)
+                {
+                    LOG(dds::misc::error) << "Can't broadcast binary attachment: " << e.what();
+                }
             }
 
             size_t countNofChannels(conditionFunction_t _condition = nullptr)
             {
-                std::lock_guard<std::mutex> lock(m_mutex);
-
                 if (_condition == nullptr)
                     return m_channels.size();
+                return countChannels(*m_channels.channels(), _condition);
+            }
+
+            /// \brief Counts channels of the given type using the index instead of checking all channels.
+            size_t countNofChannels(EChannelType _type, bool _isSlot, conditionFunction_t _condition = nullptr)
+            {
+                return countChannels(*m_channels.channels(_type, _isSlot), _condition);
+            }
+
+            /// \brief Counts channels of the given type and state using the index.
+            size_t countNofChannels(EChannelType _type,
+                                    bool _isSlot,
+                                    uint32_t _state,
+                                    conditionFunction_t _condition = nullptr)
+            {
+                if (_condition == nullptr)
+                    return m_channels.count(_type, _isSlot, _state);
+                return countChannels(*m_channels.channels(_type, _isSlot, _state), _condition);
+            }
+
+          private:
+            /// \brief Moves channels with a congested write queue to the end, thus a slow remote end doesn't delay the
+            /// delivery to the others. Congested channels still get the message.
+            static typename weakChannelInfo_t::container_t deferCongestedChannels(
+                typename weakChannelInfo_t::container_t _channels)
+            {
+                auto congested = std::stable_partition(_channels.begin(),
+                                                       _channels.end(),
+                                                       [](const weakChannelInfo_t& _v)
+                                                       {
+                                                           auto ptr = _v.m_channel.lock();
+                                                           return (ptr == nullptr || !ptr->isWriteQueueCongested());
+                                                       });
+                if (congested != _channels.end())
+                    LOG(dds::misc::debug) << "Broadcast defers " << std::distance(congested, _channels.end())
+                                          << " congested channels out of " << _channels.size();
+                return _channels;
+            }
+
+            static typename weakChannelInfo_t::container_t filterChannels(
+                const typename channelInfo_t::container_t& _channels, conditionFunction_t _condition)
+            {
+                typename weakChannelInfo_t::container_t result;
+                result.reserve(_channels.size());
+                for (auto& v : _channels)
+                {
+                    bool stop = false;
+                    if (_condition == nullptr || _condition(v, stop))
+                    {
+                        result.push_back(weakChannelInfo_t(v.m_channel, v.m_protocolHeaderID, v.m_isSlot));
+                        if (stop)
+                            break;
+                    }
+                }
+                return result;
+            }
+
+            static size_t countChannels(const typename channelInfo_t::container_t& _channels,
+                                        conditionFunction_t _condition)
+            {
+                if (_condition == nullptr)
+                    return _channels.size();
                 size_t counter = 0;
-                for (auto& v : m_channels)
+                for (auto& v : _channels)
                 {
                     bool stop = false;
                     if (_condition(v, stop))
@@ -436,17 +572,16 @@ namespace dds
                 return _ec == _canceled();
             }
 
+            template <class Acceptor>
             void acceptHandler(typename T::connectionPtr_t _client,
-                               asioAcceptorPtr_t _acceptor,
+                               std::shared_ptr<Acceptor> _acceptor,
                                const boost::system::error_code& _ec)
             {
                 if (!_ec)
                 {
-                    {
-                        std::lock_guard<std::mutex> lock(m_mutex);
-                        m_channels.push_back(channelInfo_t(_client, _client->getProtocolHeaderID(), false));
-                    }
-                    _client->start();
+                    m_channels.add(channelInfo_t(_client, _client->getProtocolHeaderID(), false));
+                    // The client might belong to another shard
+                    boost::asio::post(_client->socket().get_executor(), [_client]() { _client->start(); });
                     createClientAndStartAccept(_acceptor);
                 }
                 else
@@ -458,9 +593,14 @@ namespace dds
                 }
             }
 
-            void createClientAndStartAccept(asioAcceptorPtr_t& _acceptor)
+            template <class Acceptor>
+            void createClientAndStartAccept(std::shared_ptr<Acceptor>& _acceptor)
             {
-                typename T::connectionPtr_t newClient = T::makeNew(_acceptor->get_executor().context(), 0);
+                // Connections of the main transport are distributed among shards, UI connections aren't
+                boost::asio::io_context& context = (static_cast<const void*>(_acceptor.get()) == m_acceptor.get())
+                                                       ? nextShard()
+                                                       : _acceptor->get_executor().context();
+                typename T::connectionPtr_t newClient = T::makeNew(context, 0);
 
                 A* pThis = static_cast<A*>(this);
                 pThis->newClientCreated(newClient);
@@ -469,27 +609,51 @@ namespace dds
                 newClient->template registerHandler<EChannelEvents::OnReplyAddSlot>(
                     [this, newClient](const SSenderInfo& _sender) -> void
                     {
-                        {
-                            std::lock_guard<std::mutex> lock(m_mutex);
-                            m_channels.push_back(channelInfo_t(newClient, _sender.m_ID, true));
-                        }
+                        m_channels.add(channelInfo_t(newClient, _sender.m_ID, true));
 
                         LOG(dds::misc::info)
                             << "Adding new slot to " << newClient->getId() << " with id " << _sender.m_ID;
                     });
 
+                // The type of the channel is known after the handshake
+                newClient->template registerHandler<EChannelEvents::OnHandshakeOK>(
+                    [this, newClient](const SSenderInfo& /*_sender*/) -> void { m_channels.update(newClient.get()); });
+
+                newClient->template registerHandler<EChannelEvents::OnChannelKeysChanged>(
+                    [this, newClient](const SSenderInfo& _sender) -> void
+                    { m_channels.update(newClient.get(), _sender.m_ID); });
+
                 // Subscribe on the disconnect event
                 newClient->template registerHandler<EChannelEvents::OnRemoteEndDissconnected>(
                     [this, newClient](const SSenderInfo& /*_sender*/) -> void { this->removeClient(newClient.get()); });
 
                 _acceptor->async_accept(newClient->socket(),
-                                        std::bind(&CConnectionManagerImpl::acceptHandler,
+                                        std::bind(&CConnectionManagerImpl::acceptHandler<Acceptor>,
                                                   this->shared_from_this(),
                                                   newClient,
                                                   _acceptor,
                                                   std::placeholders::_1));
             }
 
+            void createShards(size_t _nofShards)
+            {
+                for (size_t i = 0; i < _nofShards; ++i)
+                {
+                    auto shard = std::make_shared<boost::asio::io_context>(1);
+                    // Shards run until the transport is stopped, even without connections
+                    m_shardWorkGuards.push_back(boost::asio::make_work_guard(*shard));
+                    m_shards.push_back(shard);
+                }
+            }
+
+            /// \brief Returns the io_context of the next shard round-robin, or the main one if shards are disabled.
+            boost::asio::io_context& nextShard()
+            {
+                if (m_shards.empty())
+                    return m_acceptor->get_executor().context();
+                return *m_shards[m_nextShard++ % m_shards.size()];
+            }
+
             void createInfoFile()
             {
                 // The child needs to have that method
@@ -500,7 +664,7 @@ namespace dds
                 if (m_acceptorUI != nullptr)
                     ports.push_back(m_acceptorUI->local_endpoint().port());
 
-                pThis->_createInfoFile(ports);
+                pThis->_createInfoFile(ports, m_localSocketPath);
             }
 
             void deleteInfoFile()
@@ -515,12 +679,8 @@ namespace dds
                 // TODO: fix getTypeName call
                 LOG(dds::misc::debug) << "Removing " /*<< _client->getTypeName()*/
                                       << " client from the list of active";
-                std::lock_guard<std::mutex> lock(m_mutex);
                 // FIXME: Delete all connections of the channel if the primary protocol header ID is deleted
-                m_channels.erase(remove_if(m_channels.begin(),
-                                           m_channels.end(),
-                                           [&](const channelInfo_t& i) { return (i.m_channel.get() == _client); }),
-                                 m_channels.end());
+                m_channels.remove(_client);
             }
 
             void bindPortAndListen(asioAcceptorPtr_t& _acceptor)
@@ -555,15 +715,33 @@ namespace dds
                 }
             }
 
+            void bindLocalAndListen(asioLocalAcceptorPtr_t& _acceptor)
+            {
+                const std::string path(user_defaults_api::CUserDefaults::instance().getUISocketFileLocation());
+                try
+                {
+                    // Remove a stale socket file, e.g. of a crashed commander
+                    ::unlink(path.c_str());
+                    _acceptor = std::make_shared<asioLocalAcceptor_t>(m_ioContext,
+                                                                      boost::asio::local::stream_protocol::endpoint(path));
+                    m_localSocketPath = path;
+                }
+                catch (std::exception& _e)
+                {
+                    // E.g. the path is longer than allowed for Unix domain sockets
+                    _acceptor.reset();
+                    LOG(dds::misc::warning) << "Can't listen on the local socket " << path << ": " << _e.what()
+                                            << ". Local clients will use TCP.";
+                }
+            }
+
           private:
             size_t m_minPort;
             size_t m_maxPort;
             bool m_useUITransport;
             /// The signal_set is used to register for process termination notifications.
             std::shared_ptr<boost::asio::signal_set> m_signals;
-            std::mutex m_mutex;
-            typename channelInfo_t::container_t m_channels;
-            channelContainerCache_t m_channelsCache;
+            CChannelRegistry<T> m_channels;
 
             /// Used for the main communication
             boost::asio::io_context m_ioContext;
@@ -572,6 +750,15 @@ namespace dds
             // Used for UI (priority) communication
             boost::asio::io_context m_ioContext_UI;
             asioAcceptorPtr_t m_acceptorUI;
+            // Used for UI communication on the same host, shares the io_context with the main communication
+            asioLocalAcceptorPtr_t m_acceptorLocal;
+            std::string m_localSocketPath; ///< Empty if the local socket isn't available
+
+            // One io_context per thread for connections of the main transport, if enabled
+            typedef std::shared_ptr<boost::asio::io_context> ioContextPtr_t;
+            std::vector<ioContextPtr_t> m_shards;
+            std::vector<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> m_shardWorkGuards;
+            std::atomic<size_t> m_nextShard{ 0 };
 
             boost::thread_group m_workerThreads;
         };
@@ -18,7 +18,7 @@ SCustomCmdCmd::SCustomCmdCmd()
 
 size_t SCustomCmdCmd::size() const
 {
-    return dsize(m_timestamp) + dsize(m_senderId) + dsize(m_sCmd) + dsize(m_sCondition);
+    return dsize(m_timestamp) + dsize(m_senderId) + dsizeLargeValue(m_sCmd) + dsize(m_sCondition);
 }
 
 bool SCustomCmdCmd::operator==(const SCustomCmdCmd& val) const
@@ -27,14 +27,19 @@ bool SCustomCmdCmd::operator==(const SCustomCmdCmd& val) const
             m_sCondition == val.m_sCondition);
 }
 
-void SCustomCmdCmd::_convertFromData(const BYTEVector_t& _data)
+bool SCustomCmdCmd::hasLargeValues() const
 {
-    SAttachmentDataProvider(_data).get(m_timestamp).get(m_senderId).get(m_sCmd).get(m_sCondition);
+    return isLargeValue(m_sCmd);
+}
+
+void SCustomCmdCmd::_convertFromData(const SByteView& _data)
+{
+    SAttachmentDataProvider(_data).get(m_timestamp).get(m_senderId).getLargeValue(m_sCmd).get(m_sCondition);
 }
 
 void SCustomCmdCmd::_convertToData(BYTEVector_t* _data) const
 {
-    SAttachmentDataProvider(_data).put(m_timestamp).put(m_senderId).put(m_sCmd).put(m_sCondition);
+    SAttachmentDataProvider(_data).put(m_timestamp).put(m_senderId).putLargeValue(m_sCmd).put(m_sCondition);
 }
 
 std::ostream& dds::protocol_api::operator<<(std::ostream& _stream, const SCustomCmdCmd& val)
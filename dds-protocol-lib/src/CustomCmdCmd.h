@@ -15,9 +15,11 @@ namespace dds
         {
             SCustomCmdCmd();
             size_t size() const;
-            void _convertFromData(const dds::misc::BYTEVector_t& _data);
+            void _convertFromData(const SByteView& _data);
             void _convertToData(dds::misc::BYTEVector_t* _data) const;
             bool operator==(const SCustomCmdCmd& val) const;
+            /// \brief The command can exceed 2^16 symbols if the remote end supports large values.
+            bool hasLargeValues() const;
 
             uint64_t m_timestamp;
             uint64_t m_senderId;
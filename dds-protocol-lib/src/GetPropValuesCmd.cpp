@@ -25,7 +25,7 @@ bool SGetPropValuesCmd::operator==(const SGetPropValuesCmd& val) const
     return (m_sPropertyName == val.m_sPropertyName);
 }
 
-void SGetPropValuesCmd::_convertFromData(const BYTEVector_t& _data)
+void SGetPropValuesCmd::_convertFromData(const SByteView& _data)
 {
     SAttachmentDataProvider(_data).get(m_sPropertyName);
 }
@@ -30,7 +30,7 @@ bool SHostInfoCmd::operator==(const SHostInfoCmd& val) const
             m_groupName == val.m_groupName);
 }
 
-void SHostInfoCmd::_convertFromData(const BYTEVector_t& _data)
+void SHostInfoCmd::_convertFromData(const SByteView& _data)
 {
     SAttachmentDataProvider(_data)
         .get(m_agentPid)
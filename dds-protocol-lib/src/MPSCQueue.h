@@ -0,0 +1,112 @@
+// Copyright 2014 GSI, Inc. All rights reserved.
+//
+//
+//
+#ifndef __DDS__MPSCQueue__
+#define __DDS__MPSCQueue__
+// STD
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace dds
+{
+    namespace protocol_api
+    {
+        ///
+        /// \brief Lock-free multi-producer single-consumer queue.
+        /// \details Producers push elements onto an atomic list with a single CAS. The consumer takes the whole list
+        /// at once with an atomic exchange and processes it in push order. Since the consumer never removes single
+        /// elements, the list doesn't suffer from the ABA problem. Elements pushed by one thread keep their order.
+        /// \note push() and empty() can be called from any thread. popAll() must not be called concurrently.
+        ///
+        template <class T>
+        class CMPSCQueue
+        {
+            struct SNode
+            {
+                T m_value;
+                SNode* m_next;
+            };
+
+          public:
+            CMPSCQueue() = default;
+            CMPSCQueue(const CMPSCQueue&) = delete;
+            CMPSCQueue& operator=(const CMPSCQueue&) = delete;
+
+            ~CMPSCQueue()
+            {
+                deleteNodes(m_head.exchange(nullptr, std::memory_order_acquire));
+            }
+
+            void push(T _value)
+            {
+                SNode* node = new SNode{ std::move(_value), m_head.load(std::memory_order_relaxed) };
+                while (!m_head.compare_exchange_weak(
+                    node->m_next, node, std::memory_order_release, std::memory_order_relaxed))
+                {
+                }
+            }
+
+            /// \brief Takes all elements and calls _func for each of them in push order.
+            /// \return number of elements.
+            template <class F>
+            size_t popAll(F&& _func)
+            {
+                SNode* head = m_head.exchange(nullptr, std::memory_order_acquire);
+                if (head == nullptr)
+                    return 0;
+
+                // The list is in reverse push order
+                SNode* reversed(nullptr);
+                size_t count(0);
+                while (head != nullptr)
+                {
+                    SNode* next = head->m_next;
+                    head->m_next = reversed;
+                    reversed = head;
+                    head = next;
+                    ++count;
+                }
+
+                while (reversed != nullptr)
+                {
+                    SNode* next = reversed->m_next;
+                    try
+                    {
+                        _func(reversed->m_value);
+                    }
+                    catch (...)
+                    {
+                        deleteNodes(reversed);
+                        throw;
+                    }
+                    delete reversed;
+                    reversed = next;
+                }
+                return count;
+            }
+
+            bool empty() const
+            {
+                return (m_head.load(std::memory_order_acquire) == nullptr);
+            }
+
+          private:
+            static void deleteNodes(SNode* _node)
+            {
+                while (_node != nullptr)
+                {
+                    SNode* next = _node->m_next;
+                    delete _node;
+                    _node = next;
+                }
+            }
+
+          private:
+            std::atomic<SNode*> m_head{ nullptr };
+        };
+    } // namespace protocol_api
+} // namespace dds
+
+#endif /* defined(__DDS__MPSCQueue__) */
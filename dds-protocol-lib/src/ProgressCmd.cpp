@@ -42,7 +42,7 @@ bool SProgressCmd::operator==(const SProgressCmd& val) const
             m_time == val.m_time && m_srcCommand == val.m_srcCommand);
 }
 
-void SProgressCmd::_convertFromData(const BYTEVector_t& _data)
+void SProgressCmd::_convertFromData(const SByteView& _data)
 {
     SAttachmentDataProvider(_data).get(m_completed).get(m_total).get(m_errors).get(m_time).get(m_srcCommand);
 }
@@ -16,7 +16,21 @@
 // In the future we might want to support backward compatibility. In this case protocol version, command will be
 // organized in separate structures and enums.
 //
-const uint16_t g_protocolCommandsVersion = 5;
+// Optional features are negotiated by the commands version exchanged during the handshake:
+// 6 - cmdBATCH
+// 7 - cmdCOMPRESSED
+// 8 - values of cmdUPDATE_KEY and cmdCUSTOM_CMD exceeding 2^16 symbols
+// 9 - cmdASSIGN_USER_TASKS
+// 10 - cmdCHECK_CACHED_FILES, file cache of agents
+// 11 - cmdSUBSCRIBE_ON_TASK_DONE, agents get cmdUSER_TASK_DONE only if their tasks subscribed on it
+//
+const uint16_t g_protocolCommandsVersion = 11;
+const uint16_t g_protocolCommandsVersionBatch = 6;
+const uint16_t g_protocolCommandsVersionCompression = 7;
+const uint16_t g_protocolCommandsVersionLargeValues = 8;
+const uint16_t g_protocolCommandsVersionAssignUserTasks = 9;
+const uint16_t g_protocolCommandsVersionFileCache = 10;
+const uint16_t g_protocolCommandsVersionTaskDoneSubscription = 11;
 
 namespace dds
 {
@@ -66,7 +80,19 @@ namespace dds
             cmdGET_IDLE_AGENTS_COUNT,
             cmdREPLY_IDLE_AGENTS_COUNT, // attachment: SSimpleMsgCmd
             cmdADD_SLOT,                // attachment: SIDCmd
-            cmdREPLY_ADD_SLOT           // attachment: SUUIDCmd
+            cmdREPLY_ADD_SLOT,          // attachment: SUUIDCmd
+            cmdBATCH,                   // attachment: SBatchCmd. Packs several messages into one frame.
+            cmdCOMPRESSED,              // no attachment, see CProtocolMessage::encodeCompressed
+            // this command assigns and activates user tasks of several slots of an agent
+            cmdASSIGN_USER_TASKS,       // attachment: SAssignUserTasksCmd
+            cmdREPLY_ASSIGN_USER_TASKS, // attachment: SSlotRepliesCmd
+            // this command asks an agent which files of the given content hashes are missing in its file cache
+            cmdCHECK_CACHED_FILES,       // attachment: SCachedFilesCmd
+            cmdREPLY_CHECK_CACHED_FILES, // attachment: SCachedFilesCmd
+            // a user task subscribes on cmdUSER_TASK_DONE at its agent, the agent subscribes at the commander once
+            // its first slot subscribes and unsubscribes once no slot is subscribed anymore
+            cmdSUBSCRIBE_ON_TASK_DONE,
+            cmdUNSUBSCRIBE_ON_TASK_DONE
         };
 
         static std::map<uint16_t, std::string> g_cmdToString{
@@ -110,7 +136,15 @@ namespace dds
             { cmdGET_IDLE_AGENTS_COUNT, NAME_TO_STRING(cmdGET_IDLE_AGENT_COUNT) },
             { cmdREPLY_IDLE_AGENTS_COUNT, NAME_TO_STRING(cmdREPLY_IDLE_AGENT_COUNT) },
             { cmdADD_SLOT, NAME_TO_STRING(cmdADD_SLOT) },
-            { cmdREPLY_ADD_SLOT, NAME_TO_STRING(cmdREPLY_ADD_SLOT) }
+            { cmdREPLY_ADD_SLOT, NAME_TO_STRING(cmdREPLY_ADD_SLOT) },
+            { cmdBATCH, NAME_TO_STRING(cmdBATCH) },
+            { cmdCOMPRESSED, NAME_TO_STRING(cmdCOMPRESSED) },
+            { cmdASSIGN_USER_TASKS, NAME_TO_STRING(cmdASSIGN_USER_TASKS) },
+            { cmdREPLY_ASSIGN_USER_TASKS, NAME_TO_STRING(cmdREPLY_ASSIGN_USER_TASKS) },
+            { cmdCHECK_CACHED_FILES, NAME_TO_STRING(cmdCHECK_CACHED_FILES) },
+            { cmdREPLY_CHECK_CACHED_FILES, NAME_TO_STRING(cmdREPLY_CHECK_CACHED_FILES) },
+            { cmdSUBSCRIBE_ON_TASK_DONE, NAME_TO_STRING(cmdSUBSCRIBE_ON_TASK_DONE) },
+            { cmdUNSUBSCRIBE_ON_TASK_DONE, NAME_TO_STRING(cmdUNSUBSCRIBE_ON_TASK_DONE) }
         };
     } // namespace protocol_api
 } // namespace dds
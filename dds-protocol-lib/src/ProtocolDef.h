@@ -5,7 +5,10 @@
 #ifndef __DDS__ProtocolDef__
 #define __DDS__ProtocolDef__
 
-// DDS
+// STD
+#include <array>
+#include <string>
+#include <vector>
 
 namespace dds
 {
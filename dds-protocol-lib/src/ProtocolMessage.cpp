@@ -3,6 +3,7 @@
 //
 //
 #include "ProtocolMessage.h"
+#include "Compression.h"
 #include "HexView.h"
 #include "INet.h"
 #include "ProtocolCommands.h"
@@ -15,18 +16,98 @@ using namespace dds::misc::INet;
 
 CProtocolMessage::CProtocolMessage()
     : m_data(header_length)
+    , m_isLargeValueFormat(false)
 {
 }
 
 CProtocolMessage::CProtocolMessage(uint16_t _cmd, const BYTEVector_t& _data, uint64_t _ID)
     : m_data(header_length)
+    , m_isLargeValueFormat(false)
 {
     encode(_cmd, _data, _ID);
 }
 
+CProtocolMessage::CProtocolMessage(uint16_t _cmd, sharedBodyPtr_t _body, uint64_t _ID)
+    : m_data(header_length)
+    , m_isLargeValueFormat(false)
+{
+    encode(_cmd, _body, _ID);
+}
+
+void CProtocolMessage::encode(uint16_t _cmd, sharedBodyPtr_t _body, uint64_t _ID)
+{
+    if (_body == nullptr)
+        throw invalid_argument("CProtocolMessage: shared message body can't be empty");
+
+    m_data.resize(header_length);
+    m_sharedBody = move(_body);
+    _encode_header(_cmd, static_cast<uint32_t>(m_sharedBody->size()), _ID);
+}
+
+// Command and body length of the original message precede the compressed body
+static const size_t compressedPrefixLength = sizeof(uint16_t) + sizeof(uint32_t);
+// zlib doesn't compress better than 1032:1
+static const size_t maxCompressionRatio = 1032;
+
+bool CProtocolMessage::encodeCompressed(const CProtocolMessage& _msg, int _level)
+{
+    m_sharedBody.reset();
+    m_data.resize(header_length + compressedPrefixLength + compressedSizeBound(_msg.body_length()));
+    const size_t compressedLength = compressData(_msg.body(),
+                                                 _msg.body_length(),
+                                                 &m_data[header_length + compressedPrefixLength],
+                                                 m_data.size() - header_length - compressedPrefixLength,
+                                                 _level);
+    if (compressedPrefixLength + compressedLength >= _msg.body_length())
+    {
+        clear();
+        return false;
+    }
+
+    const uint16_t cmd = normalizeWrite(_msg.header().m_cmd);
+    const uint32_t len = normalizeWrite(static_cast<uint32_t>(_msg.body_length()));
+    memcpy(&m_data[header_length], &cmd, sizeof(cmd));
+    memcpy(&m_data[header_length + sizeof(cmd)], &len, sizeof(len));
+    m_data.resize(header_length + compressedPrefixLength + compressedLength);
+    _encode_header(cmdCOMPRESSED, static_cast<uint32_t>(compressedPrefixLength + compressedLength), _msg.header().m_ID);
+    m_isLargeValueFormat = _msg.isLargeValueFormat();
+    return true;
+}
+
+void CProtocolMessage::decodeCompressed(const CProtocolMessage& _msg)
+{
+    if (_msg.header().m_cmd != cmdCOMPRESSED || _msg.body_length() < compressedPrefixLength)
+        throw runtime_error("CProtocolMessage: bad compressed message");
+
+    uint16_t cmd(0);
+    uint32_t len(0);
+    memcpy(&cmd, _msg.body(), sizeof(cmd));
+    memcpy(&len, _msg.body() + sizeof(cmd), sizeof(len));
+    cmd = normalizeRead(cmd);
+    len = normalizeRead(len);
+
+    const size_t compressedLength = _msg.body_length() - compressedPrefixLength;
+    if (len > max_decompressed_body_length || len > compressedLength * maxCompressionRatio)
+    {
+        stringstream ss;
+        ss << "CProtocolMessage: bad compressed message. Length of the original message " << len
+           << " is too big for the compressed length " << compressedLength;
+        throw runtime_error(ss.str());
+    }
+
+    m_sharedBody.reset();
+    m_data.resize(header_length + len);
+    // Throws unless exactly len bytes are uncompressed
+    uncompressData(_msg.body() + compressedPrefixLength, compressedLength, m_data.data() + header_length, len);
+    _encode_header(cmd, len, _msg.header().m_ID);
+    m_isLargeValueFormat = _msg.isLargeValueFormat();
+}
+
 void CProtocolMessage::clear()
 {
     m_header.clear();
+    m_sharedBody.reset();
+    m_isLargeValueFormat = false;
     m_data.clear();
     m_data.resize(header_length);
 }
@@ -36,6 +117,16 @@ void CProtocolMessage::resize(size_t _size)
     m_data.resize(_size);
 }
 
+void CProtocolMessage::reserve(size_t _size)
+{
+    m_data.reserve(_size);
+}
+
+size_t CProtocolMessage::capacity() const
+{
+    return m_data.capacity();
+}
+
 const CProtocolMessage::data_t* CProtocolMessage::data() const
 {
     return &m_data[0];
@@ -53,11 +144,14 @@ size_t CProtocolMessage::length() const
 
 const CProtocolMessage::data_t* CProtocolMessage::body() const
 {
-    return &m_data[header_length];
+    return (m_sharedBody != nullptr) ? m_sharedBody->data() : &m_data[header_length];
 }
 
 CProtocolMessage::data_t* CProtocolMessage::body()
 {
+    // A shared body is immutable
+    if (m_sharedBody != nullptr)
+        throw runtime_error("CProtocolMessage: can't modify a shared message body");
     return &m_data[header_length];
 }
 
@@ -105,11 +199,21 @@ bool CProtocolMessage::decode_header()
     return true;
 }
 
-void CProtocolMessage::_encode_message(uint16_t _cmd, const CProtocolMessage::dataContainer_t& _data, uint64_t _ID)
+void CProtocolMessage::_encode_message(uint16_t _cmd, const data_t* _body, size_t _size, uint64_t _ID)
+{
+    m_sharedBody.reset();
+
+    m_data.resize(header_length);
+    m_data.insert(m_data.end(), _body, _body + _size);
+
+    _encode_header(_cmd, static_cast<uint32_t>(_size), _ID);
+}
+
+void CProtocolMessage::_encode_header(uint16_t _cmd, uint32_t _len, uint64_t _ID)
 {
     // local copy
     m_header.m_cmd = _cmd;
-    m_header.m_len = static_cast<uint32_t>(_data.size());
+    m_header.m_len = _len;
     m_header.m_ID = _ID;
     m_header.m_crc = m_header.getChecksum();
 
@@ -120,10 +224,7 @@ void CProtocolMessage::_encode_message(uint16_t _cmd, const CProtocolMessage::da
     header.m_len = normalizeWrite(m_header.m_len);
     header.m_ID = normalizeWrite(m_header.m_ID);
 
-    BYTEVector_t ret_val(header_length);
-    memcpy(&ret_val[0], reinterpret_cast<unsigned char*>(&header), header_length);
-    copy(_data.begin(), _data.end(), back_inserter(ret_val));
-    swap(m_data, ret_val);
+    memcpy(&m_data[0], reinterpret_cast<unsigned char*>(&header), header_length);
 }
 
 const SMessageHeader& CProtocolMessage::header() const
@@ -137,14 +238,9 @@ string CProtocolMessage::toString() const
     ss << "[" << g_cmdToString[m_header.m_cmd] << "] "
        << "ID: " << m_header.m_ID << "; CRC: " << m_header.m_crc << "; data size (header+body): " << length() << "\n";
     static const size_t maxDataSize = 128;
-    if (m_data.size() > maxDataSize)
-    {
-        dataContainer_t tmp_data(m_data.begin(), m_data.begin() + maxDataSize);
-        ss << BYTEVectorHexView_t(tmp_data);
-    }
-    else
-    {
-        ss << BYTEVectorHexView_t(m_data);
-    }
+    const size_t dataSize = min(maxDataSize, header_length + body_length());
+    dataContainer_t tmp_data(m_data.begin(), m_data.begin() + header_length);
+    tmp_data.insert(tmp_data.end(), body(), body() + (dataSize - header_length));
+    ss << BYTEVectorHexView_t(tmp_data);
     return ss.str();
 }
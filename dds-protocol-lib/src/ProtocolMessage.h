@@ -9,6 +9,7 @@
 // STD
 #include <cstring>
 #include <memory>
+#include <type_traits>
 // BOOST
 #include <boost/crc.hpp>
 
@@ -79,6 +80,9 @@ namespace dds
             typedef dds::misc::BYTEVector_t dataContainer_t;
             typedef dataContainer_t::value_type data_t;
             typedef std::shared_ptr<CProtocolMessage> protocolMessagePtr_t;
+            /// An immutable, reference-counted message body. It is shared between messages of a broadcast, which
+            /// differ only in their headers.
+            typedef std::shared_ptr<const dataContainer_t> sharedBodyPtr_t;
 
             enum
             {
@@ -88,24 +92,77 @@ namespace dds
             {
                 header_length = sizeof(SMessageHeader)
             };
-            /*  enum
-              {
-                  max_body_length = 512
-              };*/
+            enum
+            {
+                /// Max body length of a decompressed message. The length of the original message is announced by the
+                /// remote end, it must not make us allocate arbitrary amounts of memory.
+                max_decompressed_body_length = 256 * 1024 * 1024
+            };
 
           public:
             CProtocolMessage();
 
             CProtocolMessage(uint16_t _cmd, const dds::misc::BYTEVector_t& _data, uint64_t _ID);
 
+            CProtocolMessage(uint16_t _cmd, sharedBodyPtr_t _body, uint64_t _ID);
+
+            /// \brief Encodes the given command attachment directly into the message buffer.
+            template <class A,
+                      typename = decltype(std::declval<const A&>().convertToData(
+                          std::declval<dds::misc::BYTEVector_t*>()))>
+            CProtocolMessage(uint16_t _cmd, const A& _attachment, uint64_t _ID)
+                : m_isLargeValueFormat(false)
+            {
+                encodeAttachment(_cmd, _attachment, _ID);
+            }
+
           public:
             void encode(uint16_t _cmd, const dds::misc::BYTEVector_t& _data, uint64_t _ID)
             {
-                _encode_message(_cmd, _data, _ID);
+                _encode_message(_cmd, _data.data(), _data.size(), _ID);
             }
 
+            void encode(uint16_t _cmd, const data_t* _body, size_t _size, uint64_t _ID)
+            {
+                _encode_message(_cmd, _body, _size, _ID);
+            }
+
+            /// \brief Encodes the message referencing the given body instead of copying it.
+            /// \note Such message keeps only the header in its own buffer, i.e. data() points to the header and the
+            /// body is available via body(). Stream channels send both parts using scatter/gather I/O.
+            void encode(uint16_t _cmd, sharedBodyPtr_t _body, uint64_t _ID);
+
+            /// \brief Encodes the given command attachment directly into the message buffer.
+            /// \details The size of the message is calculated up front. The buffer is allocated once and the header and
+            /// all fields of the attachment are serialized in place, without intermediate containers.
+            template <class A>
+            void encodeAttachment(uint16_t _cmd, const A& _attachment, uint64_t _ID)
+            {
+                m_sharedBody.reset();
+                m_data.clear();
+                m_data.reserve(header_length + _attachment.size());
+                m_data.resize(header_length);
+                // The attachment appends its fields after the header
+                _attachment.convertToData(&m_data);
+                _encode_header(_cmd, static_cast<uint32_t>(m_data.size() - header_length), _ID);
+                m_isLargeValueFormat = _attachment.hasLargeValues();
+            }
+
+            /// \brief Encodes the given message as a compressed cmdCOMPRESSED message.
+            /// \details The body of a compressed message consists of the command (2 bytes) and the body length (4
+            /// bytes) of the original message followed by its zlib compressed body. The ID is taken over.
+            /// \return false if the compressed message wouldn't be smaller than the original one. The message is
+            /// cleared then.
+            bool encodeCompressed(const CProtocolMessage& _msg, int _level);
+            /// \brief Decodes the original message from the given cmdCOMPRESSED message.
+            /// \throw std::runtime_error if the compressed message is corrupted or the original message would exceed
+            /// max_decompressed_body_length.
+            void decodeCompressed(const CProtocolMessage& _msg);
+
             void clear();
             void resize(size_t _size); // FIXME: Used in tests to allocate memory for m_data.
+            void reserve(size_t _size);
+            size_t capacity() const;
             const data_t* data() const;
             data_t* data();
             size_t length() const;
@@ -114,6 +171,21 @@ namespace dds
             size_t body_length() const;
             bool decode_header();
             const SMessageHeader& header() const;
+            bool hasSharedBody() const
+            {
+                return (m_sharedBody != nullptr);
+            }
+            /// \brief True if the body is serialized in the large value format.
+            /// \details Senders mark messages with large values, such messages can be sent only to remote ends with
+            /// large value support. Receivers mark all messages from remote ends with large value support.
+            bool isLargeValueFormat() const
+            {
+                return m_isLargeValueFormat;
+            }
+            void setLargeValueFormat(bool _isLargeValueFormat)
+            {
+                m_isLargeValueFormat = _isLargeValueFormat;
+            }
             std::string toString() const;
             dataContainer_t bodyToContainer() const
             {
@@ -122,11 +194,14 @@ namespace dds
             }
 
           private:
-            void _encode_message(uint16_t _cmd, const dataContainer_t& _data, uint64_t _ID);
+            void _encode_message(uint16_t _cmd, const data_t* _body, size_t _size, uint64_t _ID);
+            void _encode_header(uint16_t _cmd, uint32_t _len, uint64_t _ID);
 
           private:
             dataContainer_t m_data; /// the whole data buffer, which includes the header and the msg body
             SMessageHeader m_header;
+            sharedBodyPtr_t m_sharedBody; /// the msg body shared with other messages (optional)
+            bool m_isLargeValueFormat;    /// the body is serialized in the large value format
         };
     } // namespace protocol_api
 } // namespace dds
@@ -0,0 +1,119 @@
+// Copyright 2014 GSI, Inc. All rights reserved.
+//
+//
+//
+#include "ProtocolMessagePool.h"
+#include "INet.h"
+// STD
+#include <algorithm>
+
+using namespace dds;
+using namespace dds::protocol_api;
+using namespace std;
+using namespace dds::misc::INet;
+
+// Small control messages, typical commands, binary attachment chunks (64 KiB of data plus the command fields) and big
+// messages like topology updates
+const array<size_t, CProtocolMessagePool::nofSizeClasses> CProtocolMessagePool::m_sizeClasses = {
+    512, 8192, 65536 + 1024, 1024 * 1024
+};
+
+// Limits the memory kept by each size class of the pool
+static const size_t maxFreeBytesPerSizeClass = 1024 * 1024;
+static const size_t maxFreeMessagesPerSizeClass = 64;
+
+CProtocolMessagePool::ptr_t CProtocolMessagePool::makeNew()
+{
+    return ptr_t(new CProtocolMessagePool());
+}
+
+CProtocolMessage::protocolMessagePtr_t CProtocolMessagePool::acquire(size_t _length)
+{
+    auto iter = lower_bound(m_sizeClasses.begin(), m_sizeClasses.end(), _length);
+    if (iter == m_sizeClasses.end())
+    {
+        // The message is too big to be pooled
+        ++m_misses;
+        auto msg = make_shared<CProtocolMessage>();
+        msg->reserve(_length);
+        return msg;
+    }
+
+    const size_t sizeClass = distance(m_sizeClasses.begin(), iter);
+    unique_ptr<CProtocolMessage> msg;
+    {
+        lock_guard<mutex> lock(m_mutex);
+        messageVector_t& freeMessages = m_freeMessages[sizeClass];
+        if (!freeMessages.empty())
+        {
+            msg = move(freeMessages.back());
+            freeMessages.pop_back();
+        }
+    }
+
+    if (msg)
+    {
+        ++m_hits;
+    }
+    else
+    {
+        ++m_misses;
+        msg = make_unique<CProtocolMessage>();
+        msg->reserve(m_sizeClasses[sizeClass]);
+    }
+
+    // The pool might be destroyed before the message is released
+    weak_ptr<CProtocolMessagePool> pool(shared_from_this());
+    return CProtocolMessage::protocolMessagePtr_t(msg.release(),
+                                                  [pool](CProtocolMessage* _msg)
+                                                  {
+                                                      if (auto p = pool.lock())
+                                                          p->release(_msg);
+                                                      else
+                                                          delete _msg;
+                                                  });
+}
+
+CProtocolMessage::protocolMessagePtr_t CProtocolMessagePool::acquire(const CProtocolMessage::data_t* _header)
+{
+    SMessageHeader header;
+    memcpy(&header, _header, CProtocolMessage::header_length);
+
+    CProtocolMessage::protocolMessagePtr_t msg = acquire(CProtocolMessage::header_length + normalizeRead(header.m_len));
+    memcpy(msg->data(), _header, CProtocolMessage::header_length);
+    msg->decode_header();
+    return msg;
+}
+
+CProtocolMessagePool::SStats CProtocolMessagePool::getStats() const
+{
+    SStats stats;
+    stats.m_hits = m_hits;
+    stats.m_misses = m_misses;
+    return stats;
+}
+
+void CProtocolMessagePool::release(CProtocolMessage* _msg)
+{
+    unique_ptr<CProtocolMessage> msg(_msg);
+    // The buffer keeps its capacity
+    msg->clear();
+
+    // Don't keep buffers of messages, which are too big to be pooled
+    if (msg->capacity() > m_sizeClasses.back())
+        return;
+
+    // Find the biggest size class the message fits into
+    auto iter = upper_bound(m_sizeClasses.begin(), m_sizeClasses.end(), msg->capacity());
+    if (iter == m_sizeClasses.begin())
+        return;
+
+    const size_t sizeClass = distance(m_sizeClasses.begin(), iter) - 1;
+    const size_t maxFreeMessages =
+        max<size_t>(1, min(maxFreeMessagesPerSizeClass, maxFreeBytesPerSizeClass / m_sizeClasses[sizeClass]));
+
+    lock_guard<mutex> lock(m_mutex);
+    messageVector_t& freeMessages = m_freeMessages[sizeClass];
+    if (freeMessages.size() < maxFreeMessages)
+        freeMessages.push_back(move(msg));
+}
@@ -0,0 +1,76 @@
+// Copyright 2014 GSI, Inc. All rights reserved.
+//
+//
+//
+#ifndef __DDS__ProtocolMessagePool__
+#define __DDS__ProtocolMessagePool__
+// DDS
+#include "ProtocolMessage.h"
+// STD
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+// BOOST
+#include <boost/noncopyable.hpp>
+
+namespace dds
+{
+    namespace protocol_api
+    {
+        ///
+        /// \brief Pool of protocol messages used on the read path of channels.
+        /// \details Messages are grouped into size classes by the capacity of their buffers. A message acquired from
+        /// the pool is returned to its size class, once the last reference to it is released. Messages bigger than
+        /// the largest size class are not pooled.
+        ///
+        class CProtocolMessagePool : public std::enable_shared_from_this<CProtocolMessagePool>,
+                                     private boost::noncopyable
+        {
+          public:
+            typedef std::shared_ptr<CProtocolMessagePool> ptr_t;
+
+            struct SStats
+            {
+                uint64_t m_hits{ 0 };   ///< Number of messages taken from the pool
+                uint64_t m_misses{ 0 }; ///< Number of messages allocated, because the pool had no suitable message
+            };
+
+          private:
+            CProtocolMessagePool() = default;
+
+          public:
+            static ptr_t makeNew();
+
+            /// \brief Returns a message, which buffer can hold at least _length bytes (header and body).
+            CProtocolMessage::protocolMessagePtr_t acquire(size_t _length);
+            /// \brief Returns a message for the given received header.
+            /// \details The header is copied into the message and decoded. The buffer of the message is large enough
+            /// to receive the body without reallocation.
+            /// \throw std::runtime_error if the header is bad or corrupted.
+            CProtocolMessage::protocolMessagePtr_t acquire(const CProtocolMessage::data_t* _header);
+
+            SStats getStats() const;
+
+          private:
+            void release(CProtocolMessage* _msg);
+
+          private:
+            enum
+            {
+                nofSizeClasses = 4
+            };
+            typedef std::vector<std::unique_ptr<CProtocolMessage>> messageVector_t;
+
+            static const std::array<size_t, nofSizeClasses> m_sizeClasses;
+
+            std::mutex m_mutex;
+            std::array<messageVector_t, nofSizeClasses> m_freeMessages;
+            std::atomic<uint64_t> m_hits{ 0 };
+            std::atomic<uint64_t> m_misses{ 0 };
+        };
+    } // namespace protocol_api
+} // namespace dds
+
+#endif /* defined(__DDS__ProtocolMessagePool__) */
@@ -36,7 +36,7 @@ bool SReplyCmd::operator==(const SReplyCmd& val) const
             m_srcCommand == val.m_srcCommand);
 }
 
-void SReplyCmd::_convertFromData(const BYTEVector_t& _data)
+void SReplyCmd::_convertFromData(const SByteView& _data)
 {
     SAttachmentDataProvider(_data).get(m_statusCode).get(m_returnCode).get(m_srcCommand).get(m_sMsg);
 }
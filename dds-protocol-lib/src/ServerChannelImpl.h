@@ -42,10 +42,29 @@ namespace dds
                         this->template pushMsg<cmdUNKNOWN>();
 
                         // everything is OK, we can work with this agent
-                        LOG(dds::misc::info) << "[" << this->socket().remote_endpoint().address().to_string()
-                                             << "] has successfully connected.";
-
-                        this->template pushMsg<cmdREPLY_HANDSHAKE_OK>(_sender.m_ID);
+                        LOG(dds::misc::info) << "[" << this->remoteAddress() << "] has successfully connected.";
+
+                        this->setRemoteCommandsVersion(_attachment->m_commandsVersion);
+                        if (_attachment->m_commandsVersion >= g_protocolCommandsVersionBatch)
+                        {
+                            // The client can receive batch frames. The reply is packed into a batch frame, which tells
+                            // the client, that the server can receive them as well. The reply carries the version of
+                            // the server, thus the client knows which other features are supported.
+                            SVersionCmd version;
+                            version.m_version = DDS_PROTOCOL_VERSION;
+                            version.m_channelType = _attachment->m_channelType;
+                            version.m_sSID = this->m_sessionID;
+                            dds::misc::BYTEVector_t versionData;
+                            version.convertToData(&versionData);
+
+                            SBatchCmd batch;
+                            batch.add(cmdREPLY_HANDSHAKE_OK, _sender.m_ID, SByteView(versionData));
+                            this->template pushMsg<cmdBATCH>(batch, _sender.m_ID);
+                        }
+                        else
+                        {
+                            this->template pushMsg<cmdREPLY_HANDSHAKE_OK>(_sender.m_ID);
+                        }
 
                         // notify all subscribers about the event
                         this->dispatchHandlers(EChannelEvents::OnHandshakeOK, _sender);
@@ -0,0 +1,139 @@
+// Copyright 2014 GSI, Inc. All rights reserved.
+//
+//
+//
+#include "SharedBinaryAttachment.h"
+#include "CRC.h"
+#include "SysHelper.h"
+// STD
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+// BOOST
+#include <boost/crc.hpp>
+
+using namespace std;
+using namespace dds;
+using namespace dds::protocol_api;
+using namespace dds::misc;
+
+namespace
+{
+    string makeContentHash(uint64_t _crc64, uint64_t _size)
+    {
+        stringstream ss;
+        ss << hex << setw(16) << setfill('0') << _crc64 << "-" << dec << _size;
+        return ss.str();
+    }
+} // namespace
+
+SSharedBinaryAttachment::ptr_t SSharedBinaryAttachment::makeFromFile(const string& _filePath)
+{
+    string filePath(_filePath);
+    // Resolve environment variables
+    smart_path(&filePath);
+
+    ifstream f(filePath, ios::binary);
+    if (!f.is_open() || !f.good())
+    {
+        throw runtime_error("Could not open the source file: " + filePath);
+    }
+
+    auto attachment = make_shared<SSharedBinaryAttachment>();
+    f.seekg(0, ios::end);
+    attachment->m_data.resize(f.tellg());
+    f.seekg(0, ios::beg);
+    if (!f.read(reinterpret_cast<char*>(attachment->m_data.data()), attachment->m_data.size()))
+    {
+        throw runtime_error("Could not read the source file: " + filePath);
+    }
+
+    attachment->split();
+    return attachment;
+}
+
+SSharedBinaryAttachment::ptr_t SSharedBinaryAttachment::makeFromData(BYTEVector_t _data)
+{
+    auto attachment = make_shared<SSharedBinaryAttachment>();
+    attachment->m_data = move(_data);
+    attachment->split();
+    return attachment;
+}
+
+uint32_t SSharedBinaryAttachment::size() const
+{
+    return static_cast<uint32_t>(m_data.size());
+}
+
+size_t SSharedBinaryAttachment::nofPieces() const
+{
+    return m_pieceCrc32.size();
+}
+
+SByteView SSharedBinaryAttachment::piece(uint32_t _offset) const
+{
+    return SByteView(m_data.data() + _offset, min<size_t>(maxPieceSize, m_data.size() - _offset));
+}
+
+uint32_t SSharedBinaryAttachment::pieceCrc32(uint32_t _offset) const
+{
+    return m_pieceCrc32.at(_offset / maxPieceSize);
+}
+
+string SSharedBinaryAttachment::contentHash() const
+{
+    crc_optimal_64_t crc64;
+    crc64.process_bytes(m_data.data(), m_data.size());
+    return makeContentHash(crc64.checksum(), m_data.size());
+}
+
+string SSharedBinaryAttachment::fileContentHash(const string& _filePath)
+{
+    ifstream f(_filePath, ios::binary);
+    if (!f.is_open() || !f.good())
+    {
+        throw runtime_error("Could not open the file: " + _filePath);
+    }
+
+    const uint64_t crc64{ dds::misc::crc64(f) };
+    f.clear();
+    f.seekg(0, ios::end);
+    return makeContentHash(crc64, f.tellg());
+}
+
+bool SSharedBinaryAttachment::isContentHash(const string& _hash)
+{
+    // CRC64 in lowercase hex, the size in decimal digits
+    const size_t crcLength = 16;
+    const size_t maxSizeLength = numeric_limits<uint64_t>::digits10 + 1;
+    if (_hash.size() <= crcLength + 1 || _hash.size() > crcLength + 1 + maxSizeLength || _hash[crcLength] != '-')
+        return false;
+
+    const auto sizeBegin = _hash.begin() + crcLength + 1;
+    return all_of(_hash.begin(),
+                  _hash.begin() + crcLength,
+                  [](char _c) { return (_c >= '0' && _c <= '9') || (_c >= 'a' && _c <= 'f'); }) &&
+           all_of(sizeBegin, _hash.end(), [](char _c) { return _c >= '0' && _c <= '9'; });
+}
+
+void SSharedBinaryAttachment::split()
+{
+    if (m_data.size() > numeric_limits<uint32_t>::max())
+        throw runtime_error("Binary attachment size can't exceed 2^32 bytes. Size: " + to_string(m_data.size()));
+
+    boost::crc_32_type crc32;
+    crc32.process_bytes(m_data.data(), m_data.size());
+    m_crc32 = crc32.checksum();
+
+    m_pieceCrc32.clear();
+    m_pieceCrc32.reserve(m_data.size() / maxPieceSize + 1);
+    for (uint32_t offset = 0; offset < m_data.size(); offset += maxPieceSize)
+    {
+        const SByteView data(piece(offset));
+        boost::crc_32_type pieceCrc32;
+        pieceCrc32.process_bytes(data.data(), data.size());
+        m_pieceCrc32.push_back(pieceCrc32.checksum());
+    }
+}
@@ -0,0 +1,59 @@
+// Copyright 2014 GSI, Inc. All rights reserved.
+//
+//
+//
+#ifndef __DDS__SharedBinaryAttachment__
+#define __DDS__SharedBinaryAttachment__
+// DDS
+#include "BasicCmd.h"
+// STD
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dds
+{
+    namespace protocol_api
+    {
+        ///
+        /// \brief Binary attachment, which is read, split into pieces and checksummed only once.
+        /// \details The attachment is immutable and can be shared by all channels sending it, e.g. when a topology file
+        /// is broadcasted to all agents.
+        ///
+        struct SSharedBinaryAttachment
+        {
+            typedef std::shared_ptr<const SSharedBinaryAttachment> ptr_t;
+
+            static constexpr uint32_t maxPieceSize = 65536;
+
+            /// \throw std::runtime_error if the file can't be read.
+            static ptr_t makeFromFile(const std::string& _filePath);
+            static ptr_t makeFromData(dds::misc::BYTEVector_t _data);
+
+            uint32_t size() const;
+            size_t nofPieces() const;
+            /// \brief Piece of binary data at the given offset. The offset must be a multiple of maxPieceSize.
+            SByteView piece(uint32_t _offset) const;
+            /// \brief CRC32 of the piece at the given offset.
+            uint32_t pieceCrc32(uint32_t _offset) const;
+            /// \brief Content address of the attachment, which names it in the file cache of agents.
+            /// \details CRC64 and size of the content. It is computed on each call.
+            std::string contentHash() const;
+            /// \brief Content address of the given file, same as contentHash of the attachment made from it.
+            /// \throw std::runtime_error if the file can't be read.
+            static std::string fileContentHash(const std::string& _filePath);
+            /// \brief True if the string has the format of a content hash, 16 hex digits of CRC64, "-" and the size.
+            /// \details Hashes received from the remote end name files, they must be checked before they are used.
+            static bool isContentHash(const std::string& _hash);
+
+            dds::misc::BYTEVector_t m_data;     ///< Content of the attachment
+            std::vector<uint32_t> m_pieceCrc32; ///< CRC32 checksums of the pieces
+            uint32_t m_crc32{ 0 };              ///< CRC32 checksum of the whole attachment
+
+          private:
+            void split();
+        };
+    } // namespace protocol_api
+} // namespace dds
+
+#endif /* defined(__DDS__SharedBinaryAttachment__) */
@@ -33,7 +33,7 @@ bool SSimpleMsgCmd::operator==(const SSimpleMsgCmd& val) const
     return (m_sMsg == val.m_sMsg && m_msgSeverity == val.m_msgSeverity && m_srcCommand == val.m_srcCommand);
 }
 
-void SSimpleMsgCmd::_convertFromData(const BYTEVector_t& _data)
+void SSimpleMsgCmd::_convertFromData(const SByteView& _data)
 {
     SAttachmentDataProvider(_data).get(m_msgSeverity).get(m_srcCommand).get(m_sMsg);
 }
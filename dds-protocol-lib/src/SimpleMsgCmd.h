@@ -18,7 +18,7 @@ namespace dds
             SSimpleMsgCmd();
             SSimpleMsgCmd(const std::string& _msg, uint16_t _severity = dds::misc::info, uint16_t _command = 0);
             size_t size() const;
-            void _convertFromData(const dds::misc::BYTEVector_t& _data);
+            void _convertFromData(const SByteView& _data);
             void _convertToData(dds::misc::BYTEVector_t* _data) const;
             bool operator==(const SSimpleMsgCmd& val) const;
 
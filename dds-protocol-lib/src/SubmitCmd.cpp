@@ -25,7 +25,7 @@ bool SSubmitCmd::operator==(const SSubmitCmd& val) const
             m_nNumberOfAgents == val.m_nNumberOfAgents);
 }
 
-void SSubmitCmd::_convertFromData(const BYTEVector_t& _data)
+void SSubmitCmd::_convertFromData(const SByteView& _data)
 {
     SAttachmentDataProvider(_data).get(m_sRMSType).get(m_sCfgFile).get(m_sPath).get(m_nNumberOfAgents);
 }
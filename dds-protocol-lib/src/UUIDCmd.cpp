@@ -24,7 +24,7 @@ bool SIDCmd::operator==(const SIDCmd& _val) const
     return (m_id == _val.m_id);
 }
 
-void SIDCmd::_convertFromData(const BYTEVector_t& _data)
+void SIDCmd::_convertFromData(const SByteView& _data)
 {
     SAttachmentDataProvider(_data).get(m_id);
 }
@@ -17,7 +17,7 @@ SUpdateKeyCmd::SUpdateKeyCmd()
 
 size_t SUpdateKeyCmd::size() const
 {
-    return dsize(m_propertyName) + dsize(m_value) + dsize(m_senderTaskID) + dsize(m_receiverTaskID);
+    return dsize(m_propertyName) + dsizeLargeValue(m_value) + dsize(m_senderTaskID) + dsize(m_receiverTaskID);
 }
 
 bool SUpdateKeyCmd::operator==(const SUpdateKeyCmd& val) const
@@ -26,14 +26,19 @@ bool SUpdateKeyCmd::operator==(const SUpdateKeyCmd& val) const
             m_receiverTaskID == val.m_receiverTaskID);
 }
 
-void SUpdateKeyCmd::_convertFromData(const BYTEVector_t& _data)
+bool SUpdateKeyCmd::hasLargeValues() const
 {
-    SAttachmentDataProvider(_data).get(m_propertyName).get(m_value).get(m_senderTaskID).get(m_receiverTaskID);
+    return isLargeValue(m_value);
+}
+
+void SUpdateKeyCmd::_convertFromData(const SByteView& _data)
+{
+    SAttachmentDataProvider(_data).get(m_propertyName).getLargeValue(m_value).get(m_senderTaskID).get(m_receiverTaskID);
 }
 
 void SUpdateKeyCmd::_convertToData(BYTEVector_t* _data) const
 {
-    SAttachmentDataProvider(_data).put(m_propertyName).put(m_value).put(m_senderTaskID).put(m_receiverTaskID);
+    SAttachmentDataProvider(_data).put(m_propertyName).putLargeValue(m_value).put(m_senderTaskID).put(m_receiverTaskID);
 }
 
 std::ostream& dds::protocol_api::operator<<(std::ostream& _stream, const SUpdateKeyCmd& val)
@@ -16,9 +16,11 @@ namespace dds
 
             SUpdateKeyCmd();
             size_t size() const;
-            void _convertFromData(const dds::misc::BYTEVector_t& _data);
+            void _convertFromData(const SByteView& _data);
             void _convertToData(dds::misc::BYTEVector_t* _data) const;
             bool operator==(const SUpdateKeyCmd& val) const;
+            /// \brief The value can exceed 2^16 symbols if the remote end supports large values.
+            bool hasLargeValues() const;
 
             std::string m_propertyName;
             std::string m_value;
@@ -27,7 +27,7 @@ bool SUpdateTopologyCmd::operator==(const SUpdateTopologyCmd& val) const
             m_updateType == val.m_updateType);
 }
 
-void SUpdateTopologyCmd::_convertFromData(const dds::misc::BYTEVector_t& _data)
+void SUpdateTopologyCmd::_convertFromData(const SByteView& _data)
 {
     SAttachmentDataProvider(_data).get(m_nDisableValidation).get(m_sTopologyFile).get(m_updateType);
 }
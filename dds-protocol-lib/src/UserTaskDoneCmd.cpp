@@ -25,7 +25,7 @@ bool SUserTaskDoneCmd::operator==(const SUserTaskDoneCmd& val) const
     return (m_exitCode == val.m_exitCode) && (m_taskID == val.m_taskID);
 }
 
-void SUserTaskDoneCmd::_convertFromData(const BYTEVector_t& _data)
+void SUserTaskDoneCmd::_convertFromData(const SByteView& _data)
 {
     SAttachmentDataProvider(_data).get(m_exitCode).get(m_taskID);
 }
@@ -16,7 +16,7 @@ namespace dds
         {
             SUserTaskDoneCmd();
             size_t size() const;
-            void _convertFromData(const dds::misc::BYTEVector_t& _data);
+            void _convertFromData(const SByteView& _data);
             void _convertToData(dds::misc::BYTEVector_t* _data) const;
             bool operator==(const SUserTaskDoneCmd& val) const;
 
@@ -14,32 +14,40 @@ using namespace dds::misc;
 SVersionCmd::SVersionCmd()
     : m_version(g_protocolCommandsVersion)
     , m_channelType(0)
+    , m_commandsVersion(g_protocolCommandsVersion)
 {
 }
 
 size_t SVersionCmd::size() const
 {
-    return dsize(m_sSID) + dsize(m_version) + dsize(m_channelType);
+    return dsize(m_sSID) + dsize(m_version) + dsize(m_channelType) + dsize(m_commandsVersion);
 }
 
 bool SVersionCmd::operator==(const SVersionCmd& val) const
 {
-    return (m_sSID == val.m_sSID) && (m_version == val.m_version) && (m_channelType == val.m_channelType);
+    return (m_sSID == val.m_sSID) && (m_version == val.m_version) && (m_channelType == val.m_channelType) &&
+           (m_commandsVersion == val.m_commandsVersion);
 }
 
-void SVersionCmd::_convertFromData(const BYTEVector_t& _data)
+void SVersionCmd::_convertFromData(const SByteView& _data)
 {
-    SAttachmentDataProvider(_data).get(m_sSID).get(m_version).get(m_channelType);
+    SAttachmentDataProvider provider(_data);
+    provider.get(m_sSID).get(m_version).get(m_channelType);
+    // Old peers don't send the commands version
+    m_commandsVersion = 0;
+    if (!provider.eof())
+        provider.get(m_commandsVersion);
 }
 
 void SVersionCmd::_convertToData(BYTEVector_t* _data) const
 {
-    SAttachmentDataProvider(_data).put(m_sSID).put(m_version).put(m_channelType);
+    SAttachmentDataProvider(_data).put(m_sSID).put(m_version).put(m_channelType).put(m_commandsVersion);
 }
 
 std::ostream& dds::protocol_api::operator<<(std::ostream& _stream, const SVersionCmd& val)
 {
-    return _stream << "SID: " << val.m_sSID << " ver: " << val.m_version << " type: " << val.m_channelType;
+    return _stream << "SID: " << val.m_sSID << " ver: " << val.m_version << " type: " << val.m_channelType
+                   << " commands ver: " << val.m_commandsVersion;
 }
 
 bool dds::protocol_api::operator!=(const SVersionCmd& lhs, const SVersionCmd& rhs)
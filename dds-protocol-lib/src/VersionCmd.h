@@ -18,13 +18,16 @@ namespace dds
         {
             SVersionCmd();
             size_t size() const;
-            void _convertFromData(const dds::misc::BYTEVector_t& _data);
+            void _convertFromData(const SByteView& _data);
             void _convertToData(dds::misc::BYTEVector_t* _data) const;
             bool operator==(const SVersionCmd& val) const;
 
             std::string m_sSID; /// Session ID
             uint16_t m_version;
             uint16_t m_channelType;
+            /// Version of protocol commands supported by the sender, see g_protocolCommandsVersion. Optional, peers
+            /// which don't send it have version 0.
+            uint16_t m_commandsVersion;
         };
         std::ostream& operator<<(std::ostream& _stream, const SVersionCmd& val);
         bool operator!=(const SVersionCmd& lhs, const SVersionCmd& rhs);
@@ -0,0 +1,113 @@
+// Copyright 2014 GSI, Inc. All rights reserved.
+//
+//
+//
+#include "WriteQueueMonitor.h"
+
+using namespace std;
+using namespace dds;
+using namespace dds::protocol_api;
+
+void CWriteQueueMonitor::setLimits(const SWriteQueueLimits& _limits)
+{
+    m_highWatermarkBytes = _limits.m_highWatermarkBytes;
+    m_lowWatermarkBytes = _limits.m_lowWatermarkBytes;
+    m_highWatermarkMsgs = _limits.m_highWatermarkMsgs;
+    m_lowWatermarkMsgs = _limits.m_lowWatermarkMsgs;
+    m_maxBytes = _limits.m_maxBytes;
+    updateCongestion(m_nofMessages, m_nofBytes);
+}
+
+SWriteQueueLimits CWriteQueueMonitor::getLimits() const
+{
+    SWriteQueueLimits limits;
+    limits.m_highWatermarkBytes = m_highWatermarkBytes;
+    limits.m_lowWatermarkBytes = m_lowWatermarkBytes;
+    limits.m_highWatermarkMsgs = m_highWatermarkMsgs;
+    limits.m_lowWatermarkMsgs = m_lowWatermarkMsgs;
+    limits.m_maxBytes = m_maxBytes;
+    return limits;
+}
+
+bool CWriteQueueMonitor::add(size_t _msgSize)
+{
+    // Reserve the space first, thus concurrent producers can't exceed the limit together
+    const size_t nofBytes = m_nofBytes.fetch_add(_msgSize, memory_order_relaxed) + _msgSize;
+    const size_t maxBytes = m_maxBytes.load(memory_order_relaxed);
+    if (maxBytes != 0 && nofBytes > maxBytes)
+    {
+        m_nofBytes.fetch_sub(_msgSize, memory_order_relaxed);
+        ++m_nofRejected;
+        return false;
+    }
+
+    const size_t nofMessages = m_nofMessages.fetch_add(1, memory_order_relaxed) + 1;
+    updateMax(m_maxNofMessages, nofMessages);
+    updateMax(m_maxNofBytes, nofBytes);
+    updateCongestion(nofMessages, nofBytes);
+    return true;
+}
+
+void CWriteQueueMonitor::remove(size_t _msgSize)
+{
+    const size_t nofMessages = m_nofMessages.fetch_sub(1, memory_order_relaxed) - 1;
+    const size_t nofBytes = m_nofBytes.fetch_sub(_msgSize, memory_order_relaxed) - _msgSize;
+    updateCongestion(nofMessages, nofBytes);
+}
+
+void CWriteQueueMonitor::drop()
+{
+    ++m_nofDropped;
+}
+
+bool CWriteQueueMonitor::isCongested() const
+{
+    return m_isCongested.load(memory_order_relaxed);
+}
+
+SWriteQueueStats CWriteQueueMonitor::getStats() const
+{
+    SWriteQueueStats stats;
+    stats.m_nofMessages = m_nofMessages;
+    stats.m_nofBytes = m_nofBytes;
+    stats.m_maxNofMessages = m_maxNofMessages;
+    stats.m_maxNofBytes = m_maxNofBytes;
+    stats.m_nofDropped = m_nofDropped;
+    stats.m_nofRejected = m_nofRejected;
+    stats.m_nofCongestions = m_nofCongestions;
+    stats.m_isCongested = m_isCongested;
+    return stats;
+}
+
+bool CWriteQueueMonitor::takeCongestionChange(bool& _isCongested)
+{
+    _isCongested = m_isCongested.load(memory_order_relaxed);
+    return (m_isCongestionReported.exchange(_isCongested, memory_order_relaxed) != _isCongested);
+}
+
+void CWriteQueueMonitor::updateCongestion(size_t _nofMessages, size_t _nofBytes)
+{
+    if (!m_isCongested.load(memory_order_relaxed))
+    {
+        if (_nofMessages >= m_highWatermarkMsgs.load(memory_order_relaxed) ||
+            _nofBytes >= m_highWatermarkBytes.load(memory_order_relaxed))
+        {
+            // Only one of concurrent callers counts the congestion
+            if (!m_isCongested.exchange(true, memory_order_relaxed))
+                ++m_nofCongestions;
+        }
+    }
+    else if (_nofMessages <= m_lowWatermarkMsgs.load(memory_order_relaxed) &&
+             _nofBytes <= m_lowWatermarkBytes.load(memory_order_relaxed))
+    {
+        m_isCongested.store(false, memory_order_relaxed);
+    }
+}
+
+void CWriteQueueMonitor::updateMax(atomic<size_t>& _max, size_t _value)
+{
+    size_t max = _max.load(memory_order_relaxed);
+    while (max < _value && !_max.compare_exchange_weak(max, _value, memory_order_relaxed))
+    {
+    }
+}
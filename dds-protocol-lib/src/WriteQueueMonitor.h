@@ -0,0 +1,92 @@
+// Copyright 2014 GSI, Inc. All rights reserved.
+//
+//
+//
+#ifndef __DDS__WriteQueueMonitor__
+#define __DDS__WriteQueueMonitor__
+// STD
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace dds
+{
+    namespace protocol_api
+    {
+        /// \brief Limits of the outgoing messages of a channel.
+        /// \details A channel becomes congested, once one of the high watermarks is reached, and stays congested, until
+        /// both the number of queued messages and the number of queued bytes fall to the low watermarks.
+        struct SWriteQueueLimits
+        {
+            size_t m_highWatermarkBytes{ 32 * 1024 * 1024 };
+            size_t m_lowWatermarkBytes{ 16 * 1024 * 1024 };
+            size_t m_highWatermarkMsgs{ 100000 };
+            size_t m_lowWatermarkMsgs{ 50000 };
+            size_t m_maxBytes{ 512 * 1024 * 1024 }; ///< Messages beyond this limit are rejected, 0 - no limit
+        };
+
+        /// \brief Snapshot of the outgoing messages of a channel.
+        struct SWriteQueueStats
+        {
+            size_t m_nofMessages{ 0 };      ///< Number of queued and not yet sent messages
+            size_t m_nofBytes{ 0 };         ///< Size of queued and not yet sent messages
+            size_t m_maxNofMessages{ 0 };   ///< Peak number of queued messages
+            size_t m_maxNofBytes{ 0 };      ///< Peak size of queued messages
+            uint64_t m_nofDropped{ 0 };     ///< Number of coalescible messages dropped under pressure
+            uint64_t m_nofRejected{ 0 };    ///< Number of messages rejected, because the queue overflowed
+            uint64_t m_nofCongestions{ 0 }; ///< How many times the high watermark was reached
+            bool m_isCongested{ false };
+        };
+
+        ///
+        /// \brief Accounts outgoing messages of a channel and signals backpressure.
+        /// \details All functions are thread-safe and lock-free. Messages are accounted by the producers and removed
+        /// by the writer of the channel concurrently, thus getStats() returns a snapshot of counters, which might be
+        /// updated in between.
+        ///
+        class CWriteQueueMonitor
+        {
+          public:
+            void setLimits(const SWriteQueueLimits& _limits);
+            SWriteQueueLimits getLimits() const;
+
+            /// \brief Accounts a message, which is about to be queued.
+            /// \return false if the message would exceed the maximum size of the queue. It's not accounted then.
+            bool add(size_t _msgSize);
+            /// \brief Accounts a message, which was sent or removed from the queue.
+            void remove(size_t _msgSize);
+            /// \brief Accounts a coalescible message, which was dropped instead of being queued.
+            void drop();
+
+            bool isCongested() const;
+            SWriteQueueStats getStats() const;
+            /// \brief Returns true once per change of the congestion state, e.g. to report it.
+            /// \param[out] _isCongested The current congestion state.
+            bool takeCongestionChange(bool& _isCongested);
+
+          private:
+            void updateCongestion(size_t _nofMessages, size_t _nofBytes);
+            static void updateMax(std::atomic<size_t>& _max, size_t _value);
+
+          private:
+            // Limits
+            std::atomic<size_t> m_highWatermarkBytes{ SWriteQueueLimits().m_highWatermarkBytes };
+            std::atomic<size_t> m_lowWatermarkBytes{ SWriteQueueLimits().m_lowWatermarkBytes };
+            std::atomic<size_t> m_highWatermarkMsgs{ SWriteQueueLimits().m_highWatermarkMsgs };
+            std::atomic<size_t> m_lowWatermarkMsgs{ SWriteQueueLimits().m_lowWatermarkMsgs };
+            std::atomic<size_t> m_maxBytes{ SWriteQueueLimits().m_maxBytes };
+            // Stats
+            std::atomic<size_t> m_nofMessages{ 0 };
+            std::atomic<size_t> m_nofBytes{ 0 };
+            std::atomic<size_t> m_maxNofMessages{ 0 };
+            std::atomic<size_t> m_maxNofBytes{ 0 };
+            std::atomic<uint64_t> m_nofDropped{ 0 };
+            std::atomic<uint64_t> m_nofRejected{ 0 };
+            std::atomic<uint64_t> m_nofCongestions{ 0 };
+            std::atomic<bool> m_isCongested{ false };
+            std::atomic<bool> m_isCongestionReported{ false };
+        };
+    } // namespace protocol_api
+} // namespace dds
+
+#endif /* defined(__DDS__WriteQueueMonitor__) */
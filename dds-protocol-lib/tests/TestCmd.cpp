@@ -40,7 +40,7 @@ bool STestCmd::operator==(const STestCmd& val) const
             m_vuint64 == val.m_vuint64 && m_vstring1 == val.m_vstring1 && m_vstring2 == val.m_vstring2);
 }
 
-void STestCmd::_convertFromData(const BYTEVector_t& _data)
+void STestCmd::_convertFromData(const SByteView& _data)
 {
     SAttachmentDataProvider(_data)
         .get(m_uint16)
@@ -14,7 +14,7 @@ namespace dds
     {
         STestCmd();
         size_t size() const;
-        void _convertFromData(const dds::misc::BYTEVector_t& _data);
+        void _convertFromData(const protocol_api::SByteView& _data);
         void _convertToData(dds::misc::BYTEVector_t* _data) const;
         bool operator==(const STestCmd& val) const;
 
@@ -0,0 +1,721 @@
+// Copyright 2014 GSI, Inc. All rights reserved.
+//
+//
+//
+
+// BOOST: tests
+// Defines test_main function to link with actual unit test code.
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+// API
+#include <sys/socket.h>
+// BOOST
+#include <boost/asio.hpp>
+#include <boost/log/core.hpp>
+// DDS
+#include "ClientChannelImpl.h"
+#include "CoalescingWindow.h"
+#include "CommandAttachmentImpl.h"
+#include "MPSCQueue.h"
+#include "ProtocolMessagePool.h"
+#include "TimeMeasure.h"
+// STD
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+
+using namespace std;
+using namespace dds;
+using namespace dds::protocol_api;
+using namespace dds::misc;
+
+// Count heap allocations of the test process
+static atomic<size_t> g_nofAllocations{ 0 };
+static atomic<size_t> g_allocatedBytes{ 0 };
+
+void* operator new(size_t _size)
+{
+    ++g_nofAllocations;
+    g_allocatedBytes += _size;
+    if (void* p = malloc(_size))
+        return p;
+    throw bad_alloc();
+}
+
+void operator delete(void* _p) noexcept
+{
+    free(_p);
+}
+
+void operator delete(void* _p, size_t /*_size*/) noexcept
+{
+    free(_p);
+}
+
+struct SBenchmarkResult
+{
+    size_t m_nofAllocations{ 0 };
+    size_t m_allocatedBytes{ 0 };
+    chrono::microseconds::rep m_time{ 0 };
+};
+
+template <typename F>
+SBenchmarkResult benchmark(F _func)
+{
+    SBenchmarkResult result;
+    const size_t nofAllocations = g_nofAllocations;
+    const size_t allocatedBytes = g_allocatedBytes;
+    result.m_time = STimeMeasure<chrono::microseconds>::execution(_func);
+    result.m_nofAllocations = g_nofAllocations - nofAllocations;
+    result.m_allocatedBytes = g_allocatedBytes - allocatedBytes;
+    return result;
+}
+
+template <ECmdType _cmd, class A>
+void benchmarkBroadcast(const A& _attachment, size_t _nofRecipients, size_t _nofBroadcasts)
+{
+    vector<CProtocolMessage::protocolMessagePtr_t> messages;
+    messages.reserve(_nofRecipients);
+
+    // Before: the attachment is encoded for each recipient
+    SBenchmarkResult perRecipient = benchmark(
+        [&]()
+        {
+            for (size_t i = 0; i < _nofBroadcasts; ++i)
+            {
+                messages.clear();
+                for (size_t id = 1; id <= _nofRecipients; ++id)
+                    messages.push_back(SCommandAttachmentImpl<_cmd>::encode(_attachment, id));
+            }
+        });
+
+    // After: the attachment is encoded once, recipients get only own headers
+    SBenchmarkResult encodeOnce = benchmark(
+        [&]()
+        {
+            for (size_t i = 0; i < _nofBroadcasts; ++i)
+            {
+                messages.clear();
+                CProtocolMessage::sharedBodyPtr_t body = SCommandAttachmentImpl<_cmd>::encodeBody(_attachment);
+                for (size_t id = 1; id <= _nofRecipients; ++id)
+                    messages.push_back(SCommandAttachmentImpl<_cmd>::encode(body, id));
+            }
+        });
+
+    cout << g_cmdToString[_cmd] << " (" << _attachment.size() << " bytes) broadcast to " << _nofRecipients
+         << " recipients:\n"
+         << "  encode per recipient: " << perRecipient.m_time / _nofBroadcasts << " usec, "
+         << perRecipient.m_nofAllocations / _nofBroadcasts << " allocations ("
+         << perRecipient.m_allocatedBytes / _nofBroadcasts << " bytes) per broadcast\n"
+         << "  encode once:          " << encodeOnce.m_time / _nofBroadcasts << " usec, "
+         << encodeOnce.m_nofAllocations / _nofBroadcasts << " allocations ("
+         << encodeOnce.m_allocatedBytes / _nofBroadcasts << " bytes) per broadcast\n";
+
+    BOOST_CHECK(encodeOnce.m_allocatedBytes < perRecipient.m_allocatedBytes);
+}
+
+template <ECmdType _cmd, class A>
+void benchmarkEncode(const A& _attachment, size_t _nofMessages)
+{
+    vector<CProtocolMessage::protocolMessagePtr_t> messages;
+    messages.reserve(_nofMessages);
+
+    // Before: the attachment is serialized into a temporary container, which is then copied into the message
+    SBenchmarkResult twoStep = benchmark(
+        [&]()
+        {
+            for (size_t id = 1; id <= _nofMessages; ++id)
+            {
+                BYTEVector_t data;
+                _attachment.convertToData(&data);
+                messages.push_back(make_shared<CProtocolMessage>(_cmd, data, id));
+            }
+        });
+    messages.clear();
+
+    // After: the header and the attachment are serialized in place into a preallocated message buffer
+    SBenchmarkResult inPlace = benchmark(
+        [&]()
+        {
+            for (size_t id = 1; id <= _nofMessages; ++id)
+                messages.push_back(SCommandAttachmentImpl<_cmd>::encode(_attachment, id));
+        });
+
+    cout << g_cmdToString[_cmd] << " (" << _attachment.size() << " bytes) encoding of " << _nofMessages
+         << " messages:\n"
+         << "  temporary container: " << twoStep.m_time << " usec, "
+         << static_cast<double>(twoStep.m_nofAllocations) / _nofMessages << " allocations per message\n"
+         << "  in place:            " << inPlace.m_time << " usec, "
+         << static_cast<double>(inPlace.m_nofAllocations) / _nofMessages << " allocations per message\n";
+
+    BOOST_CHECK(inPlace.m_nofAllocations < twoStep.m_nofAllocations);
+}
+
+template <ECmdType _cmd, class A>
+void benchmarkDecode(const A& _attachment, size_t _nofMessages)
+{
+    CProtocolMessage::protocolMessagePtr_t msg = SCommandAttachmentImpl<_cmd>::encode(_attachment, 1);
+    size_t nofBytes(0);
+
+    // Before: the body is copied into a temporary container, which is then read field by field
+    SBenchmarkResult copy = benchmark(
+        [&]()
+        {
+            for (size_t i = 0; i < _nofMessages; ++i)
+            {
+                A cmd;
+                cmd.convertFromData(msg->bodyToContainer());
+                nofBytes += cmd.size();
+            }
+        });
+
+    // After: the attachment is decoded directly from the message buffer
+    SBenchmarkResult view = benchmark(
+        [&]()
+        {
+            for (size_t i = 0; i < _nofMessages; ++i)
+                nofBytes += SCommandAttachmentImpl<_cmd>::decode(msg)->size();
+        });
+
+    cout << g_cmdToString[_cmd] << " (" << _attachment.size() << " bytes) decoding of " << _nofMessages
+         << " messages:\n"
+         << "  body copy: " << copy.m_time << " usec, " << copy.m_allocatedBytes / _nofMessages
+         << " bytes allocated per message\n"
+         << "  body view: " << view.m_time << " usec, " << view.m_allocatedBytes / _nofMessages
+         << " bytes allocated per message\n";
+
+    BOOST_CHECK(nofBytes == 2 * _nofMessages * _attachment.size());
+    BOOST_CHECK(view.m_allocatedBytes < copy.m_allocatedBytes);
+}
+
+template <ECmdType _cmd, class A>
+void benchmarkReceive(const A& _attachment, size_t _nofMessages)
+{
+    CProtocolMessage::protocolMessagePtr_t srcMsg = SCommandAttachmentImpl<_cmd>::encode(_attachment, 1);
+    size_t nofBytes(0);
+
+    // Imitates the read path of a channel: the header is received, then the body into the buffer of the message
+    auto receive = [&](CProtocolMessage::protocolMessagePtr_t _msg)
+    {
+        memcpy(_msg->body(), srcMsg->body(), srcMsg->body_length());
+        nofBytes += _msg->length();
+    };
+
+    // Before: a new message is allocated for each received header
+    SBenchmarkResult allocate = benchmark(
+        [&]()
+        {
+            for (size_t i = 0; i < _nofMessages; ++i)
+            {
+                CProtocolMessage::protocolMessagePtr_t msg = make_shared<CProtocolMessage>();
+                memcpy(msg->data(), srcMsg->data(), CProtocolMessage::header_length);
+                msg->decode_header();
+                receive(msg);
+            }
+        });
+
+    // After: messages are recycled by the pool
+    CProtocolMessagePool::ptr_t pool = CProtocolMessagePool::makeNew();
+    SBenchmarkResult pooled = benchmark(
+        [&]()
+        {
+            for (size_t i = 0; i < _nofMessages; ++i)
+                receive(pool->acquire(srcMsg->data()));
+        });
+
+    CProtocolMessagePool::SStats stats = pool->getStats();
+    cout << g_cmdToString[_cmd] << " (" << srcMsg->length() << " bytes) receiving of " << _nofMessages
+         << " messages:\n"
+         << "  allocate: " << allocate.m_time << " usec, "
+         << static_cast<double>(allocate.m_nofAllocations) / _nofMessages << " allocations per message\n"
+         << "  pooled:   " << pooled.m_time << " usec, "
+         << static_cast<double>(pooled.m_nofAllocations) / _nofMessages << " allocations per message ("
+         << stats.m_hits << " hits, " << stats.m_misses << " misses)\n";
+
+    BOOST_CHECK(nofBytes == 2 * _nofMessages * srcMsg->length());
+    BOOST_CHECK(stats.m_hits == _nofMessages - 1);
+    BOOST_CHECK(stats.m_misses == 1);
+    BOOST_CHECK(pooled.m_nofAllocations < allocate.m_nofAllocations);
+}
+
+// Coalescing of accumulated messages before: every message restarts a 1 s timer and the accumulated messages are sent
+// once there are more than 10000 of them
+struct SFixedCoalescingWindow
+{
+    bool add(uint16_t /*_cmd*/, size_t /*_msgSize*/, bool /*_isLinkIdle*/, CCoalescingWindow::clock_t::time_point _now)
+    {
+        m_deadline = _now + chrono::seconds(1);
+        return (++m_nofMsgs > 10000);
+    }
+    void reset()
+    {
+        m_nofMsgs = 0;
+    }
+    CCoalescingWindow::clock_t::time_point deadline() const
+    {
+        return m_deadline;
+    }
+
+    size_t m_nofMsgs{ 0 };
+    CCoalescingWindow::clock_t::time_point m_deadline;
+};
+
+struct SCoalescingResult
+{
+    double m_avgLatency{ 0 }; // [usec]
+    size_t m_nofWrites{ 0 };
+};
+
+// Imitates the accumulative write path of a channel in virtual time. Messages arrive at a fixed interval, only one
+// write is in flight at a time and each write takes _writeTime.
+template <class W>
+SCoalescingResult simulateCoalescing(W& _window,
+                                     bool _sendOnWriteCompletion,
+                                     size_t _msgSize,
+                                     size_t _nofMsgs,
+                                     chrono::microseconds _interval,
+                                     chrono::microseconds _writeTime)
+{
+    typedef CCoalescingWindow::clock_t::time_point timePoint_t;
+    const timePoint_t never = timePoint_t::max();
+    const timePoint_t start;
+
+    vector<timePoint_t> accumulated; // arrival times of held back messages
+    vector<timePoint_t> writeQueue;
+    timePoint_t writeDone = never;
+    size_t nofArrived(0);
+    double totalLatency(0);
+    SCoalescingResult result;
+
+    auto flush = [&]()
+    {
+        writeQueue.insert(writeQueue.end(), accumulated.begin(), accumulated.end());
+        accumulated.clear();
+        _window.reset();
+    };
+
+    while (nofArrived < _nofMsgs || !accumulated.empty() || writeDone != never)
+    {
+        const timePoint_t arrival = (nofArrived < _nofMsgs) ? start + _interval * static_cast<int64_t>(nofArrived) : never;
+        const timePoint_t deadline = accumulated.empty() ? never : _window.deadline();
+        const timePoint_t now = min({ arrival, deadline, writeDone });
+        if (now == writeDone)
+        {
+            writeDone = never;
+            if (_sendOnWriteCompletion)
+                flush();
+        }
+        else if (now == deadline)
+        {
+            flush();
+        }
+        else
+        {
+            ++nofArrived;
+            accumulated.push_back(now);
+            if (_window.add(cmdUPDATE_KEY, _msgSize, writeDone == never, now))
+                flush();
+        }
+
+        // Start the next write
+        if (writeDone == never && !writeQueue.empty())
+        {
+            ++result.m_nofWrites;
+            writeDone = now + _writeTime;
+            for (const auto& t : writeQueue)
+                totalLatency += chrono::duration_cast<chrono::microseconds>(writeDone - t).count();
+            writeQueue.clear();
+        }
+    }
+
+    result.m_avgLatency = totalLatency / _nofMsgs;
+    return result;
+}
+
+void benchmarkCoalescing(const SUpdateKeyCmd& _cmd, size_t _nofMsgs, chrono::microseconds _writeTime)
+{
+    const size_t msgSize = SCommandAttachmentImpl<cmdUPDATE_KEY>::encode(_cmd, 1)->length();
+    cout << g_cmdToString[cmdUPDATE_KEY] << " (" << msgSize << " bytes) propagation of " << _nofMsgs << " messages, "
+         << _writeTime.count() << " usec per write:\n";
+
+    for (const auto interval : { 1, 10, 100, 1000, 10000 })
+    {
+        SFixedCoalescingWindow fixedWindow;
+        SCoalescingResult fixed =
+            simulateCoalescing(fixedWindow, false, msgSize, _nofMsgs, chrono::microseconds(interval), _writeTime);
+
+        CCoalescingWindow adaptiveWindow;
+        SCoalescingResult adaptive =
+            simulateCoalescing(adaptiveWindow, true, msgSize, _nofMsgs, chrono::microseconds(interval), _writeTime);
+
+        cout << "  a message every " << interval << " usec:\n"
+             << "    fixed:    " << fixed.m_avgLatency << " usec average latency, "
+             << static_cast<double>(_nofMsgs) / fixed.m_nofWrites << " messages per write\n"
+             << "    adaptive: " << adaptive.m_avgLatency << " usec average latency, "
+             << static_cast<double>(_nofMsgs) / adaptive.m_nofWrites << " messages per write\n";
+
+        // A message waits at most for the deadline of its batch, the write in flight and its own write
+        const SCoalescingPolicy& policy = adaptiveWindow.getPolicy(cmdUPDATE_KEY);
+        BOOST_CHECK(adaptive.m_avgLatency <= (policy.m_maxLatency + 2 * _writeTime).count());
+        BOOST_CHECK(adaptive.m_avgLatency < fixed.m_avgLatency);
+        // Messages are still batched under high load
+        if (chrono::microseconds(interval) < _writeTime)
+            BOOST_CHECK(adaptive.m_nofWrites < _nofMsgs / 2);
+    }
+}
+
+// Producers push messages concurrently, while one consumer thread drains the queue, like the writer of a channel
+template <class P, class C>
+chrono::microseconds::rep benchmarkProducers(size_t _nofProducers, size_t _nofMsgs, P _push, C _popAll)
+{
+    const CProtocolMessage::protocolMessagePtr_t msg = make_shared<CProtocolMessage>();
+    return STimeMeasure<chrono::microseconds>::execution(
+        [&]()
+        {
+            thread consumer(
+                [&]()
+                {
+                    size_t nofReceived(0);
+                    while (nofReceived < _nofProducers * _nofMsgs)
+                        nofReceived += _popAll();
+                });
+
+            vector<thread> producers;
+            for (size_t i = 0; i < _nofProducers; ++i)
+                producers.emplace_back(
+                    [&]()
+                    {
+                        for (size_t j = 0; j < _nofMsgs; ++j)
+                            _push(msg);
+                    });
+            for (auto& producer : producers)
+                producer.join();
+            consumer.join();
+        });
+}
+
+void benchmarkWriteQueue(size_t _nofProducers, size_t _nofMsgs)
+{
+    cout << "Write queue with " << _nofProducers << " producers, " << _nofMsgs << " messages each:\n";
+
+    // Before: producers and the writer lock the write queue, the writer fills the write buffer under the lock
+    mutex mtx;
+    deque<CProtocolMessage::protocolMessagePtr_t> mutexQueue;
+    vector<boost::asio::const_buffer> writeBuffer;
+    auto mutexTime = benchmarkProducers(
+        _nofProducers,
+        _nofMsgs,
+        [&](const CProtocolMessage::protocolMessagePtr_t& _msg)
+        {
+            lock_guard<mutex> lock(mtx);
+            mutexQueue.push_back(_msg);
+        },
+        [&]()
+        {
+            lock_guard<mutex> lock(mtx);
+            for (const auto& msg : mutexQueue)
+                writeBuffer.push_back(boost::asio::buffer(msg->data(), msg->length()));
+            const size_t size = mutexQueue.size();
+            mutexQueue.clear();
+            writeBuffer.clear();
+            return size;
+        });
+
+    // After: producers push write requests without locks, the writer takes all of them at once
+    CMPSCQueue<CProtocolMessage::protocolMessagePtr_t> lockFreeQueue;
+    auto lockFreeTime = benchmarkProducers(
+        _nofProducers,
+        _nofMsgs,
+        [&](const CProtocolMessage::protocolMessagePtr_t& _msg) { lockFreeQueue.push(_msg); },
+        [&]()
+        {
+            const size_t size =
+                lockFreeQueue.popAll([&](CProtocolMessage::protocolMessagePtr_t& _msg)
+                                     { writeBuffer.push_back(boost::asio::buffer(_msg->data(), _msg->length())); });
+            writeBuffer.clear();
+            return size;
+        });
+
+    cout << "  mutex:     " << mutexTime << " usec\n"
+         << "  lock-free: " << lockFreeTime << " usec\n";
+
+    BOOST_CHECK(mutexQueue.empty());
+    BOOST_CHECK(lockFreeQueue.empty());
+}
+
+class CBenchmarkChannel : public CClientChannelImpl<CBenchmarkChannel>
+{
+    CBenchmarkChannel(boost::asio::io_context& _service, uint64_t _protocolHeaderID)
+        : CClientChannelImpl<CBenchmarkChannel>(_service, EChannelType::AGENT, _protocolHeaderID)
+    {
+    }
+
+    REGISTER_DEFAULT_REMOTE_ID_STRING
+
+  public:
+    BEGIN_MSG_MAP(CBenchmarkChannel)
+        MESSAGE_HANDLER_DISPATCH(cmdCUSTOM_CMD)
+    END_MSG_MAP()
+
+  public:
+    /// \brief Skips the handshake, the remote end supports all features.
+    void setHandshakeOK()
+    {
+        m_isHandshakeOK = true;
+        setRemoteCommandsVersion(g_protocolCommandsVersion);
+    }
+};
+
+struct STransportResult
+{
+    double m_msgsPerSec{ 0 };
+    chrono::microseconds::rep m_p99Latency{ 0 };
+};
+
+uint64_t nowNs()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// \brief Connections of the server side run either on one io_context shared by all threads, like the commander does
+/// by default, or on one io_context per thread assigned round-robin, like with server.io_context_per_thread. Each
+/// connection keeps _window messages in flight: the handler of a message on the server side sends the next one. The
+/// client ends run on an own shared io_context, which is the same for both models.
+STransportResult benchmarkTransport(
+    bool _isPerThread, size_t _nofThreads, size_t _nofConnections, size_t _nofMsgs, size_t _window)
+{
+    typedef boost::asio::executor_work_guard<boost::asio::io_context::executor_type> workGuard_t;
+
+    vector<shared_ptr<boost::asio::io_context>> serverContexts;
+    for (size_t i = 0; i < (_isPerThread ? _nofThreads : 1); ++i)
+        serverContexts.push_back(make_shared<boost::asio::io_context>(_isPerThread ? 1 : _nofThreads));
+    boost::asio::io_context clientContext;
+
+    const size_t nofMsgsPerConnection = _nofMsgs / _nofConnections;
+    const size_t nofMsgs = nofMsgsPerConnection * _nofConnections;
+    atomic<size_t> nofReceived{ 0 };
+    // Handlers of one connection don't run concurrently, each connection has own counters and latencies
+    vector<size_t> nofSent(_nofConnections, 0);
+    vector<vector<uint64_t>> latencies(_nofConnections);
+
+    vector<CBenchmarkChannel::connectionPtr_t> clients;
+    vector<CBenchmarkChannel::connectionPtr_t> servers;
+    const boost::asio::generic::stream_protocol protocol(AF_UNIX, SOCK_STREAM);
+    SCustomCmdCmd cmd;
+    cmd.m_sCmd = string(64, 'c');
+    for (size_t i = 0; i < _nofConnections; ++i)
+    {
+        int fds[2];
+        BOOST_REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+        auto client = CBenchmarkChannel::makeNew(clientContext, 0);
+        auto server = CBenchmarkChannel::makeNew(*serverContexts[i % serverContexts.size()], 0);
+        client->socket().assign(protocol, fds[0]);
+        server->socket().assign(protocol, fds[1]);
+        latencies[i].reserve(nofMsgsPerConnection);
+
+        server->registerHandler<cmdCUSTOM_CMD>(
+            [&, i, client = client.get()](const SSenderInfo& /*_sender*/,
+                                          SCommandAttachmentImpl<cmdCUSTOM_CMD>::ptr_t _attachment)
+            {
+                latencies[i].push_back(nowNs() - _attachment->m_timestamp);
+                if (nofSent[i] < nofMsgsPerConnection)
+                {
+                    SCustomCmdCmd next(cmd);
+                    next.m_timestamp = nowNs();
+                    ++nofSent[i];
+                    client->pushMsg<cmdCUSTOM_CMD>(next);
+                }
+                ++nofReceived;
+            });
+
+        for (auto& channel : { client, server })
+        {
+            channel->setHandshakeOK();
+            channel->start();
+        }
+        clients.push_back(client);
+        servers.push_back(server);
+    }
+
+    vector<workGuard_t> guards;
+    guards.push_back(boost::asio::make_work_guard(clientContext));
+    for (auto& context : serverContexts)
+        guards.push_back(boost::asio::make_work_guard(*context));
+
+    vector<thread> threads;
+    for (size_t i = 0; i < 2; ++i)
+        threads.emplace_back([&clientContext]() { clientContext.run(); });
+    for (size_t i = 0; i < _nofThreads; ++i)
+    {
+        auto context = serverContexts[i % serverContexts.size()];
+        threads.emplace_back([context]() { context->run(); });
+    }
+
+    const auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < _nofConnections; ++i)
+    {
+        // The handler of a connection sends only after the first message of the window is pushed
+        const size_t window = min(_window, nofMsgsPerConnection);
+        nofSent[i] = window;
+        for (size_t j = 0; j < window; ++j)
+        {
+            SCustomCmdCmd next(cmd);
+            next.m_timestamp = nowNs();
+            clients[i]->pushMsg<cmdCUSTOM_CMD>(next);
+        }
+    }
+
+    const auto timeout = start + chrono::seconds(60);
+    while (nofReceived < nofMsgs && chrono::steady_clock::now() < timeout)
+        this_thread::sleep_for(chrono::milliseconds(1));
+    const auto elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+
+    // Channels are closed on their own threads, the threads exit once all pending operations are finished
+    for (auto& channel : clients)
+        boost::asio::post(clientContext, [channel]() { channel->stop(); });
+    for (size_t i = 0; i < _nofConnections; ++i)
+        boost::asio::post(*serverContexts[i % serverContexts.size()], [channel = servers[i]]() { channel->stop(); });
+    guards.clear();
+    for (auto& t : threads)
+        t.join();
+
+    BOOST_REQUIRE_EQUAL(nofReceived, nofMsgs);
+
+    vector<uint64_t> all;
+    all.reserve(nofMsgs);
+    for (const auto& v : latencies)
+        all.insert(all.end(), v.begin(), v.end());
+    auto p99 = all.begin() + all.size() * 99 / 100;
+    nth_element(all.begin(), p99, all.end());
+
+    STransportResult result;
+    result.m_msgsPerSec = nofMsgs * 1000000.0 / max<chrono::microseconds::rep>(elapsed, 1);
+    result.m_p99Latency = *p99 / 1000;
+    return result;
+}
+
+void benchmarkIoModel(size_t _nofThreads, size_t _nofConnections, size_t _nofMsgs, size_t _window)
+{
+    // Channels log each message, the logger isn't initialized and would write everything to the console
+    boost::log::core::get()->set_logging_enabled(false);
+    STransportResult shared = benchmarkTransport(false, _nofThreads, _nofConnections, _nofMsgs, _window);
+    STransportResult perThread = benchmarkTransport(true, _nofThreads, _nofConnections, _nofMsgs, _window);
+    boost::log::core::get()->set_logging_enabled(true);
+
+    cout << _nofMsgs << " messages over " << _nofConnections << " socket pairs, " << _nofThreads << " threads, "
+         << _window << " messages in flight per connection:\n"
+         << "  shared io_context:     " << static_cast<size_t>(shared.m_msgsPerSec)
+         << " msgs/s, p99 handler latency " << shared.m_p99Latency << " usec\n"
+         << "  io_context per thread: " << static_cast<size_t>(perThread.m_msgsPerSec)
+         << " msgs/s, p99 handler latency " << perThread.m_p99Latency << " usec\n";
+}
+
+BOOST_AUTO_TEST_SUITE(test_dds_protocol_performance)
+
+BOOST_AUTO_TEST_CASE(test_dds_protocol_performance_encode_UPDATE_KEY)
+{
+    SUpdateKeyCmd cmd;
+    cmd.m_propertyName = "property_name";
+    cmd.m_value = "property_value_1234567890";
+    cmd.m_senderTaskID = 1234567890;
+    cmd.m_receiverTaskID = 987654321;
+    benchmarkEncode<cmdUPDATE_KEY>(cmd, 100000);
+}
+
+BOOST_AUTO_TEST_CASE(test_dds_protocol_performance_encode_CUSTOM_CMD)
+{
+    SCustomCmdCmd cmd;
+    cmd.m_sCmd = string(4096, 'c');
+    cmd.m_sCondition = "main/group1/collection_0/task_.*";
+    cmd.m_senderId = 1234567890;
+    benchmarkEncode<cmdCUSTOM_CMD>(cmd, 10000);
+}
+
+BOOST_AUTO_TEST_CASE(test_dds_protocol_performance_encode_BINARY_ATTACHMENT)
+{
+    SBinaryAttachmentCmd cmd;
+    cmd.m_data.assign(65536, 'b');
+    cmd.m_size = cmd.m_data.size();
+    benchmarkEncode<cmdBINARY_ATTACHMENT>(cmd, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(test_dds_protocol_performance_decode_BINARY_ATTACHMENT)
+{
+    SBinaryAttachmentCmd cmd;
+    cmd.m_data.assign(65536, 'b');
+    cmd.m_size = cmd.m_data.size();
+    benchmarkDecode<cmdBINARY_ATTACHMENT>(cmd, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(test_dds_protocol_performance_decode_CUSTOM_CMD)
+{
+    SCustomCmdCmd cmd;
+    cmd.m_sCmd = string(4096, 'c');
+    cmd.m_sCondition = "main/group1/collection_0/task_.*";
+    cmd.m_senderId = 1234567890;
+    benchmarkDecode<cmdCUSTOM_CMD>(cmd, 10000);
+}
+
+BOOST_AUTO_TEST_CASE(test_dds_protocol_performance_receive_UPDATE_KEY)
+{
+    SUpdateKeyCmd cmd;
+    cmd.m_propertyName = "property_name";
+    cmd.m_value = "property_value_1234567890";
+    cmd.m_senderTaskID = 1234567890;
+    cmd.m_receiverTaskID = 987654321;
+    benchmarkReceive<cmdUPDATE_KEY>(cmd, 100000);
+}
+
+BOOST_AUTO_TEST_CASE(test_dds_protocol_performance_receive_BINARY_ATTACHMENT)
+{
+    SBinaryAttachmentCmd cmd;
+    cmd.m_data.assign(65536, 'b');
+    cmd.m_size = cmd.m_data.size();
+    benchmarkReceive<cmdBINARY_ATTACHMENT>(cmd, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(test_dds_protocol_performance_coalescing_UPDATE_KEY)
+{
+    SUpdateKeyCmd cmd;
+    cmd.m_propertyName = "property_name";
+    cmd.m_value = "property_value_1234567890";
+    cmd.m_senderTaskID = 1234567890;
+    cmd.m_receiverTaskID = 987654321;
+    benchmarkCoalescing(cmd, 20000, chrono::microseconds(50));
+}
+
+BOOST_AUTO_TEST_CASE(test_dds_protocol_performance_broadcast_USER_TASK_DONE)
+{
+    SUserTaskDoneCmd cmd;
+    cmd.m_exitCode = 1;
+    cmd.m_taskID = 1234567890;
+    benchmarkBroadcast<cmdUSER_TASK_DONE>(cmd, 2000, 20);
+}
+
+BOOST_AUTO_TEST_CASE(test_dds_protocol_performance_broadcast_CUSTOM_CMD)
+{
+    SCustomCmdCmd cmd;
+    cmd.m_sCmd = string(4096, 'c');
+    cmd.m_sCondition = "main/group1/collection_0/task_.*";
+    cmd.m_senderId = 1234567890;
+    benchmarkBroadcast<cmdCUSTOM_CMD>(cmd, 2000, 20);
+}
+
+BOOST_AUTO_TEST_CASE(test_dds_protocol_performance_write_queue_contention)
+{
+    benchmarkWriteQueue(16, 50000);
+}
+
+BOOST_AUTO_TEST_CASE(test_dds_protocol_performance_io_model)
+{
+    benchmarkIoModel(4, 64, 200000, 8);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,273 @@
+// Copyright 2014 GSI, Inc. All rights reserved.
+//
+//
+//
+// Unit tests of channels, which are connected over a socket pair
+//
+// BOOST: tests
+// Defines test_main function to link with actual unit test code.
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+
+// API
+#include <sys/socket.h>
+// BOOST
+#include <boost/asio.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+// STD
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <new>
+
+// DDS
+#include "ClientChannelImpl.h"
+#include "UserDefaults.h"
+
+using namespace std;
+using namespace dds;
+using namespace dds::protocol_api;
+using namespace dds::user_defaults_api;
+namespace fs = boost::filesystem;
+
+// Allocations of at least this size fail, it imitates out of memory in the writer of a channel
+static atomic<size_t> g_failAllocationSize{ numeric_limits<size_t>::max() };
+
+void* operator new(size_t _size)
+{
+    if (_size >= g_failAllocationSize)
+        throw bad_alloc();
+    if (void* p = malloc(_size))
+        return p;
+    throw bad_alloc();
+}
+
+void operator delete(void* _p) noexcept
+{
+    free(_p);
+}
+
+void operator delete(void* _p, size_t /*_size*/) noexcept
+{
+    free(_p);
+}
+
+class CTestChannel : public CClientChannelImpl<CTestChannel>
+{
+    CTestChannel(boost::asio::io_context& _service, uint64_t _protocolHeaderID)
+        : CClientChannelImpl<CTestChannel>(_service, EChannelType::UI, _protocolHeaderID)
+    {
+    }
+
+    REGISTER_DEFAULT_REMOTE_ID_STRING
+
+  public:
+    BEGIN_MSG_MAP(CTestChannel)
+        MESSAGE_HANDLER_DISPATCH(cmdCUSTOM_CMD)
+        MESSAGE_HANDLER_DISPATCH(cmdSIMPLE_MSG)
+        MESSAGE_HANDLER_DISPATCH(cmdBINARY_ATTACHMENT_RECEIVED)
+    END_MSG_MAP()
+
+  public:
+    /// \brief Skips the handshake, the remote end supports all features.
+    void setHandshakeOK()
+    {
+        m_isHandshakeOK = true;
+        setRemoteCommandsVersion(g_protocolCommandsVersion);
+    }
+};
+
+struct SChannelPair
+{
+    SChannelPair()
+        : m_sender(CTestChannel::makeNew(m_ioContext, 0))
+        , m_receiver(CTestChannel::makeNew(m_ioContext, 0))
+    {
+        int fds[2];
+        BOOST_REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+        const boost::asio::generic::stream_protocol protocol(AF_UNIX, SOCK_STREAM);
+        m_sender->socket().assign(protocol, fds[0]);
+        m_receiver->socket().assign(protocol, fds[1]);
+
+        for (auto& channel : { m_sender, m_receiver })
+        {
+            channel->setHandshakeOK();
+            channel->start();
+        }
+
+        m_receiver->registerHandler<cmdCUSTOM_CMD>(
+            [this](const SSenderInfo& /*_sender*/, SCommandAttachmentImpl<cmdCUSTOM_CMD>::ptr_t _attachment)
+            {
+                ++m_nofReceived;
+                m_lastCustomCmd = *_attachment;
+            });
+        m_receiver->registerHandler<EChannelEvents::OnRemoteEndDissconnected>(
+            [this](const SSenderInfo& /*_sender*/) { m_isDisconnected = true; });
+        m_receiver->registerHandler<cmdBINARY_ATTACHMENT_RECEIVED>(
+            [this](const SSenderInfo& /*_sender*/,
+                   SCommandAttachmentImpl<cmdBINARY_ATTACHMENT_RECEIVED>::ptr_t _attachment)
+            { m_receivedFiles.push_back(*_attachment); });
+        m_sender->registerHandler<cmdSIMPLE_MSG>(
+            [this](const SSenderInfo& /*_sender*/, SCommandAttachmentImpl<cmdSIMPLE_MSG>::ptr_t _attachment)
+            { m_senderErrors.push_back(*_attachment); });
+        m_receiver->registerHandler<cmdSIMPLE_MSG>(
+            [this](const SSenderInfo& /*_sender*/, SCommandAttachmentImpl<cmdSIMPLE_MSG>::ptr_t _attachment)
+            { m_receiverErrors.push_back(*_attachment); });
+    }
+
+    /// \brief Runs handlers until the condition is met or the timeout expires.
+    template <class P>
+    bool runUntil(P _condition)
+    {
+        const auto timeout = chrono::steady_clock::now() + chrono::seconds(10);
+        while (!_condition() && chrono::steady_clock::now() < timeout)
+            m_ioContext.run_one_for(chrono::milliseconds(10));
+        return _condition();
+    }
+
+    boost::asio::io_context m_ioContext;
+    CTestChannel::connectionPtr_t m_sender;
+    CTestChannel::connectionPtr_t m_receiver;
+    size_t m_nofReceived{ 0 };
+    SCustomCmdCmd m_lastCustomCmd;
+    bool m_isDisconnected{ false };
+    vector<SBinaryAttachmentReceivedCmd> m_receivedFiles;
+    vector<SSimpleMsgCmd> m_senderErrors;
+    vector<SSimpleMsgCmd> m_receiverErrors;
+};
+
+/// \brief Received binary attachments are stored in the working directory of a temporary configuration.
+struct SWrkDirFixture
+{
+    SWrkDirFixture()
+        : m_dir(fs::temp_directory_path() / fs::unique_path())
+    {
+        fs::create_directories(m_dir);
+        const fs::path cfgPath(m_dir / "dds_test.cfg");
+        ofstream f(cfgPath.string());
+        f << "[server]\n"
+          << "work_dir=" << (m_dir / "wrk").string() << "\n";
+        f.close();
+        CUserDefaults::instance().reinit(CUserDefaults::getInitialSID(), cfgPath.string());
+        m_wrkDir = CUserDefaults::instance().getWrkDir();
+        fs::create_directories(m_wrkDir);
+    }
+
+    ~SWrkDirFixture()
+    {
+        boost::system::error_code ec;
+        fs::remove_all(m_dir, ec);
+    }
+
+    /// \brief Number of incomplete files in the working directory.
+    size_t nofPartFiles() const
+    {
+        size_t result(0);
+        for (const auto& entry : fs::directory_iterator(m_wrkDir))
+        {
+            if (entry.path().extension() == ".part")
+                ++result;
+        }
+        return result;
+    }
+
+    fs::path m_dir;
+    fs::path m_wrkDir;
+};
+
+BOOST_AUTO_TEST_SUITE(Test_Channel);
+
+BOOST_AUTO_TEST_CASE(Test_Channel_WriteError)
+{
+    SChannelPair pair;
+    pair.m_sender->setCompression(1, 64);
+
+    SCustomCmdCmd cmd;
+    cmd.m_sCmd = "custom command";
+    pair.m_sender->pushMsg<cmdCUSTOM_CMD>(cmd);
+    BOOST_CHECK(pair.runUntil([&pair]() { return pair.m_nofReceived == 1; }));
+
+    // The writer fails to allocate the buffer of the compressed message
+    cmd.m_sCmd.assign(2 * 1024 * 1024, 'c');
+    CProtocolMessage::protocolMessagePtr_t msg = SCommandAttachmentImpl<cmdCUSTOM_CMD>::encode(cmd, 0);
+    g_failAllocationSize = 1024 * 1024;
+    pair.m_sender->pushMsg(msg, cmdCUSTOM_CMD);
+    const bool isDisconnected = pair.runUntil([&pair]() { return pair.m_isDisconnected; });
+    g_failAllocationSize = numeric_limits<size_t>::max();
+
+    // The channel is closed instead of silently dropping all further messages
+    BOOST_CHECK(isDisconnected);
+    BOOST_CHECK(!pair.m_sender->started());
+    BOOST_CHECK_EQUAL(pair.m_nofReceived, 1);
+}
+
+BOOST_AUTO_TEST_CASE(Test_Channel_EncodedMsgLargeValues)
+{
+    SChannelPair pair;
+
+    SCustomCmdCmd cmd;
+    cmd.m_sCmd.assign(100000, 'c');
+    // Large values can't be shared by channels, broadcasts encode them for each channel
+    CProtocolMessage::sharedBodyPtr_t body = SCommandAttachmentImpl<cmdCUSTOM_CMD>::encodeBody(cmd);
+    BOOST_REQUIRE(body == nullptr);
+
+    pair.m_sender->pushEncodedMsg<cmdCUSTOM_CMD>(cmd, body);
+    BOOST_REQUIRE(pair.runUntil([&pair]() { return pair.m_nofReceived == 1; }));
+    BOOST_CHECK(pair.m_lastCustomCmd == cmd);
+
+    pair.m_sender->accumulativePushEncodedMsg<cmdCUSTOM_CMD>(cmd, body);
+    BOOST_REQUIRE(pair.runUntil([&pair]() { return pair.m_nofReceived == 2; }));
+    BOOST_CHECK(pair.m_lastCustomCmd == cmd);
+
+    BOOST_CHECK(pair.m_sender->pushCoalescibleEncodedMsg<cmdCUSTOM_CMD>(cmd, body));
+    BOOST_REQUIRE(pair.runUntil([&pair]() { return pair.m_nofReceived == 3; }));
+    BOOST_CHECK(pair.m_lastCustomCmd == cmd);
+    BOOST_CHECK(!pair.m_isDisconnected);
+}
+
+BOOST_FIXTURE_TEST_CASE(Test_Channel_BinaryAttachmentEmpty, SWrkDirFixture)
+{
+    SChannelPair pair;
+    pair.m_sender->pushBinaryAttachmentCmd(dds::misc::BYTEVector_t(), "empty.txt", cmdGET_LOG, 0);
+    BOOST_REQUIRE(pair.runUntil([&pair]() { return !pair.m_receivedFiles.empty(); }));
+
+    // An empty file is complete right away
+    const SBinaryAttachmentReceivedCmd& received = pair.m_receivedFiles.front();
+    BOOST_CHECK_EQUAL(received.m_requestedFileName, "empty.txt");
+    BOOST_CHECK_EQUAL(received.m_receivedFileSize, 0);
+    BOOST_CHECK(fs::exists(received.m_receivedFilePath));
+    BOOST_CHECK_EQUAL(fs::file_size(received.m_receivedFilePath), 0);
+    BOOST_CHECK_EQUAL(nofPartFiles(), 0);
+    BOOST_CHECK(pair.m_receiverErrors.empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(Test_Channel_BinaryAttachmentAbort, SWrkDirFixture)
+{
+    // More pieces than the sender reads ahead
+    const fs::path srcPath(m_dir / "src.bin");
+    {
+        ofstream f(srcPath.string(), ios::binary);
+        const string piece(SSharedBinaryAttachment::maxPieceSize, 'b');
+        for (size_t i = 0; i < 32; ++i)
+            f << piece;
+    }
+
+    SChannelPair pair;
+    pair.m_sender->pushBinaryAttachmentCmd(srcPath.string(), "src.bin", cmdGET_LOG, 0);
+    // The file shrinks while it's being sent
+    fs::resize_file(srcPath, SSharedBinaryAttachment::maxPieceSize);
+
+    BOOST_REQUIRE(
+        pair.runUntil([&pair]() { return !pair.m_senderErrors.empty() && !pair.m_receiverErrors.empty(); }));
+
+    // Both ends report the error and the receiver drops the incomplete file
+    BOOST_CHECK_EQUAL(pair.m_senderErrors.front().m_srcCommand, cmdGET_LOG);
+    BOOST_CHECK_EQUAL(pair.m_senderErrors.front().m_msgSeverity, dds::misc::error);
+    BOOST_CHECK_EQUAL(pair.m_receiverErrors.front().m_srcCommand, cmdGET_LOG);
+    BOOST_CHECK(pair.m_receivedFiles.empty());
+    BOOST_CHECK_EQUAL(nofPartFiles(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -13,12 +13,22 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_generators.hpp>
+// STD
+#include <atomic>
+#include <random>
+#include <thread>
 
 // DDS
+#include "ChannelRegistry.h"
+#include "CoalescingWindow.h"
 #include "CommandAttachmentImpl.h"
+#include "MPSCQueue.h"
 #include "ProtocolCommands.h"
 #include "ProtocolMessage.h"
+#include "ProtocolMessagePool.h"
+#include "SharedBinaryAttachment.h"
 #include "TestCmd.h"
+#include "WriteQueueMonitor.h"
 #include "def.h"
 
 using boost::unit_test::test_suite;
@@ -63,14 +73,24 @@ void TestCommand(const T& _srcCmd, uint16_t _srcCmdID, size_t _expectedCmdSize)
 
 BOOST_AUTO_TEST_CASE(Test_ProtocolMessage_cmdHANDSHAKE)
 {
-    const unsigned int cmdSize = 14;
+    const unsigned int cmdSize = 16;
 
     SVersionCmd cmd;
     cmd.m_version = 444;
     cmd.m_channelType = 2;
     cmd.m_sSID = "TEST SID";
+    cmd.m_commandsVersion = 5;
 
     TestCommand(cmd, cmdHANDSHAKE, cmdSize);
+
+    // Peers with an older protocol don't send the commands version
+    BYTEVector_t data;
+    cmd.convertToData(&data);
+    SVersionCmd oldCmd;
+    oldCmd.convertFromData(SByteView(data.data(), data.size() - sizeof(uint16_t)));
+    BOOST_CHECK_EQUAL(oldCmd.m_version, cmd.m_version);
+    BOOST_CHECK_EQUAL(oldCmd.m_sSID, cmd.m_sSID);
+    BOOST_CHECK_EQUAL(oldCmd.m_commandsVersion, 0);
 }
 
 BOOST_AUTO_TEST_CASE(Test_ProtocolMessage_cmdSUBMIT)
@@ -232,6 +252,82 @@ BOOST_AUTO_TEST_CASE(Test_ProtocolMessage_cmdASSIGN_USER_TASK)
     TestCommand(src, cmdASSIGN_USER_TASK, cmdSize);
 }
 
+BOOST_AUTO_TEST_CASE(Test_ProtocolMessage_cmdASSIGN_USER_TASKS)
+{
+    SAssignUserTasksCmd src;
+    for (uint64_t i = 1; i <= 3; ++i)
+    {
+        SAssignUserTasksCmd::SSlot slot;
+        slot.m_slotID = 1000 + i;
+        slot.m_assignment.m_taskID = i;
+        slot.m_assignment.m_sExeFile = "test.exe --index " + to_string(i);
+        slot.m_assignment.m_taskPath = "/main/group1/task_" + to_string(i);
+        slot.m_assignment.m_taskName = "task";
+        slot.m_assignment.m_topoHash = 321;
+        src.m_slots.push_back(slot);
+    }
+    // expected attachment size: slot ID and size prefixed assignment of each slot
+    size_t cmdSize(0);
+    for (const auto& slot : src.m_slots)
+        cmdSize += sizeof(uint64_t) + sizeof(uint32_t) + slot.m_assignment.size();
+
+    TestCommand(src, cmdASSIGN_USER_TASKS, cmdSize);
+
+    SSlotRepliesCmd replies;
+    replies.m_slots.push_back(
+        { 1001, SReplyCmd("User task activated", (uint16_t)SReplyCmd::EStatusCode::OK, 0, cmdASSIGN_USER_TASKS) });
+    replies.m_slots.push_back(
+        { 1002, SReplyCmd("Wrong slot ID", (uint16_t)SReplyCmd::EStatusCode::ERROR, 0, cmdASSIGN_USER_TASKS) });
+    const size_t repliesSize = 2 * (sizeof(uint64_t) + sizeof(uint32_t)) + replies.m_slots[0].m_reply.size() +
+                               replies.m_slots[1].m_reply.size();
+
+    TestCommand(replies, cmdREPLY_ASSIGN_USER_TASKS, repliesSize);
+
+    // Truncated data must not be read beyond the end of the buffer
+    BYTEVector_t data;
+    src.convertToData(&data);
+    SAssignUserTasksCmd shortCmd;
+    BOOST_CHECK_THROW(shortCmd.convertFromData(SByteView(data.data(), data.size() - 1)), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(Test_ProtocolMessage_cmdCHECK_CACHED_FILES)
+{
+    BYTEVector_t content{ 'd', 'd', 's' };
+    auto attachment = SSharedBinaryAttachment::makeFromData(content);
+    const string hash{ attachment->contentHash() };
+    BOOST_CHECK_EQUAL(hash, SSharedBinaryAttachment::makeFromData(content)->contentHash());
+    content.push_back('\0');
+    BOOST_CHECK_NE(hash, SSharedBinaryAttachment::makeFromData(content)->contentHash());
+
+    // Hashes name files in the cache of agents
+    BOOST_CHECK(SSharedBinaryAttachment::isContentHash(hash));
+    BOOST_CHECK(SSharedBinaryAttachment::isContentHash("0123456789abcdef-18446744073709551615"));
+    BOOST_CHECK(!SSharedBinaryAttachment::isContentHash(""));
+    BOOST_CHECK(!SSharedBinaryAttachment::isContentHash("0123456789abcdef-"));
+    BOOST_CHECK(!SSharedBinaryAttachment::isContentHash("0123456789abcdef-123456789012345678901"));
+    BOOST_CHECK(!SSharedBinaryAttachment::isContentHash("0123456789ABCDEF-3"));
+    BOOST_CHECK(!SSharedBinaryAttachment::isContentHash("0123456789abcde-13"));
+    BOOST_CHECK(!SSharedBinaryAttachment::isContentHash("0123456789abcdef-3/"));
+    BOOST_CHECK(!SSharedBinaryAttachment::isContentHash("../../../../../../-3"));
+    BOOST_CHECK(!SSharedBinaryAttachment::isContentHash("0123456789abcdef/../x"));
+
+    SCachedFilesCmd src;
+    src.m_hashes = { hash, "0000000000000000-0" };
+    const unsigned int cmdSize = sizeof(uint16_t) + 2 * sizeof(uint16_t) + src.m_hashes[0].size() +
+                                 src.m_hashes[1].size();
+    TestCommand(src, cmdCHECK_CACHED_FILES, cmdSize);
+    TestCommand(src, cmdREPLY_CHECK_CACHED_FILES, cmdSize);
+
+    // Cached files are appended to the assignment, which is read by older peers as well
+    SAssignUserTaskCmd assignment;
+    assignment.m_sExeFile = "$DDS_LOCATION/test.exe";
+    const size_t sizeWithoutCache{ assignment.size() };
+    assignment.m_cachedFileHashes = { hash };
+    assignment.m_cachedFileNames = { "test.exe" };
+    BOOST_CHECK_EQUAL(assignment.size(), sizeWithoutCache + 2 * (2 * sizeof(uint16_t)) + hash.size() + 8);
+    TestCommand(assignment, cmdASSIGN_USER_TASK, assignment.size());
+}
+
 BOOST_AUTO_TEST_CASE(Test_ProtocolMessage_cmdUPDATE_KEY)
 {
     const string propertyName = "test_Property";
@@ -335,7 +431,7 @@ BOOST_AUTO_TEST_CASE(Test_ProtocolMessage_cmdLOBBY_MEMBER_INFO)
 
 BOOST_AUTO_TEST_CASE(Test_ProtocolMessage_cmdLOBBY_MEMBER_HANDSHAKE)
 {
-    const unsigned int cmdSize = 9;
+    const unsigned int cmdSize = 11;
 
     SVersionCmd cmd;
     cmd.m_sSID = "SID";
@@ -358,4 +454,651 @@ BOOST_AUTO_TEST_CASE(Test_ProtocolMessage_cmdREPLY)
     TestCommand(cmd, cmdREPLY, cmdSize);
 }
 
+BOOST_AUTO_TEST_CASE(Test_ProtocolMessage_SharedBody)
+{
+    SCustomCmdCmd cmd;
+    cmd.m_sCmd = "custom command";
+    cmd.m_sCondition = "condition";
+    cmd.m_senderId = 321;
+    cmd.m_timestamp = 123;
+
+    const uint64_t ID = 12345;
+    CProtocolMessage::protocolMessagePtr_t srcMsgPtr = SCommandAttachmentImpl<cmdCUSTOM_CMD>::encode(cmd, ID);
+    CProtocolMessage::sharedBodyPtr_t body = SCommandAttachmentImpl<cmdCUSTOM_CMD>::encodeBody(cmd);
+    CProtocolMessage::protocolMessagePtr_t sharedMsgPtr = SCommandAttachmentImpl<cmdCUSTOM_CMD>::encode(body, ID);
+    const CProtocolMessage& srcMsg = *srcMsgPtr;
+    const CProtocolMessage& sharedMsg = *sharedMsgPtr;
+
+    BOOST_CHECK(!srcMsg.hasSharedBody());
+    BOOST_CHECK(sharedMsg.hasSharedBody());
+    BOOST_CHECK(sharedMsg.body() == body->data());
+    BOOST_CHECK_EQUAL(srcMsg.length(), sharedMsg.length());
+
+    // The header and the body of both messages must be identical on the wire
+    BOOST_CHECK(memcmp(srcMsg.data(), sharedMsg.data(), CProtocolMessage::header_length) == 0);
+    BOOST_CHECK(memcmp(srcMsg.body(), sharedMsg.body(), srcMsg.body_length()) == 0);
+
+    // "Send" message
+    CProtocolMessage msg_dest;
+    msg_dest.resize(CProtocolMessage::header_length);
+    memcpy(msg_dest.data(), sharedMsg.data(), CProtocolMessage::header_length);
+    BOOST_CHECK(msg_dest.decode_header());
+    memcpy(msg_dest.body(), sharedMsg.body(), sharedMsg.body_length());
+    BOOST_CHECK_EQUAL(msg_dest.header().m_ID, ID);
+
+    SCustomCmdCmd destCmd;
+    destCmd.convertFromData(msg_dest.bodyToContainer());
+    BOOST_CHECK(cmd == destCmd);
+}
+
+BOOST_AUTO_TEST_CASE(Test_ProtocolMessage_BinaryAttachmentView)
+{
+    SBinaryAttachmentCmd cmd;
+    cmd.m_data.assign(1024, 'x');
+    cmd.m_fileId = boost::uuids::random_generator()();
+    cmd.m_size = cmd.m_data.size();
+    cmd.m_offset = 2048;
+    cmd.m_crc32 = 54321;
+
+    CProtocolMessage::protocolMessagePtr_t msg = SCommandAttachmentImpl<cmdBINARY_ATTACHMENT>::encode(cmd, 0);
+    SCommandAttachmentImpl<cmdBINARY_ATTACHMENT>::ptr_t destCmd =
+        SCommandAttachmentImpl<cmdBINARY_ATTACHMENT>::decode(msg);
+
+    BOOST_CHECK(cmd == *destCmd);
+    // The payload references the buffer of the message instead of a copy
+    const CProtocolMessage& constMsg = *msg;
+    SByteView payload(destCmd->payload());
+    BOOST_CHECK(destCmd->m_data.empty());
+    BOOST_CHECK(payload.data() >= constMsg.body());
+    BOOST_CHECK(payload.end() == constMsg.body() + constMsg.body_length());
+
+    // The decoded command can be encoded again
+    BYTEVector_t data;
+    destCmd->convertToData(&data);
+    BOOST_CHECK_EQUAL(data.size(), destCmd->size());
+    BOOST_CHECK(std::equal(data.begin(), data.end(), constMsg.body()));
+
+    // Truncated data must not be read beyond the end of the buffer
+    SBinaryAttachmentCmd shortCmd;
+    BOOST_CHECK_THROW(shortCmd.convertFromData(SByteView(data.data(), data.size() - 1)), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(Test_ProtocolMessage_Pool)
+{
+    CProtocolMessagePool::ptr_t pool = CProtocolMessagePool::makeNew();
+
+    SUpdateKeyCmd cmd;
+    cmd.m_propertyName = "property_name";
+    cmd.m_value = "property_value";
+    CProtocolMessage::protocolMessagePtr_t srcMsg = SCommandAttachmentImpl<cmdUPDATE_KEY>::encode(cmd, 77);
+
+    // "Receive" the header, then the body
+    CProtocolMessage::protocolMessagePtr_t msg = pool->acquire(srcMsg->data());
+    BOOST_CHECK_EQUAL(msg->header().m_cmd, cmdUPDATE_KEY);
+    BOOST_CHECK_EQUAL(msg->header().m_ID, 77);
+    BOOST_CHECK_EQUAL(msg->length(), srcMsg->length());
+    memcpy(msg->body(), srcMsg->body(), srcMsg->body_length());
+    BOOST_CHECK(cmd == *SCommandAttachmentImpl<cmdUPDATE_KEY>::decode(msg));
+
+    const CProtocolMessage* rawMsg = msg.get();
+    msg.reset();
+    BOOST_CHECK_EQUAL(pool->getStats().m_hits, 0);
+    BOOST_CHECK_EQUAL(pool->getStats().m_misses, 1);
+
+    // The released message is reused for a message of the same size class
+    msg = pool->acquire(srcMsg->data());
+    BOOST_CHECK(msg.get() == rawMsg);
+    BOOST_CHECK_EQUAL(pool->getStats().m_hits, 1);
+
+    // A big message doesn't fit into the buffer of the small one
+    CProtocolMessage::protocolMessagePtr_t bigMsg = pool->acquire(65536);
+    BOOST_CHECK(bigMsg->capacity() >= 65536);
+    BOOST_CHECK_EQUAL(pool->getStats().m_misses, 2);
+
+    // Messages can outlive the pool
+    pool.reset();
+    msg.reset();
+    bigMsg.reset();
+
+    // Corrupted headers are rejected
+    pool = CProtocolMessagePool::makeNew();
+    BYTEVector_t badHeader(srcMsg->data(), srcMsg->data() + CProtocolMessage::header_length);
+    badHeader[0] ^= 0xFF;
+    BOOST_CHECK_THROW(pool->acquire(badHeader.data()), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(Test_ProtocolMessage_SharedBinaryAttachment)
+{
+    const uint32_t pieceSize = SSharedBinaryAttachment::maxPieceSize;
+    BYTEVector_t data(2 * pieceSize + 100);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<uint8_t>(i);
+
+    SSharedBinaryAttachment::ptr_t attachment = SSharedBinaryAttachment::makeFromData(data);
+    BOOST_CHECK_EQUAL(attachment->size(), data.size());
+    BOOST_CHECK_EQUAL(attachment->nofPieces(), 3);
+
+    boost::crc_32_type crc32;
+    crc32.process_bytes(data.data(), data.size());
+    BOOST_CHECK_EQUAL(attachment->m_crc32, crc32.checksum());
+
+    // The last piece is shorter
+    SByteView lastPiece(attachment->piece(2 * pieceSize));
+    BOOST_CHECK_EQUAL(lastPiece.size(), 100);
+    BOOST_CHECK(std::equal(lastPiece.begin(), lastPiece.end(), data.begin() + 2 * pieceSize));
+    boost::crc_32_type pieceCrc32;
+    pieceCrc32.process_bytes(lastPiece.data(), lastPiece.size());
+    BOOST_CHECK_EQUAL(attachment->pieceCrc32(2 * pieceSize), pieceCrc32.checksum());
+
+    // A piece references the shared attachment
+    SBinaryAttachmentCmd cmd;
+    cmd.m_offset = pieceSize;
+    cmd.m_size = pieceSize;
+    cmd.m_crc32 = attachment->pieceCrc32(pieceSize);
+    cmd.setPayload(attachment->piece(pieceSize), attachment);
+    BOOST_CHECK(cmd.payload().data() == attachment->m_data.data() + pieceSize);
+
+    CProtocolMessage::protocolMessagePtr_t msg = SCommandAttachmentImpl<cmdBINARY_ATTACHMENT>::encode(cmd, 0);
+    SCommandAttachmentImpl<cmdBINARY_ATTACHMENT>::ptr_t destCmd =
+        SCommandAttachmentImpl<cmdBINARY_ATTACHMENT>::decode(msg);
+    BOOST_CHECK(cmd == *destCmd);
+
+    BOOST_CHECK_THROW(SSharedBinaryAttachment::makeFromFile("/non/existing/file"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(Test_ProtocolMessage_WriteQueueMonitor)
+{
+    SWriteQueueLimits limits;
+    limits.m_highWatermarkMsgs = 4;
+    limits.m_lowWatermarkMsgs = 2;
+    limits.m_highWatermarkBytes = 1000;
+    limits.m_lowWatermarkBytes = 500;
+    limits.m_maxBytes = 2000;
+
+    CWriteQueueMonitor monitor;
+    monitor.setLimits(limits);
+
+    // Congested once the high watermark of messages is reached
+    for (size_t i = 0; i < 3; ++i)
+        BOOST_CHECK(monitor.add(10));
+    BOOST_CHECK(!monitor.isCongested());
+    BOOST_CHECK(monitor.add(10));
+    BOOST_CHECK(monitor.isCongested());
+
+    // Each change of the congestion is reported once
+    bool isCongested(false);
+    BOOST_CHECK(monitor.takeCongestionChange(isCongested));
+    BOOST_CHECK(isCongested);
+    BOOST_CHECK(!monitor.takeCongestionChange(isCongested));
+
+    // Stays congested until the low watermark is reached
+    monitor.remove(10);
+    BOOST_CHECK(monitor.isCongested());
+    monitor.remove(10);
+    BOOST_CHECK(!monitor.isCongested());
+    BOOST_CHECK(monitor.takeCongestionChange(isCongested));
+    BOOST_CHECK(!isCongested);
+
+    // Congested once the high watermark of bytes is reached
+    BOOST_CHECK(monitor.add(980));
+    BOOST_CHECK(monitor.isCongested());
+    monitor.drop();
+
+    // Messages beyond the maximum size are rejected
+    BOOST_CHECK(!monitor.add(1500));
+
+    SWriteQueueStats stats = monitor.getStats();
+    BOOST_CHECK_EQUAL(stats.m_nofMessages, 3);
+    BOOST_CHECK_EQUAL(stats.m_nofBytes, 1000);
+    BOOST_CHECK_EQUAL(stats.m_maxNofMessages, 4);
+    BOOST_CHECK_EQUAL(stats.m_maxNofBytes, 1000);
+    BOOST_CHECK_EQUAL(stats.m_nofDropped, 1);
+    BOOST_CHECK_EQUAL(stats.m_nofRejected, 1);
+    BOOST_CHECK_EQUAL(stats.m_nofCongestions, 2);
+    BOOST_CHECK(stats.m_isCongested);
+
+    monitor.remove(980);
+    BOOST_CHECK(!monitor.isCongested());
+}
+
+BOOST_AUTO_TEST_CASE(Test_ProtocolMessage_MPSCQueue)
+{
+    CMPSCQueue<size_t> queue;
+    BOOST_CHECK(queue.empty());
+    BOOST_CHECK_EQUAL(queue.popAll([](size_t) {}), 0);
+
+    // Elements are taken in push order
+    for (size_t i = 0; i < 10; ++i)
+        queue.push(i);
+    BOOST_CHECK(!queue.empty());
+    vector<size_t> values;
+    BOOST_CHECK_EQUAL(queue.popAll([&values](size_t _v) { values.push_back(_v); }), 10);
+    BOOST_CHECK(queue.empty());
+    for (size_t i = 0; i < values.size(); ++i)
+        BOOST_CHECK_EQUAL(values[i], i);
+
+    // Concurrent producers and a consumer: nothing is lost and each producer keeps its order
+    const size_t nofProducers = 8;
+    const size_t nofElements = 10000;
+    vector<thread> producers;
+    for (size_t p = 0; p < nofProducers; ++p)
+        producers.emplace_back(
+            [&queue, p]
+            {
+                for (size_t i = 0; i < nofElements; ++i)
+                    queue.push(p * nofElements + i);
+            });
+
+    vector<size_t> lastValues(nofProducers, 0);
+    vector<size_t> counts(nofProducers, 0);
+    bool isOrdered(true);
+    auto consume = [&](size_t _v)
+    {
+        const size_t p = _v / nofElements;
+        if (counts[p] > 0 && _v <= lastValues[p])
+            isOrdered = false;
+        lastValues[p] = _v;
+        ++counts[p];
+    };
+    size_t total(0);
+    while (total < nofProducers * nofElements)
+        total += queue.popAll(consume);
+    for (auto& producer : producers)
+        producer.join();
+
+    BOOST_CHECK(isOrdered);
+    BOOST_CHECK(queue.empty());
+    for (const auto count : counts)
+        BOOST_CHECK_EQUAL(count, nofElements);
+}
+
+BOOST_AUTO_TEST_CASE(Test_ProtocolMessage_CoalescingWindow)
+{
+    typedef CCoalescingWindow::clock_t clock_t;
+    const clock_t::time_point start;
+
+    SCoalescingPolicy policy;
+    policy.m_maxLatency = std::chrono::microseconds(1000);
+    policy.m_maxBatchBytes = 100;
+    policy.m_maxBatchMsgs = 3;
+
+    CCoalescingWindow window;
+    window.setPolicy(cmdUPDATE_KEY, policy);
+    BOOST_CHECK_EQUAL(window.getPolicy(cmdUPDATE_KEY).m_maxBatchBytes, 100);
+    BOOST_CHECK_EQUAL(window.getPolicy(cmdREPLY).m_maxBatchBytes, SCoalescingPolicy().m_maxBatchBytes);
+
+    // Unknown load, the link is idle: nothing to wait for
+    BOOST_CHECK(window.add(cmdUPDATE_KEY, 10, true, start));
+    window.reset();
+
+    // High load: the batch is held back until its deadline
+    BOOST_CHECK(!window.add(cmdUPDATE_KEY, 10, true, start + std::chrono::microseconds(10)));
+    BOOST_CHECK(window.deadline() == start + std::chrono::microseconds(1010));
+    BOOST_CHECK(!window.add(cmdUPDATE_KEY, 10, false, start + std::chrono::microseconds(20)));
+    BOOST_CHECK(window.deadline() == start + std::chrono::microseconds(1010));
+    // The batch is full
+    BOOST_CHECK(window.add(cmdUPDATE_KEY, 10, false, start + std::chrono::microseconds(30)));
+    window.reset();
+    BOOST_CHECK(window.empty());
+
+    // The batch reaches the max size
+    BOOST_CHECK(!window.add(cmdUPDATE_KEY, 60, false, start + std::chrono::microseconds(40)));
+    BOOST_CHECK(window.add(cmdUPDATE_KEY, 60, false, start + std::chrono::microseconds(50)));
+    window.reset();
+
+    // The deadline has expired
+    BOOST_CHECK(!window.add(cmdUPDATE_KEY, 10, false, start + std::chrono::microseconds(60)));
+    BOOST_CHECK(window.add(cmdUPDATE_KEY, 10, false, start + std::chrono::microseconds(1060)));
+    window.reset();
+
+    // Low load: messages arrive at a lower rate than the latency budget
+    for (int i = 2; i < 40; ++i)
+    {
+        window.add(cmdUPDATE_KEY, 10, false, start + std::chrono::microseconds(i * 10000));
+        window.reset();
+    }
+    BOOST_CHECK(window.add(cmdUPDATE_KEY, 10, true, start + std::chrono::microseconds(400000)));
+    BOOST_CHECK(!window.add(cmdUPDATE_KEY, 10, false, start + std::chrono::microseconds(400001)));
+}
+
+BOOST_AUTO_TEST_CASE(Test_ProtocolMessage_cmdBATCH)
+{
+    SUpdateKeyCmd updateKey;
+    updateKey.m_propertyName = "property";
+    updateKey.m_value = "value";
+    updateKey.m_senderTaskID = 123;
+    updateKey.m_receiverTaskID = 456;
+    BYTEVector_t updateKeyData;
+    updateKey.convertToData(&updateKeyData);
+
+    SBatchCmd cmd;
+    cmd.add(cmdREPLY_HANDSHAKE_OK, 1, SByteView());
+    cmd.add(cmdUPDATE_KEY, 2, SByteView(updateKeyData));
+    cmd.add(cmdUPDATE_KEY, 3, SByteView(updateKeyData));
+
+    TestCommand(cmd, cmdBATCH, 3 * SBatchCmd::msgSize(0) + 2 * updateKeyData.size());
+
+    CProtocolMessage::protocolMessagePtr_t msg = SCommandAttachmentImpl<cmdBATCH>::encode(cmd, 0);
+    SCommandAttachmentImpl<cmdBATCH>::ptr_t destCmd = SCommandAttachmentImpl<cmdBATCH>::decode(msg);
+    BOOST_CHECK(cmd == *destCmd);
+    BOOST_CHECK(destCmd->m_dataOwner == msg);
+
+    // Unpack a message the way the channel does
+    const SBatchCmd::SMsg& packedMsg = destCmd->m_msgs[2];
+    CProtocolMessage unpackedMsg;
+    unpackedMsg.encode(packedMsg.m_cmd, packedMsg.m_body.data(), packedMsg.m_body.size(), packedMsg.m_ID);
+    BOOST_CHECK_EQUAL(unpackedMsg.header().m_cmd, cmdUPDATE_KEY);
+    BOOST_CHECK_EQUAL(unpackedMsg.header().m_ID, 3);
+    SUpdateKeyCmd destUpdateKey;
+    destUpdateKey.convertFromData(unpackedMsg.bodyToContainer());
+    BOOST_CHECK(updateKey == destUpdateKey);
+
+    // Truncated data must not be read beyond the end of the buffer
+    BYTEVector_t data;
+    cmd.convertToData(&data);
+    SBatchCmd shortCmd;
+    BOOST_CHECK_THROW(shortCmd.convertFromData(SByteView(data.data(), data.size() - 1)), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(Test_ProtocolMessage_Compressed)
+{
+    SCustomCmdCmd cmd;
+    cmd.m_sCmd.assign(10000, 'x');
+    cmd.m_sCondition = "condition";
+    cmd.m_senderId = 123;
+    CProtocolMessage::protocolMessagePtr_t msg = SCommandAttachmentImpl<cmdCUSTOM_CMD>::encode(cmd, 456);
+
+    CProtocolMessage compressedMsg;
+    BOOST_CHECK(compressedMsg.encodeCompressed(*msg, 1));
+    BOOST_CHECK_EQUAL(compressedMsg.header().m_cmd, cmdCOMPRESSED);
+    BOOST_CHECK_EQUAL(compressedMsg.header().m_ID, 456);
+    BOOST_CHECK(compressedMsg.length() < msg->length() / 10);
+
+    // "Send" message
+    CProtocolMessage destCompressedMsg;
+    destCompressedMsg.resize(compressedMsg.length());
+    memcpy(destCompressedMsg.data(), compressedMsg.data(), compressedMsg.length());
+    BOOST_CHECK(destCompressedMsg.decode_header());
+
+    CProtocolMessage::protocolMessagePtr_t destMsg = make_shared<CProtocolMessage>();
+    destMsg->decodeCompressed(destCompressedMsg);
+    BOOST_CHECK_EQUAL(destMsg->header().m_cmd, cmdCUSTOM_CMD);
+    BOOST_CHECK_EQUAL(destMsg->header().m_ID, 456);
+    BOOST_CHECK(destMsg->decode_header());
+    SCommandAttachmentImpl<cmdCUSTOM_CMD>::ptr_t destCmd = SCommandAttachmentImpl<cmdCUSTOM_CMD>::decode(destMsg);
+    BOOST_CHECK(cmd == *destCmd);
+
+    // Incompressible data is sent as it is
+    std::mt19937 generator(42);
+    BYTEVector_t data(1000);
+    for (auto& v : data)
+        v = static_cast<BYTEVector_t::value_type>(generator());
+    CProtocolMessage randomMsg(cmdBINARY_ATTACHMENT, data, 0);
+    CProtocolMessage compressedRandomMsg;
+    BOOST_CHECK(!compressedRandomMsg.encodeCompressed(randomMsg, 9));
+
+    // Corrupted data
+    CProtocolMessage corruptedMsg;
+    BYTEVector_t corruptedData(compressedMsg.body(), compressedMsg.body() + compressedMsg.body_length());
+    corruptedData.back() ^= 0xFF;
+    corruptedMsg.encode(cmdCOMPRESSED, corruptedData, 0);
+    BOOST_CHECK_THROW(destMsg->decodeCompressed(corruptedMsg), std::runtime_error);
+    BOOST_CHECK_THROW(destMsg->decodeCompressed(*msg), std::runtime_error);
+
+    // Wrong length of the original message
+    auto withLength = [&compressedMsg](uint32_t _len)
+    {
+        BYTEVector_t data(compressedMsg.body(), compressedMsg.body() + compressedMsg.body_length());
+        const uint32_t len = inet::normalizeWrite(_len);
+        memcpy(&data[sizeof(uint16_t)], &len, sizeof(len));
+        CProtocolMessage result;
+        result.encode(cmdCOMPRESSED, data, 0);
+        return result;
+    };
+    // A huge length is rejected before the memory is allocated
+    auto isTooBig = [](const std::runtime_error& _e) { return string(_e.what()).find("too big") != string::npos; };
+    BOOST_CHECK_EXCEPTION(
+        destMsg->decodeCompressed(withLength(numeric_limits<uint32_t>::max())), std::runtime_error, isTooBig);
+    BOOST_CHECK_EXCEPTION(destMsg->decodeCompressed(withLength(CProtocolMessage::max_decompressed_body_length + 1)),
+                          std::runtime_error,
+                          isTooBig);
+    // The uncompressed data must have exactly the announced length
+    BOOST_CHECK_THROW(destMsg->decodeCompressed(withLength(msg->body_length() + 1)), std::runtime_error);
+    BOOST_CHECK_THROW(destMsg->decodeCompressed(withLength(msg->body_length() - 1)), std::runtime_error);
+    destMsg->decodeCompressed(withLength(msg->body_length()));
+    BOOST_CHECK(cmd == *SCommandAttachmentImpl<cmdCUSTOM_CMD>::decode(destMsg));
+}
+
+BOOST_AUTO_TEST_CASE(Test_ProtocolMessage_LargeValues)
+{
+    SUpdateKeyCmd cmd;
+    cmd.m_propertyName = "property_name";
+    cmd.m_value.assign(100000, 'v');
+    cmd.m_senderTaskID = 1;
+    cmd.m_receiverTaskID = 2;
+    BOOST_CHECK(cmd.hasLargeValues());
+    BOOST_CHECK_EQUAL(cmd.size(), dsize(cmd.m_propertyName) + sizeof(uint16_t) + sizeof(uint32_t) + 100000 + 16);
+
+    CProtocolMessage::protocolMessagePtr_t msg = SCommandAttachmentImpl<cmdUPDATE_KEY>::encode(cmd, 77);
+    BOOST_CHECK(msg->isLargeValueFormat());
+    BOOST_CHECK_EQUAL(msg->body_length(), cmd.size());
+    SCommandAttachmentImpl<cmdUPDATE_KEY>::ptr_t destCmd = SCommandAttachmentImpl<cmdUPDATE_KEY>::decode(msg);
+    BOOST_CHECK(cmd == *destCmd);
+
+    // Large values can't be broadcasted with a shared body
+    BOOST_CHECK(SCommandAttachmentImpl<cmdUPDATE_KEY>::encodeBody(cmd) == nullptr);
+
+    // Values shorter than the escape keep the old format
+    SUpdateKeyCmd smallCmd(cmd);
+    smallCmd.m_value.assign(g_largeValueEscape - 1, 'v');
+    BOOST_CHECK(!smallCmd.hasLargeValues());
+    CProtocolMessage::protocolMessagePtr_t smallMsg = SCommandAttachmentImpl<cmdUPDATE_KEY>::encode(smallCmd, 77);
+    BOOST_CHECK(!smallMsg->isLargeValueFormat());
+    BOOST_CHECK(smallCmd == *SCommandAttachmentImpl<cmdUPDATE_KEY>::decode(smallMsg));
+
+    // A value of exactly 2^16-1 symbols requires the escape
+    SUpdateKeyCmd escapedCmd(cmd);
+    escapedCmd.m_value.assign(g_largeValueEscape, 'v');
+    BOOST_CHECK(escapedCmd.hasLargeValues());
+    CProtocolMessage::protocolMessagePtr_t escapedMsg = SCommandAttachmentImpl<cmdUPDATE_KEY>::encode(escapedCmd, 77);
+    BOOST_CHECK(escapedMsg->isLargeValueFormat());
+    BOOST_CHECK(escapedCmd == *SCommandAttachmentImpl<cmdUPDATE_KEY>::decode(escapedMsg));
+
+    // Peers without large value support send 2^16-1 symbols with a regular length
+    BYTEVector_t oldData;
+    pushData(escapedCmd.m_propertyName, &oldData);
+    pushData(escapedCmd.m_value, &oldData);
+    pushData(escapedCmd.m_senderTaskID, &oldData);
+    pushData(escapedCmd.m_receiverTaskID, &oldData);
+    CProtocolMessage::protocolMessagePtr_t oldMsg = make_shared<CProtocolMessage>(cmdUPDATE_KEY, oldData, 77);
+    BOOST_CHECK(!oldMsg->isLargeValueFormat());
+    BOOST_CHECK(escapedCmd == *SCommandAttachmentImpl<cmdUPDATE_KEY>::decode(oldMsg));
+
+    // Custom commands
+    SCustomCmdCmd customCmd;
+    customCmd.m_sCmd.assign(200000, 'c');
+    customCmd.m_sCondition = "condition";
+    CProtocolMessage::protocolMessagePtr_t customMsg = SCommandAttachmentImpl<cmdCUSTOM_CMD>::encode(customCmd, 0);
+    BOOST_CHECK(customMsg->isLargeValueFormat());
+    BOOST_CHECK(customCmd == *SCommandAttachmentImpl<cmdCUSTOM_CMD>::decode(customMsg));
+
+    // Other strings are still limited
+    SSimpleMsgCmd simpleCmd;
+    simpleCmd.m_sMsg.assign(100000, 's');
+    BOOST_CHECK_THROW(SCommandAttachmentImpl<cmdSIMPLE_MSG>::encode(simpleCmd, 0), std::invalid_argument);
+}
+
+struct STestRegistryChannel
+{
+    typedef std::shared_ptr<STestRegistryChannel> connectionPtr_t;
+    typedef std::weak_ptr<STestRegistryChannel> weakConnectionPtr_t;
+
+    EChannelType getChannelType() const
+    {
+        return m_type;
+    }
+
+    SChannelKeys getChannelKeys(uint64_t _protocolHeaderID, bool /*_isSlot*/) const
+    {
+        auto it = m_keys.find(_protocolHeaderID);
+        return (it != m_keys.end()) ? it->second : SChannelKeys();
+    }
+
+    EChannelType m_type{ EChannelType::UNKNOWN };
+    map<uint64_t, SChannelKeys> m_keys; ///< By protocol header ID
+};
+
+BOOST_AUTO_TEST_CASE(Test_ProtocolMessage_ChannelRegistry)
+{
+    typedef CChannelRegistry<STestRegistryChannel> registry_t;
+    registry_t registry;
+    BOOST_CHECK(registry.channels()->empty());
+
+    auto agent = make_shared<STestRegistryChannel>();
+    agent->m_type = EChannelType::AGENT;
+    agent->m_keys[1].m_agentID = 10;
+    agent->m_keys[1].m_host = "host";
+    agent->m_keys[1].m_isTaskDoneSubscriber = true;
+    for (uint64_t id : { 2, 3 })
+    {
+        agent->m_keys[id].m_agentID = 10;
+        agent->m_keys[id].m_host = "host";
+        agent->m_keys[id].m_state = 1;
+    }
+    auto ui = make_shared<STestRegistryChannel>();
+    registry.add(registry_t::channelInfo_t(agent, 1, false));
+    registry.add(registry_t::channelInfo_t(agent, 2, true));
+    registry.add(registry_t::channelInfo_t(agent, 3, true));
+    registry.add(registry_t::channelInfo_t(ui, 0, false));
+
+    BOOST_CHECK_EQUAL(registry.size(), 4);
+    BOOST_CHECK_EQUAL(registry.channels()->size(), 4);
+    BOOST_CHECK_EQUAL(registry.channels(EChannelType::AGENT, false)->size(), 1);
+    BOOST_CHECK_EQUAL(registry.channels(EChannelType::AGENT, true)->size(), 2);
+    BOOST_CHECK_EQUAL(registry.channels(EChannelType::UNKNOWN, false)->size(), 1);
+    BOOST_CHECK(registry.channels(EChannelType::UI, false)->empty());
+    BOOST_CHECK_EQUAL(registry.channels(EChannelType::AGENT, true, 1)->size(), 2);
+    BOOST_CHECK_EQUAL(registry.count(EChannelType::AGENT, true, 1), 2);
+    BOOST_CHECK_EQUAL(registry.count(EChannelType::AGENT, true, 2), 0);
+    BOOST_CHECK_EQUAL(registry.channelsOfAgent(10)->size(), 3);
+    BOOST_CHECK(registry.channelsOfAgent(11)->empty());
+    BOOST_CHECK_EQUAL(registry.channelsOnHost("host")->size(), 3);
+    BOOST_REQUIRE_EQUAL(registry.taskDoneSubscribers()->size(), 1);
+    BOOST_CHECK_EQUAL(registry.taskDoneSubscribers()->front().m_protocolHeaderID, 1);
+
+    registry_t::channelInfo_t info;
+    BOOST_REQUIRE(registry.find(3, info));
+    BOOST_CHECK(info.m_isSlot);
+    BOOST_CHECK(!registry.find(4, info));
+    BOOST_CHECK(!registry.findByTaskID(100, info));
+
+    // Unchanged lists are shared by readers
+    registry_t::containerPtr_t slots = registry.channels(EChannelType::AGENT, true);
+    registry_t::containerPtr_t idle = registry.channels(EChannelType::AGENT, true, 1);
+    BOOST_CHECK(registry.channels(EChannelType::AGENT, true) == slots);
+    BOOST_CHECK(registry.channels(EChannelType::AGENT, true, 1) == idle);
+
+    // A slot starts a task. Only the lists of the affected buckets change.
+    agent->m_keys[2].m_state = 2;
+    agent->m_keys[2].m_taskID = 100;
+    registry.update(agent.get(), 2);
+    BOOST_CHECK(registry.channels(EChannelType::AGENT, true) == slots);
+    registry_t::containerPtr_t newIdle = registry.channels(EChannelType::AGENT, true, 1);
+    BOOST_CHECK(newIdle != idle);
+    BOOST_CHECK_EQUAL(idle->size(), 2);
+    BOOST_CHECK_EQUAL(newIdle->size(), 1);
+    BOOST_CHECK_EQUAL(registry.count(EChannelType::AGENT, true, 2), 1);
+    BOOST_REQUIRE(registry.findByTaskID(100, info));
+    BOOST_CHECK_EQUAL(info.m_protocolHeaderID, 2);
+
+    // Updates without changes keep the lists
+    registry.update(agent.get());
+    BOOST_CHECK(registry.channels(EChannelType::AGENT, true, 1) == newIdle);
+
+    // The task is done
+    agent->m_keys[2] = agent->m_keys[3];
+    registry.update(agent.get(), 2);
+    BOOST_CHECK(!registry.findByTaskID(100, info));
+    BOOST_CHECK_EQUAL(registry.count(EChannelType::AGENT, true, 1), 2);
+
+    // The type of the channel is known after the handshake
+    ui->m_type = EChannelType::UI;
+    ui->m_keys[4].m_host = "host";
+    BOOST_CHECK(registry.updateProtocolHeaderID(ui.get(), 4));
+    BOOST_CHECK(!registry.updateProtocolHeaderID(ui.get(), 5));
+    BOOST_CHECK_EQUAL(registry.channels(EChannelType::UI, false)->size(), 1);
+    BOOST_CHECK(registry.channels(EChannelType::UNKNOWN, false)->empty());
+    BOOST_CHECK_EQUAL(registry.channelsOnHost("host")->size(), 4);
+    BOOST_REQUIRE(registry.find(4, info));
+    BOOST_CHECK(info.m_channel == ui);
+
+    // Lists taken by readers stay valid
+    registry.remove(agent.get());
+    BOOST_CHECK_EQUAL(slots->size(), 2);
+    BOOST_CHECK_EQUAL(registry.size(), 1);
+    BOOST_CHECK(registry.channels(EChannelType::AGENT, true)->empty());
+    BOOST_CHECK(registry.channelsOfAgent(10)->empty());
+    BOOST_CHECK(registry.taskDoneSubscribers()->empty());
+    BOOST_CHECK_EQUAL(registry.channelsOnHost("host")->size(), 1);
+    BOOST_CHECK(!registry.find(1, info));
+
+    registry.clear();
+    BOOST_CHECK(registry.channels()->empty());
+    BOOST_CHECK(!registry.find(4, info));
+}
+
+BOOST_AUTO_TEST_CASE(Test_ProtocolMessage_ChannelRegistryConcurrentReaders)
+{
+    typedef CChannelRegistry<STestRegistryChannel> registry_t;
+    registry_t registry;
+
+    const size_t nofChannels(2000);
+    vector<STestRegistryChannel::connectionPtr_t> channels;
+    for (size_t i = 0; i < nofChannels; ++i)
+    {
+        auto channel = make_shared<STestRegistryChannel>();
+        channel->m_type = EChannelType::AGENT;
+        channel->m_keys[i + 1].m_state = 1;
+        channels.push_back(channel);
+    }
+
+    // Readers see consistent lists while the channels are added and change their state
+    atomic<bool> stop{ false };
+    atomic<size_t> nofInconsistent{ 0 };
+    vector<thread> readers;
+    for (size_t i = 0; i < 4; ++i)
+        readers.emplace_back(
+            [&]()
+            {
+                while (!stop)
+                {
+                    registry_t::containerPtr_t list = registry.channels(EChannelType::AGENT, true, 1);
+                    for (const auto& v : *list)
+                    {
+                        if (v.m_channel == nullptr || !v.m_isSlot)
+                            ++nofInconsistent;
+                    }
+                    registry_t::channelInfo_t info;
+                    registry.find(nofChannels / 2, info);
+                }
+            });
+
+    for (size_t i = 0; i < nofChannels; ++i)
+        registry.add(registry_t::channelInfo_t(channels[i], i + 1, true));
+    for (size_t i = 0; i < nofChannels; i += 2)
+    {
+        channels[i]->m_keys[i + 1].m_state = 2;
+        registry.update(channels[i].get());
+    }
+
+    stop = true;
+    for (auto& v : readers)
+        v.join();
+
+    BOOST_CHECK_EQUAL(nofInconsistent, 0);
+    BOOST_CHECK_EQUAL(registry.size(), nofChannels);
+    BOOST_CHECK_EQUAL(registry.count(EChannelType::AGENT, true, 1), nofChannels / 2);
+    BOOST_CHECK_EQUAL(registry.channels(EChannelType::AGENT, true, 2)->size(), nofChannels / 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -36,6 +36,38 @@ namespace dds
             //!< Defines a number of days to keep DDS sessions. Not running sessions older than the specified number of
             //!< days will be auto deleted.
             unsigned int m_dataRetention;
+            //!< zlib compression level (1-9) of protocol messages. 0 disables the compression.
+            unsigned int m_compressionLevel;
+            //!< Protocol messages with a body of this size in bytes or bigger are compressed.
+            unsigned int m_compressionThreshold;
+            //!< If true, the transport engine runs one io_context per thread and distributes connections round-robin
+            //!< among them. Otherwise all threads share one io_context.
+            bool m_ioContextPerThread;
+            //!< Size in MB of queued outgoing messages of a connection, at which it becomes congested. Broadcasts serve
+            //!< congested connections last and skippable messages, like progress reports, are dropped.
+            unsigned int m_writeQueueHighWatermark;
+            //!< Size in MB of queued outgoing messages, at which a congested connection recovers.
+            unsigned int m_writeQueueLowWatermark;
+            //!< Number of queued outgoing messages of a connection, at which it becomes congested.
+            unsigned int m_writeQueueHighWatermarkMsgs;
+            //!< Number of queued outgoing messages, at which a congested connection recovers.
+            unsigned int m_writeQueueLowWatermarkMsgs;
+            //!< Maximum size in MB of queued outgoing messages of a connection. The connection is closed, if it is
+            //!< exceeded. 0 - no limit.
+            unsigned int m_writeQueueMaxSize;
+            //!< Max time in microseconds an accumulated protocol message can be held back to be sent in a batch.
+            //!< 0 - no delay.
+            unsigned int m_coalescingMaxLatency;
+            //!< Accumulated protocol messages are sent once the batch reaches this size in bytes.
+            unsigned int m_coalescingMaxBatchBytes;
+            //!< Max time in microseconds an accumulated key update can be held back. 0 - no delay.
+            unsigned int m_updateKeyCoalescingMaxLatency;
+            //!< Accumulated key updates are sent once the batch reaches this size in bytes.
+            unsigned int m_updateKeyCoalescingMaxBatchBytes;
+            //!< Minimal interval in ms between reports of agents' replies to UI clients. 0 reports each reply.
+            unsigned int m_uiReportInterval;
+            //!< If false, UI clients get only errors and the progress of agents' replies, but not a message per reply.
+            bool m_uiAgentMessages;
 
         } SDDSGeneralOptions_t;
 
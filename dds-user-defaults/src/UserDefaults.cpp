@@ -92,6 +92,53 @@ void CUserDefaults::init(const string& _cfgFileName, bool _get_default)
     config_file_options.add_options()(
         "server.data_retention",
         boost::program_options::value<unsigned int>(&m_options.m_server.m_dataRetention)->default_value(7));
+    config_file_options.add_options()(
+        "server.compression_level",
+        boost::program_options::value<unsigned int>(&m_options.m_server.m_compressionLevel)->default_value(1));
+    config_file_options.add_options()(
+        "server.compression_threshold",
+        boost::program_options::value<unsigned int>(&m_options.m_server.m_compressionThreshold)->default_value(4096));
+    config_file_options.add_options()(
+        "server.io_context_per_thread",
+        boost::program_options::value<bool>(&m_options.m_server.m_ioContextPerThread)->default_value(false));
+    config_file_options.add_options()(
+        "server.write_queue_high_watermark",
+        boost::program_options::value<unsigned int>(&m_options.m_server.m_writeQueueHighWatermark)->default_value(32));
+    config_file_options.add_options()(
+        "server.write_queue_low_watermark",
+        boost::program_options::value<unsigned int>(&m_options.m_server.m_writeQueueLowWatermark)->default_value(16));
+    config_file_options.add_options()(
+        "server.write_queue_high_watermark_msgs",
+        boost::program_options::value<unsigned int>(&m_options.m_server.m_writeQueueHighWatermarkMsgs)
+            ->default_value(100000));
+    config_file_options.add_options()(
+        "server.write_queue_low_watermark_msgs",
+        boost::program_options::value<unsigned int>(&m_options.m_server.m_writeQueueLowWatermarkMsgs)
+            ->default_value(50000));
+    config_file_options.add_options()(
+        "server.write_queue_max_size",
+        boost::program_options::value<unsigned int>(&m_options.m_server.m_writeQueueMaxSize)->default_value(512));
+    config_file_options.add_options()(
+        "server.coalescing_max_latency",
+        boost::program_options::value<unsigned int>(&m_options.m_server.m_coalescingMaxLatency)->default_value(10000));
+    config_file_options.add_options()(
+        "server.coalescing_max_batch_bytes",
+        boost::program_options::value<unsigned int>(&m_options.m_server.m_coalescingMaxBatchBytes)
+            ->default_value(65536));
+    config_file_options.add_options()(
+        "server.update_key_coalescing_max_latency",
+        boost::program_options::value<unsigned int>(&m_options.m_server.m_updateKeyCoalescingMaxLatency)
+            ->default_value(10000));
+    config_file_options.add_options()(
+        "server.update_key_coalescing_max_batch_bytes",
+        boost::program_options::value<unsigned int>(&m_options.m_server.m_updateKeyCoalescingMaxBatchBytes)
+            ->default_value(65536));
+    config_file_options.add_options()(
+        "server.ui_report_interval",
+        boost::program_options::value<unsigned int>(&m_options.m_server.m_uiReportInterval)->default_value(100));
+    config_file_options.add_options()(
+        "server.ui_agent_messages",
+        boost::program_options::value<bool>(&m_options.m_server.m_uiAgentMessages)->default_value(true));
     config_file_options.add_options()(
         "agent.work_dir", boost::program_options::value<string>(&m_options.m_agent.m_workDir)->default_value(""), "");
     // default is "-rw-rw----", i.e. 0660
@@ -232,6 +279,48 @@ void CUserDefaults::printDefaults(ostream& _stream)
             << "# Defines a number of days to keep DDS sessions.\n"
             << "# Not running sessions older than the specified number of days will be auto deleted.\n"
             << "data_retention=" << ud.getDefaultValueForKey("server.data_retention") << "\n"
+            << "#\n"
+            << "# Protocol messages bigger than compression_threshold bytes are compressed with zlib,\n"
+            << "# if both ends of the connection support it.\n"
+            << "# compression_level is from 1 (fastest) to 9 (best). Set it to 0 to disable the compression.\n"
+            << "compression_level=" << ud.getDefaultValueForKey("server.compression_level") << "\n"
+            << "compression_threshold=" << ud.getDefaultValueForKey("server.compression_threshold") << "\n"
+            << "#\n"
+            << "# If true, the transport engine of the commander runs one io_context per thread.\n"
+            << "# Connections are distributed among them round-robin, thus handlers of a connection stay on one thread.\n"
+            << "# It reduces the contention of big deployments with thousands of agents.\n"
+            << "io_context_per_thread=" << ud.getDefaultValueForKey("server.io_context_per_thread") << "\n"
+            << "#\n"
+            << "# A connection becomes congested, once its queued outgoing messages reach\n"
+            << "# write_queue_high_watermark MB or write_queue_high_watermark_msgs messages.\n"
+            << "# It recovers at the low watermarks. Broadcasts serve congested connections last,\n"
+            << "# skippable messages like progress reports are dropped for them.\n"
+            << "# A connection is closed, if its queued messages exceed write_queue_max_size MB.\n"
+            << "# Set it to 0 for no limit.\n"
+            << "write_queue_high_watermark=" << ud.getDefaultValueForKey("server.write_queue_high_watermark") << "\n"
+            << "write_queue_low_watermark=" << ud.getDefaultValueForKey("server.write_queue_low_watermark") << "\n"
+            << "write_queue_high_watermark_msgs=" << ud.getDefaultValueForKey("server.write_queue_high_watermark_msgs")
+            << "\n"
+            << "write_queue_low_watermark_msgs=" << ud.getDefaultValueForKey("server.write_queue_low_watermark_msgs")
+            << "\n"
+            << "write_queue_max_size=" << ud.getDefaultValueForKey("server.write_queue_max_size") << "\n"
+            << "#\n"
+            << "# Accumulated messages, like key updates and task done notifications, are sent in batches.\n"
+            << "# A batch is sent once it reaches coalescing_max_batch_bytes bytes or its first message\n"
+            << "# was held back for coalescing_max_latency microseconds. Set the latency to 0 to send without delay.\n"
+            << "# The update_key_* options define the same for key updates.\n"
+            << "coalescing_max_latency=" << ud.getDefaultValueForKey("server.coalescing_max_latency") << "\n"
+            << "coalescing_max_batch_bytes=" << ud.getDefaultValueForKey("server.coalescing_max_batch_bytes") << "\n"
+            << "update_key_coalescing_max_latency="
+            << ud.getDefaultValueForKey("server.update_key_coalescing_max_latency") << "\n"
+            << "update_key_coalescing_max_batch_bytes="
+            << ud.getDefaultValueForKey("server.update_key_coalescing_max_batch_bytes") << "\n"
+            << "#\n"
+            << "# Replies of agents are reported to UI clients at most once per ui_report_interval milliseconds.\n"
+            << "# Messages and the progress of an interval are sent together. Set it to 0 to report each reply.\n"
+            << "# If ui_agent_messages is false, only errors and the progress are reported, not a message per agent.\n"
+            << "ui_report_interval=" << ud.getDefaultValueForKey("server.ui_report_interval") << "\n"
+            << "ui_agent_messages=" << ud.getDefaultValueForKey("server.ui_agent_messages") << "\n"
             << "\n\n[agent]\n"
             << "# This option can help to relocate the work directory of agents.\n"
             << "# The option is ignored by the localhost and ssh plug-ins.\n"
@@ -386,6 +475,14 @@ string CUserDefaults::getServerInfoFileLocation() const
     return val;
 }
 
+string CUserDefaults::getUISocketFileLocation() const
+{
+    string sWrkDir(getValueForKey("server.work_dir"));
+    smart_path(&sWrkDir);
+    smart_append(&sWrkDir, '/');
+    return (sWrkDir + "ui.sock");
+}
+
 string CUserDefaults::getWrkPkgRootDir() const
 {
     string sSandboxDir;
@@ -769,3 +866,10 @@ std::string CUserDefaults::getSlotsRootDir() const
     pathWrkDir /= "slots";
     return pathWrkDir.string();
 }
+
+std::string CUserDefaults::getFileCacheDir() const
+{
+    boost::filesystem::path pathWrkDir(CUserDefaults::getDDSPath());
+    pathWrkDir /= "file_cache";
+    return pathWrkDir.string();
+}
@@ -53,6 +53,7 @@ namespace dds
             std::string getServerInfoFileLocationSrv() const;
             std::string getServerInfoFileName() const;
             std::string getServerInfoFileLocation() const;
+            std::string getUISocketFileLocation() const;
             std::string getWrkPkgRootDir() const;
             std::string getWrkPkgDir(const std::string& _SubmissionID) const;
             std::string getWrkPkgPath(const std::string& _SubmissionID) const;
@@ -84,6 +85,8 @@ namespace dds
             bool isAgentInstance() const;
             static size_t getNumLeaderFW(); // Number of SM agent outputs
             std::string getSlotsRootDir() const;
+            /// Files uploaded to the agent by their content hash, kept across topology updates
+            std::string getFileCacheDir() const;
 
             /// \brief Returns path to the plugin's directory for specified plug-in name.
             /// \param[in] _path Path to the root plug-ins directory. If not specified (i.e. empty string is provided)